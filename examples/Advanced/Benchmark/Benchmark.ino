@@ -0,0 +1,385 @@
+/*
+  Benchmarking the library against a simulated module
+  By: SparkFun Electronics
+
+  No RFID hardware needed! This sketch connects the library to RFID_Simulator, a Stream
+  that behaves like a ThingMagic module streaming tags, and reports:
+
+    Link test - frames/s, tags/s and bytes/s while continuously reading at the chosen baud rate,
+                with the full metadata set and with RSSI only
+    Buffered test - tags/s when the module searches first and the tags come over in bulk
+    Commission test - tags/minute writing user memory and a new EPC to a tag, with writes
+                split into 2 word blocks so nothing relies on a write going over in one piece
+    CPU test  - nanoseconds of check() + parseResponse() per tag, with the serial link taken
+                out of the picture by replaying pre-built frames from RAM
+    CRC test  - the library's CRC engine against the original nibble-at-a-time version
+
+  Run it on each release to spot tag-rate regressions. The sketch only needs a Stream, so
+  it also runs on a host that provides Arduino.h.
+*/
+
+// Library for controlling the RFID module
+#include "SparkFun_UHF_RFID_Reader.h"
+#include "SparkFun_UHF_RFID_Simulator.h"
+#include "SparkFun_UHF_RFID_Commissioner.h"
+
+// Create instances of the library and of the pretend module it talks to
+RFID rfidModule;
+RFID_Simulator simulatedModule;
+
+// Settings for the link test
+#define rfidBaud 115200       // Baud rate the simulated link runs at
+#define tagPopulation 50      // Number of tags in the simulated field
+#define testDuration 5000     // How long each test runs, in ms
+#define lineErrors 0          // Corrupted bytes per million, to exercise resynchronisation
+
+// Settings for the buffered test
+#define bufferedTags 500      // Number of tags in the field
+#define searchTime 500        // How long each buffered search runs, in ms
+
+// Settings for the commission test
+#define commissionRounds 20   // Number of times the tag is commissioned, each time with a new EPC
+
+// Settings for the CPU test
+#define replayFrames 8        // Number of distinct frames kept in RAM for replay
+#define cpuTestTags 20000UL   // Number of tag records to push through the parser
+
+// Settings for the CRC test
+#define crcTestRounds 2000UL  // Number of tag-record-sized buffers to CRC
+
+// Stream that endlessly replays a block of frames from RAM. Reading from it costs next to
+// nothing, so the time measured is the library's own work.
+class ReplayStream : public Stream
+{
+public:
+  uint8_t buffer[replayFrames * 64];
+  uint16_t length = 0;
+  uint16_t spot = 0;
+
+  int available() { return (length); }
+  int read()
+  {
+    uint8_t value = buffer[spot++];
+    if (spot == length) spot = 0;
+    return (value);
+  }
+  int peek() { return (buffer[spot]); }
+  size_t write(uint8_t) { return (1); }
+};
+
+ReplayStream replay;
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial); //Wait for the serial port to come online
+
+  Serial.println(F("RFID library benchmark"));
+
+  if (connectSimulator() == true)
+  {
+    linkTest(RFID_ReadConfig(), F("full metadata"));
+    linkTest(RFID_ReadConfig().setMetadata(TMR_TRD_METADATA_FLAG_RSSI), F("RSSI only"));
+    bufferedTest();
+    commissionTest();
+  }
+  else
+    Serial.println(F("Simulated module failed to respond"));
+
+  cpuTest();
+  crcTest();
+
+  Serial.println(F("Done"));
+}
+
+void loop()
+{
+}
+
+// Bring up the link to the simulated module
+boolean connectSimulator()
+{
+  simulatedModule.begin(115200); //Modules power up at 115200
+  simulatedModule.setTagPopulation(tagPopulation);
+  simulatedModule.setErrorRate(lineErrors);
+
+  rfidModule.begin(simulatedModule);
+
+  if (rfidBaud != 115200)
+  {
+    rfidModule.setBaud(rfidBaud);
+    simulatedModule.begin(rfidBaud);
+    delay(250); //Give the module time to switch over
+  }
+
+  rfidModule.getVersion();
+  if (rfidModule.msg[0] != ALL_GOOD)
+    return false;
+
+  rfidModule.setTagProtocol();
+  rfidModule.setAntennaPort();
+  rfidModule.setRegion(REGION_NORTHAMERICA);
+  return true;
+}
+
+// Continuous read over a baud rate limited link
+void linkTest(const RFID_ReadConfig &config, const __FlashStringHelper *label)
+{
+  simulatedModule.setTagPopulation(tagPopulation);
+  rfidModule.startReading(config);
+
+  rfidModule.resetReceiveCounters();
+  uint32_t bytesAtStart = simulatedModule.getBytesSent();
+  uint32_t frames = 0;
+  uint32_t tags = 0;
+  uint32_t badFrames = 0;
+
+  uint32_t startTime = millis();
+  while (millis() - startTime < testDuration)
+  {
+    if (rfidModule.check() == true)
+    {
+      frames++;
+
+      byte responseType = rfidModule.parseResponse();
+      if (responseType == RESPONSE_IS_TAGFOUND)
+        tags++;
+      else if (responseType == ERROR_CORRUPT_RESPONSE)
+        badFrames++;
+    }
+  }
+  uint32_t elapsed = millis() - startTime;
+  uint32_t bytes = simulatedModule.getBytesSent() - bytesAtStart;
+  uint32_t rejectedFrames = rfidModule.getRejectedFrames();
+  uint32_t discardedBytes = rfidModule.getDiscardedBytes();
+
+  rfidModule.stopReading();
+
+  Serial.print(F("Link test @ "));
+  Serial.print((long)rfidBaud);
+  Serial.print(F("bps, "));
+  Serial.print(tagPopulation);
+  Serial.print(F(" tags in the field, "));
+  Serial.println(label);
+
+  Serial.print(F("  frames/s: "));
+  Serial.println(frames * 1000.0 / elapsed);
+  Serial.print(F("  tags/s: "));
+  Serial.println(tags * 1000.0 / elapsed);
+  Serial.print(F("  bytes/s: "));
+  Serial.println(bytes * 1000.0 / elapsed);
+  Serial.print(F("  corrupt frames: "));
+  Serial.println(badFrames);
+  Serial.print(F("  rejected frames: "));
+  Serial.println(rejectedFrames);
+  Serial.print(F("  bytes discarded resyncing: "));
+  Serial.println(discardedBytes);
+}
+
+// Timed searches with the tags pulled from the module's buffer, many per frame
+void bufferedTest()
+{
+  simulatedModule.setTagPopulation(bufferedTags);
+
+  uint32_t bytesAtStart = simulatedModule.getBytesSent();
+  uint32_t searches = 0;
+  uint32_t tags = 0;
+  uint32_t transferTime = 0;
+
+  uint32_t startTime = millis();
+  while (millis() - startTime < testDuration)
+  {
+    if (rfidModule.readTagsBuffered(searchTime) != RESPONSE_SUCCESS)
+    {
+      Serial.println(F("Buffered search failed"));
+      return;
+    }
+    searches++;
+
+    uint32_t transferStart = millis();
+    while (rfidModule.nextBufferedTag() == true)
+      tags++;
+    transferTime += millis() - transferStart;
+  }
+  uint32_t elapsed = millis() - startTime;
+  uint32_t bytes = simulatedModule.getBytesSent() - bytesAtStart;
+
+  Serial.print(F("Buffered test: "));
+  Serial.print(bufferedTags);
+  Serial.print(F(" tags in the field, "));
+  Serial.print(searchTime);
+  Serial.println(F("ms searches"));
+
+  Serial.print(F("  searches: "));
+  Serial.println(searches);
+  Serial.print(F("  tags/s overall: "));
+  Serial.println(tags * 1000.0 / elapsed);
+  Serial.print(F("  tags/s while transferring: "));
+  Serial.println(transferTime ? tags * 1000.0 / transferTime : 0);
+  Serial.print(F("  bytes/tag: "));
+  Serial.println(tags ? (float)bytes / tags : 0);
+}
+
+// Commission the simulated tag over and over, each job finding it by the EPC the last one wrote
+void commissionTest()
+{
+  simulatedModule.setTagPopulation(1); //Tag 0 is the one with writable memory
+
+  uint8_t epc[12];
+  uint8_t epcLength = sizeof(epc);
+  if (rfidModule.readTagEPC(epc, epcLength) != RESPONSE_SUCCESS || epcLength != sizeof(epc))
+  {
+    Serial.println(F("Commission test: tag not found"));
+    return;
+  }
+
+  uint8_t blockWriteSize = rfidModule.getBlockWriteSize();
+  rfidModule.setBlockWriteSize(2); //Every write longer than 2 words goes over in pieces
+
+  uint8_t userData[16];
+  for (uint8_t x = 0; x < sizeof(userData); x++)
+    userData[x] = x;
+
+  RFID_Commissioner commissioner(rfidModule);
+  uint16_t done = 0;
+  uint16_t failed = 0;
+  uint32_t startTime = millis();
+  for (uint16_t round = 0; round < commissionRounds; round++)
+  {
+    uint8_t newEPC[12];
+    memcpy(newEPC, epc, sizeof(newEPC));
+    newEPC[10] = round >> 8;
+    newEPC[11] = round & 0xFF;
+
+    RFID_CommissionJob job;
+    job.setTarget(RFID_TagFilter().setEPC(epc, sizeof(epc)));
+    job.setUserData(userData, sizeof(userData));
+    job.setEPC(newEPC, sizeof(newEPC));
+
+    commissioner.begin(&job, 1);
+    while (commissioner.process() == true)
+      ;
+
+    if (job.state == RFID_JOB_DONE)
+    {
+      done++;
+      memcpy(epc, newEPC, sizeof(epc));
+    }
+    else
+      failed++;
+  }
+  uint32_t elapsed = millis() - startTime;
+
+  //The tag should answer with the EPC the last job wrote
+  rfidModule.clearTagFilter();
+  uint8_t readBack[12];
+  uint8_t readLength = sizeof(readBack);
+  boolean epcGood = (rfidModule.readTagEPC(readBack, readLength) == RESPONSE_SUCCESS &&
+                     readLength == sizeof(readBack) && memcmp(readBack, epc, sizeof(epc)) == 0);
+
+  rfidModule.setBlockWriteSize(blockWriteSize);
+
+  Serial.print(F("Commission test: "));
+  Serial.print(commissionRounds);
+  Serial.println(F(" jobs, 2 word block writes"));
+  Serial.print(F("  done: "));
+  Serial.println(done);
+  Serial.print(F("  failed: "));
+  Serial.println(failed);
+  Serial.print(F("  tags/minute: "));
+  Serial.println(elapsed ? done * 60000.0 / elapsed : 0);
+  Serial.print(F("  EPC read back: "));
+  Serial.println(epcGood ? F("matches") : F("WRONG"));
+}
+
+// Raw parsing cost, no link in the way
+void cpuTest()
+{
+  //Pre-build a handful of tag records
+  for (uint8_t x = 0; x < replayFrames; x++)
+  {
+    uint8_t frame[MAX_MSG_SIZE];
+    uint8_t length = simulatedModule.buildTagFrame(frame, x);
+    if (replay.length + length > sizeof(replay.buffer))
+      break;
+    memcpy(&replay.buffer[replay.length], frame, length);
+    replay.length += length;
+  }
+
+  rfidModule.begin(replay);
+
+  uint32_t tags = 0;
+  uint32_t startTime = micros();
+  while (tags < cpuTestTags)
+  {
+    if (rfidModule.check() == true)
+    {
+      if (rfidModule.parseResponse() == RESPONSE_IS_TAGFOUND)
+        tags++;
+    }
+  }
+  uint32_t elapsed = micros() - startTime;
+
+  Serial.println(F("CPU test: check() + parseResponse()"));
+  Serial.print(F("  ns per tag: "));
+  Serial.println(elapsed * 1000.0 / tags);
+  Serial.print(F("  tags/s of CPU: "));
+  Serial.println(tags * 1000000.0 / elapsed);
+}
+
+// The CRC as it was originally done, a nibble at a time with a 16 entry table
+static const uint16_t nibbleTable[] = {0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+                                       0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef};
+
+uint16_t nibbleCRC(uint8_t *u8Buf, uint8_t len)
+{
+  uint16_t crc = 0xFFFF;
+
+  for (uint8_t i = 0; i < len; i++)
+  {
+    crc = ((crc << 4) | (u8Buf[i] >> 4)) ^ nibbleTable[crc >> 12];
+    crc = ((crc << 4) | (u8Buf[i] & 0x0F)) ^ nibbleTable[crc >> 12];
+  }
+
+  return crc;
+}
+
+// Byte-wise (or slice-by-4) table CRC against the nibble version
+void crcTest()
+{
+  uint8_t frame[MAX_MSG_SIZE];
+  uint8_t length = simulatedModule.buildTagFrame(frame, 1);
+  uint8_t crcLength = length - 3; //What the library CRCs: everything but the header and the CRC itself
+
+  if (nibbleCRC(&frame[1], crcLength) != RFID::calculateCRC(&frame[1], crcLength))
+  {
+    Serial.println(F("CRC test: engines disagree!"));
+    return;
+  }
+
+  volatile uint16_t sink = 0; //Keeps the compiler from optimizing the loops away
+
+  uint32_t startTime = micros();
+  for (uint32_t x = 0; x < crcTestRounds; x++)
+  {
+    frame[2] = x; //Vary the input a little
+    sink ^= nibbleCRC(&frame[1], crcLength);
+  }
+  uint32_t nibbleTime = micros() - startTime;
+
+  startTime = micros();
+  for (uint32_t x = 0; x < crcTestRounds; x++)
+  {
+    frame[2] = x;
+    sink ^= RFID::calculateCRC(&frame[1], crcLength);
+  }
+  uint32_t tableTime = micros() - startTime;
+
+  Serial.print(F("CRC test: "));
+  Serial.print(crcLength);
+  Serial.println(F(" byte tag record"));
+  Serial.print(F("  nibble table ns/byte: "));
+  Serial.println(nibbleTime * 1000.0 / (crcTestRounds * crcLength));
+  Serial.print(F("  library ns/byte: "));
+  Serial.println(tableTime * 1000.0 / (crcTestRounds * crcLength));
+}
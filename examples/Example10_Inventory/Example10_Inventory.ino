@@ -0,0 +1,187 @@
+/*
+  Keeping an inventory of every tag heard
+  By: SparkFun Electronics
+
+  Constantly reads and keeps one entry per unique tag: when it was first and last seen,
+  how many times it was read, and its min/mean/max RSSI. Announces each new tag as it
+  arrives and prints the whole inventory every few seconds.
+
+  The inventory is a fixed size hash table, so checking if a tag is new takes the same
+  time whether 5 or 500 tags are in the field.
+
+  If using the Simultaneous RFID Tag Reader (SRTR) shield, make sure the serial slide
+  switch is in the 'SW-UART' position
+*/
+
+// Library for controlling the RFID module
+#include "SparkFun_UHF_RFID_Reader.h"
+#include "SparkFun_UHF_RFID_Inventory.h"
+
+// Create instance of the RFID module
+RFID rfidModule;
+
+// Room for up to 64 unique tags. Must be a power of two. Each entry takes about 30 bytes
+// of RAM, so go easy on an Uno.
+RFID_Inventory<64> inventory;
+
+// By default, this example assumes software serial. If your platform does not
+// support software serial, you can use hardware serial by commenting out these
+// lines and changing the rfidSerial definition below
+#include <SoftwareSerial.h>
+SoftwareSerial softSerial(2, 3); //RX, TX
+
+// Here you can specify which serial port the RFID module is connected to. This
+// will be different on most platforms, so check what is needed for yours and
+// adjust the definition as needed. Some examples are provided below
+#define rfidSerial softSerial // Software serial (eg. Arudino Uno or SparkFun RedBoard)
+// #define rfidSerial Serial1 // Hardware serial (eg. ESP32 or Teensy)
+
+// Here you can select the baud rate for the module. 38400 is recommended if
+// using software serial, and 115200 if using hardware serial.
+#define rfidBaud 38400
+// #define rfidBaud 115200
+
+// Here you can select which module you are using. This library was originally
+// written for the M6E Nano only, and that is the default if the module is not
+// specified. Support for the M7E Hecto has since been added, which can be
+// selected below
+#define moduleType ThingMagic_M6E_NANO
+// #define moduleType ThingMagic_M7E_HECTO
+
+#define reportInterval 5000 //ms between inventory printouts
+
+unsigned long lastReport = 0;
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial); //Wait for the serial port to come online
+
+  if (setupRfidModule(rfidBaud) == false)
+  {
+    Serial.println(F("Module failed to respond. Please check wiring."));
+    while (1); //Freeze!
+  }
+
+  rfidModule.setRegion(REGION_NORTHAMERICA); //Set to North America
+
+  rfidModule.setReadPower(500); //5.00 dBm. Higher values may caues USB port to brown out
+  //Max Read TX Power is 27.00 dBm and may cause temperature-limit throttling
+
+  rfidModule.startReading(); //Begin scanning for tags
+}
+
+void loop()
+{
+  if (rfidModule.check() == true) //Check to see if any new data has come in from module
+  {
+    if (rfidModule.parseResponse() == RESPONSE_IS_TAGFOUND)
+    {
+      RFID_InventoryEntry *tag = inventory.add(rfidModule.getTagRecord());
+
+      if (tag == NULL)
+      {
+        Serial.println(F("Inventory is full!"));
+      }
+      else if (tag->readCount == 1)
+      {
+        Serial.print(F("New tag: "));
+        printEPC(tag);
+        Serial.println();
+      }
+    }
+  }
+
+  if (millis() - lastReport > reportInterval)
+  {
+    lastReport = millis();
+    printInventory();
+  }
+}
+
+void printEPC(const RFID_InventoryEntry *tag)
+{
+  for (byte x = 0 ; x < tag->epcLength ; x++)
+  {
+    if (tag->epc[x] < 0x10) Serial.print(F("0")); //Pretty print
+    Serial.print(tag->epc[x], HEX);
+    Serial.print(F(" "));
+  }
+}
+
+void printInventory()
+{
+  Serial.print(inventory.getCount());
+  Serial.println(F(" unique tags"));
+
+  for (uint16_t slot = 0 ; slot < inventory.getCapacity() ; slot++)
+  {
+    const RFID_InventoryEntry *tag = inventory.getEntry(slot);
+    if (tag == NULL) continue; //Empty slot
+
+    Serial.print(F(" epc["));
+    printEPC(tag);
+    Serial.print(F("] reads["));
+    Serial.print(tag->readCount);
+    Serial.print(F("] rssi["));
+    Serial.print(tag->rssiMin);
+    Serial.print(F("/"));
+    Serial.print(tag->getMeanRSSI());
+    Serial.print(F("/"));
+    Serial.print(tag->rssiMax);
+    Serial.print(F("] last seen["));
+    Serial.print((millis() - tag->lastSeen) / 1000);
+    Serial.println(F("s ago]"));
+  }
+}
+
+//Gracefully handles a reader that is already configured and already reading continuously
+//Because Stream does not have a .begin() we have to do this outside the library
+boolean setupRfidModule(long baudRate)
+{
+  rfidModule.begin(rfidSerial, moduleType); //Tell the library to communicate over serial port
+
+  //Test to see if we are already connected to a module
+  //This would be the case if the Arduino has been reprogrammed and the module has stayed powered
+  rfidSerial.begin(baudRate); //For this test, assume module is already at our desired baud rate
+  delay(100); //Wait for port to open
+
+  //About 200ms from power on the module will send its firmware version at 115200. We need to ignore this.
+  while (rfidSerial.available())
+    rfidSerial.read();
+
+  rfidModule.getVersion();
+
+  if (rfidModule.msg[0] == ERROR_WRONG_OPCODE_RESPONSE)
+  {
+    //This happens if the baud rate is correct but the module is doing a ccontinuous read
+    rfidModule.stopReading();
+
+    Serial.println(F("Module continuously reading. Asking it to stop..."));
+
+    delay(1500);
+  }
+  else
+  {
+    //The module did not respond so assume it's just been powered on and communicating at 115200bps
+    rfidSerial.begin(115200); //Start serial at 115200
+
+    rfidModule.setBaud(baudRate); //Tell the module to go to the chosen baud rate. Ignore the response msg
+
+    rfidSerial.begin(baudRate); //Start the serial port, this time at user's chosen baud rate
+
+    delay(250);
+  }
+
+  //Test the connection
+  rfidModule.getVersion();
+  if (rfidModule.msg[0] != ALL_GOOD)
+    return false; //Something is not right
+
+  //The module has these settings no matter what
+  rfidModule.setTagProtocol(); //Set protocol to GEN2
+
+  rfidModule.setAntennaPort(); //Set TX/RX antenna ports to 1
+
+  return true; //We are ready to rock
+}
@@ -0,0 +1,153 @@
+/*
+  Sending commands without stopping to wait for the answer
+  By: SparkFun Electronics
+
+  Reads tags constantly while blinking GPIO pin 2 of the module once a second. The
+  digitalWrite() style calls wait up to 2 seconds for the module to answer, and nothing
+  else happens meanwhile. sendMessageAsync() returns right away instead, and update()
+  collects the answer along with the tag records, then calls us back with the result.
+
+  If using the Simultaneous RFID Tag Reader (SRTR) shield, make sure the serial slide
+  switch is in the 'SW-UART' position
+*/
+
+// Library for controlling the RFID module
+#include "SparkFun_UHF_RFID_Reader.h"
+
+// Create instance of the RFID module
+RFID rfidModule;
+
+// By default, this example assumes software serial. If your platform does not
+// support software serial, you can use hardware serial by commenting out these
+// lines and changing the rfidSerial definition below
+#include <SoftwareSerial.h>
+SoftwareSerial softSerial(2, 3); //RX, TX
+
+// Here you can specify which serial port the RFID module is connected to. This
+// will be different on most platforms, so check what is needed for yours and
+// adjust the definition as needed. Some examples are provided below
+#define rfidSerial softSerial // Software serial (eg. Arudino Uno or SparkFun RedBoard)
+// #define rfidSerial Serial1 // Hardware serial (eg. ESP32 or Teensy)
+
+// Here you can select the baud rate for the module. 38400 is recommended if
+// using software serial, and 115200 if using hardware serial.
+#define rfidBaud 38400
+// #define rfidBaud 115200
+
+// Here you can select which module you are using. This library was originally
+// written for the M6E Nano only, and that is the default if the module is not
+// specified. Support for the M7E Hecto has since been added, which can be
+// selected below
+#define moduleType ThingMagic_M6E_NANO
+// #define moduleType ThingMagic_M7E_HECTO
+
+uint8_t outputPin = 2; //GPIO on the module: 1, 2, 3 or 4
+uint8_t outputState = LOW;
+
+unsigned long lastToggle = 0;
+unsigned long tagsRead = 0;
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial); //Wait for the serial port to come online
+
+  if (setupRfidModule(rfidBaud) == false)
+  {
+    Serial.println(F("Module failed to respond. Please check wiring."));
+    while (1); //Freeze!
+  }
+
+  rfidModule.setRegion(REGION_NORTHAMERICA); //Set to North America
+
+  rfidModule.setReadPower(500); //5.00 dBm. Higher values may caues USB port to brown out
+  //Max Read TX Power is 27.00 dBm and may cause temperature-limit throttling
+
+  rfidModule.pinMode(outputPin, ThingMagic_PinMode_OUTPUT);
+
+  rfidModule.startReading(); //Begin scanning for tags
+}
+
+void loop()
+{
+  //update() moves bytes in both directions. Call it as often as possible.
+  if (rfidModule.update() == true)
+  {
+    if (rfidModule.parseResponse() == RESPONSE_IS_TAGFOUND)
+      tagsRead++;
+  }
+
+  if (millis() - lastToggle > 500 && rfidModule.isCommandPending() == false)
+  {
+    lastToggle = millis();
+    outputState = !outputState;
+
+    uint8_t data[] = {outputPin, outputState}; //Same as RFID::digitalWrite()
+    rfidModule.sendMessageAsync(TMR_SR_OPCODE_SET_USER_GPIO_OUTPUTS, data, sizeof(data), commandDone);
+  }
+}
+
+//Called by update() once the module answers, or the command times out
+void commandDone(const RFID_CommandResult &result)
+{
+  Serial.print(F("GPIO "));
+  if (result.error == ALL_GOOD && result.status == 0x0000)
+    Serial.print(F("set"));
+  else
+    Serial.print(F("failed"));
+  Serial.print(F(" in "));
+  Serial.print(result.latency);
+  Serial.print(F("ms, tags read so far: "));
+  Serial.println(tagsRead);
+}
+
+//Gracefully handles a reader that is already configured and already reading continuously
+//Because Stream does not have a .begin() we have to do this outside the library
+boolean setupRfidModule(long baudRate)
+{
+  rfidModule.begin(rfidSerial, moduleType); //Tell the library to communicate over serial port
+
+  //Test to see if we are already connected to a module
+  //This would be the case if the Arduino has been reprogrammed and the module has stayed powered
+  rfidSerial.begin(baudRate); //For this test, assume module is already at our desired baud rate
+  delay(100); //Wait for port to open
+
+  //About 200ms from power on the module will send its firmware version at 115200. We need to ignore this.
+  while (rfidSerial.available())
+    rfidSerial.read();
+
+  rfidModule.getVersion();
+
+  if (rfidModule.msg[0] == ERROR_WRONG_OPCODE_RESPONSE)
+  {
+    //This happens if the baud rate is correct but the module is doing a ccontinuous read
+    rfidModule.stopReading();
+
+    Serial.println(F("Module continuously reading. Asking it to stop..."));
+
+    delay(1500);
+  }
+  else
+  {
+    //The module did not respond so assume it's just been powered on and communicating at 115200bps
+    rfidSerial.begin(115200); //Start serial at 115200
+
+    rfidModule.setBaud(baudRate); //Tell the module to go to the chosen baud rate. Ignore the response msg
+
+    rfidSerial.begin(baudRate); //Start the serial port, this time at user's chosen baud rate
+
+    delay(250);
+  }
+
+  //Test the connection
+  rfidModule.getVersion();
+  if (rfidModule.msg[0] != ALL_GOOD)
+    return false; //Something is not right
+
+  //The module has these settings no matter what
+  rfidModule.setTagProtocol(); //Set protocol to GEN2
+
+  rfidModule.setAntennaPort(); //Set TX/RX antenna ports to 1
+
+  return true; //We are ready to rock
+}
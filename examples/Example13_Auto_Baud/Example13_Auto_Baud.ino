@@ -0,0 +1,85 @@
+/*
+  Finding the fastest baud rate the wiring can carry
+  By: SparkFun Electronics
+
+  Modules power up at 115200bps. autoBaud() moves the module and the Arduino up one
+  supported rate at a time, checking each step with a burst of version requests. The first
+  rate that loses a byte or fails a CRC is undone, and both ends are left at the fastest
+  rate that came through clean. Long wires, level shifters and noisy supplies all lower it.
+
+  Software serial tops out well below 115200, so this example needs a hardware serial port.
+  If using the Simultaneous RFID Tag Reader (SRTR) shield, make sure the serial slide
+  switch is in the 'HW-UART' position
+*/
+
+// Library for controlling the RFID module
+#include "SparkFun_UHF_RFID_Reader.h"
+
+// Create instance of the RFID module
+RFID rfidModule;
+
+// Here you can specify which serial port the RFID module is connected to. This
+// will be different on most platforms, so check what is needed for yours and
+// adjust the definition as needed
+#define rfidSerial Serial1 // Hardware serial (eg. ESP32 or Teensy)
+
+// Here you can select the fastest baud rate to try. 921600 is the most the modules support.
+#define maxBaud 921600
+
+// Here you can select which module you are using. This library was originally
+// written for the M6E Nano only, and that is the default if the module is not
+// specified. Support for the M7E Hecto has since been added, which can be
+// selected below
+#define moduleType ThingMagic_M6E_NANO
+// #define moduleType ThingMagic_M7E_HECTO
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial); //Wait for the serial port to come online
+
+  rfidModule.begin(rfidSerial, moduleType); //Tell the library to communicate over serial port
+
+  rfidSerial.begin(115200); //Modules power up at 115200
+  delay(250); //Wait for the module to boot and send its power up message
+
+  //About 200ms from power on the module will send its firmware version at 115200. We need to ignore this.
+  while (rfidSerial.available())
+    rfidSerial.read();
+
+  long baudRate = rfidModule.autoBaud(115200, setHostBaud, maxBaud);
+  if (baudRate == 0)
+  {
+    Serial.println(F("Module failed to respond. Please check wiring."));
+    while (1); //Freeze!
+  }
+
+  Serial.print(F("Module and Arduino are now talking at "));
+  Serial.print(baudRate);
+  Serial.println(F("bps"));
+
+  rfidModule.setTagProtocol(); //Set protocol to GEN2
+  rfidModule.setAntennaPort(); //Set TX/RX antenna ports to 1
+  rfidModule.setRegion(REGION_NORTHAMERICA); //Set to North America
+  rfidModule.setReadPower(500); //5.00 dBm. Higher values may caues USB port to brown out
+
+  rfidModule.startReading(); //Begin scanning for tags
+}
+
+void loop()
+{
+  if (rfidModule.check() == true)
+  {
+    if (rfidModule.parseResponse() == RESPONSE_IS_TAGFOUND)
+    {
+      Serial.print(F("Tag RSSI: "));
+      Serial.println(rfidModule.getTagRSSI());
+    }
+  }
+}
+
+//autoBaud() calls this every time the Arduino needs to follow the module to a new rate
+void setHostBaud(long baudRate)
+{
+  rfidSerial.begin(baudRate);
+}
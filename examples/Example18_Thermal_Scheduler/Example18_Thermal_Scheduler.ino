@@ -0,0 +1,144 @@
+/*
+  Reading at high power without overheating
+  By: SparkFun Electronics
+
+  At high read power the module heats up. Somewhere around 85C it protects itself by
+  throttling, and the read rate drops to nothing until it cools. RFID_ThermalScheduler
+  watches the temperature trend and, before that happens, lowers the read power a little
+  at a time and, if that isn't enough, rests the RF between read cycles. When there is
+  headroom again it steps back up. Every step is printed along with the temperature, the
+  trend and where the trend is heading.
+
+  Running at high power needs a good power supply. If using the Simultaneous RFID Tag
+  Reader (SRTR) shield, make sure the serial slide switch is in the 'HW-UART' position,
+  and power the board externally rather than from USB.
+*/
+
+// Library for controlling the RFID module
+#include "SparkFun_UHF_RFID_Reader.h"
+#include "SparkFun_UHF_RFID_Thermal.h"
+
+// Create instances of the RFID module and of the scheduler that keeps it cool
+RFID rfidModule;
+RFID_ThermalScheduler scheduler(rfidModule);
+
+// By default, this example assumes hardware serial, since software serial can't keep up
+// with the tags a module at full power reads
+#define rfidSerial Serial1 // Hardware serial (eg. ESP32 or Teensy)
+
+// Here you can select the baud rate for the module
+#define rfidBaud 115200
+
+// Here you can select which module you are using. This library was originally
+// written for the M6E Nano only, and that is the default if the module is not
+// specified. Support for the M7E Hecto has since been added, which can be
+// selected below
+#define moduleType ThingMagic_M6E_NANO
+// #define moduleType ThingMagic_M7E_HECTO
+
+// Here you can select the most read power the scheduler may use
+#define maxPower 2700 // 27.00 dBm
+
+unsigned long tagsRead = 0;
+unsigned long lastReport = 0;
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial); //Wait for the serial port to come online
+
+  if (setupRfidModule(rfidBaud) == false)
+  {
+    Serial.println(F("Module failed to respond. Please check wiring."));
+    while (1); //Freeze!
+  }
+
+  rfidModule.setRegion(REGION_NORTHAMERICA); //Set to North America
+
+  //Tags that arrive while the scheduler reads the temperature come through here
+  rfidModule.setTagCallback(handleResponse);
+
+  Serial.println(F("Press a key to begin scanning for tags."));
+  while (!Serial.available()); //Wait for user to send a character
+  Serial.read(); //Throw away the user's character
+
+  scheduler.enableLogging(Serial); //Print every step the scheduler takes
+  scheduler.begin(RFID_ReadConfig().setMetadata(TMR_TRD_METADATA_FLAG_RSSI), maxPower); //Begin scanning for tags
+}
+
+void loop()
+{
+  if (rfidModule.check() == true) //Check to see if any new data has come in from module
+    handleResponse(rfidModule.parseResponse());
+
+  scheduler.update(); //Reads the temperature every couple of seconds and steps power or duty cycle
+
+  if (millis() - lastReport >= 10000)
+  {
+    lastReport = millis();
+    Serial.print(F("Module at "));
+    Serial.print(scheduler.getTemperature());
+    Serial.print(F("C, "));
+    Serial.print(tagsRead);
+    Serial.println(F(" tags read so far"));
+  }
+}
+
+void handleResponse(uint8_t responseType)
+{
+  if (responseType == RESPONSE_IS_TAGFOUND)
+    tagsRead++;
+
+  scheduler.feed(responseType); //Lets the scheduler know if the module throttled
+}
+
+//Gracefully handles a reader that is already configured and already reading continuously
+//Because Stream does not have a .begin() we have to do this outside the library
+boolean setupRfidModule(long baudRate)
+{
+  rfidModule.begin(rfidSerial, moduleType); //Tell the library to communicate over serial port
+
+  //Test to see if we are already connected to a module
+  //This would be the case if the Arduino has been reprogrammed and the module has stayed powered
+  rfidSerial.begin(baudRate); //For this test, assume module is already at our desired baud rate
+  delay(100); //Wait for port to open
+
+  //About 200ms from power on the module will send its firmware version at 115200. We need to ignore this.
+  while (rfidSerial.available())
+    rfidSerial.read();
+
+  rfidModule.getVersion();
+
+  if (rfidModule.msg[0] == ERROR_WRONG_OPCODE_RESPONSE)
+  {
+    //This happens if the baud rate is correct but the module is doing a ccontinuous read
+    rfidModule.stopReading();
+
+    Serial.println(F("Module continuously reading. Asking it to stop..."));
+
+    delay(1500);
+  }
+  else
+  {
+    //The module did not respond so assume it's just been powered on and communicating at 115200bps
+    rfidSerial.begin(115200); //Start serial at 115200
+
+    rfidModule.setBaud(baudRate); //Tell the module to go to the chosen baud rate. Ignore the response msg
+
+    rfidSerial.begin(baudRate); //Start the serial port, this time at user's chosen baud rate
+
+    delay(250);
+  }
+
+  //Test the connection
+  rfidModule.getVersion();
+  if (rfidModule.msg[0] != ALL_GOOD)
+    return false; //Something is not right
+
+  //The module has these settings no matter what
+  rfidModule.setTagProtocol(); //Set protocol to GEN2
+
+  rfidModule.setAntennaPort(); //Set TX/RX antenna ports to 1
+
+  return true; //We are ready to rock
+}
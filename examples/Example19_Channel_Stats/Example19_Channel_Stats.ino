@@ -0,0 +1,209 @@
+/*
+  Finding the channels that don't work at your site
+  By: SparkFun Electronics
+
+  The module hops between a list of channels, and every tag it reads says which channel
+  it was read on. Interference from other equipment usually sits on a few channels, and
+  there reads fail. The module drops a tag reply that fails its CRC, so a bad channel shows
+  up as one that reads far fewer tags than the rest. This reads tags for a minute, then
+  prints the reads and RSSI of every channel, marking the ones that trail the rest.
+  The badCRC column is records that got past the module damaged, and should stay at 0.
+
+  Press a key once the table is up and the dead channels are dropped from the module's
+  hop table, so it spends its time on the channels where reads succeed. The custom table
+  lasts until the next setRegion() or power cycle.
+
+  If using the Simultaneous RFID Tag Reader (SRTR) shield, make sure the serial slide
+  switch is in the 'HW-UART' position.
+*/
+
+// Library for controlling the RFID module
+#include "SparkFun_UHF_RFID_Reader.h"
+#include "SparkFun_UHF_RFID_ChannelStats.h"
+
+// Create instances of the RFID module and of the per-channel counters
+RFID rfidModule;
+RFID_ChannelStats channels;
+
+// By default, this example assumes hardware serial, since software serial can't keep up
+// with a busy continuous read
+#define rfidSerial Serial1 // Hardware serial (eg. ESP32 or Teensy)
+
+// Here you can select the baud rate for the module
+#define rfidBaud 115200
+
+// Here you can select which module you are using. This library was originally
+// written for the M6E Nano only, and that is the default if the module is not
+// specified. Support for the M7E Hecto has since been added, which can be
+// selected below
+#define moduleType ThingMagic_M6E_NANO
+// #define moduleType ThingMagic_M7E_HECTO
+
+// Here you can select how long to gather reads for
+#define surveyTime 60000 // ms
+
+uint32_t hopTable[RFID_MAX_HOP_CHANNELS];
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial); //Wait for the serial port to come online
+
+  if (setupRfidModule(rfidBaud) == false)
+  {
+    Serial.println(F("Module failed to respond. Please check wiring."));
+    while (1); //Freeze!
+  }
+
+  rfidModule.setRegion(REGION_NORTHAMERICA); //Set to North America
+
+  rfidModule.setReadPower(500); //5.00 dBm. Higher values may cause USB port to brown out
+  //Max Read TX Power is 27.00 dBm and may cause temperature-limit throttling
+
+  //Start the counters from the module's hop table, so channels that never read a tag show up too
+  uint8_t channelCount = RFID_MAX_HOP_CHANNELS;
+  if (rfidModule.getHopTable(hopTable, channelCount) == RESPONSE_SUCCESS)
+    channels.begin(hopTable, channelCount);
+
+  uint32_t hopTime = 0;
+  if (rfidModule.getHopTime(hopTime) == RESPONSE_SUCCESS)
+  {
+    Serial.print(channelCount);
+    Serial.print(F(" channels, "));
+    Serial.print(hopTime);
+    Serial.println(F("ms on each"));
+  }
+
+  Serial.println(F("Press a key to begin scanning for tags."));
+  while (!Serial.available()); //Wait for user to send a character
+  Serial.read(); //Throw away the user's character
+
+  rfidModule.startReading(); //Frequency is part of the default metadata
+
+  unsigned long startTime = millis();
+  while (millis() - startTime < surveyTime)
+  {
+    if (rfidModule.check() == true && rfidModule.parseResponse() == RESPONSE_IS_TAGFOUND)
+      channels.add(rfidModule.getTagRecord());
+  }
+
+  rfidModule.stopReading();
+
+  printChannels();
+
+  Serial.println(F("Press a key to drop the dead channels from the hop table."));
+  while (Serial.available()) Serial.read(); //Throw away anything sent during the survey
+  while (!Serial.available()); //Wait for user to send a character
+  Serial.read();
+
+  uint8_t keep = channels.buildHopTable(hopTable, RFID_MAX_HOP_CHANNELS);
+  if (keep == channels.getCount())
+    Serial.println(F("No dead channels, hop table left alone"));
+  else if (rfidModule.setHopTable(hopTable, keep) == RESPONSE_SUCCESS)
+  {
+    Serial.print(F("Now hopping between "));
+    Serial.print(keep);
+    Serial.println(F(" channels"));
+  }
+  else
+    Serial.println(F("Module turned the hop table down"));
+
+  rfidModule.startReading();
+}
+
+void loop()
+{
+  if (rfidModule.check() == true && rfidModule.parseResponse() == RESPONSE_IS_TAGFOUND)
+  {
+    Serial.print(F(" freq["));
+    Serial.print(rfidModule.getTagFreq());
+    Serial.print(F("] rssi["));
+    Serial.print(rfidModule.getTagRSSI());
+    Serial.println(F("]"));
+  }
+}
+
+//  915250 kHz  reads[182]  badCRC[0]  rssi[-79 -59 -40]
+//  915750 kHz  reads[21]  badCRC[0]  rssi[-78 -60 -41]  dead
+void printChannels(void)
+{
+  for (uint8_t x = 0; x < channels.getCount(); x++)
+  {
+    const RFID_ChannelEntry *channel = channels.getChannel(x);
+
+    Serial.print(F("  "));
+    Serial.print(channel->freq);
+    Serial.print(F(" kHz  reads["));
+    Serial.print(channel->reads);
+    Serial.print(F("]  badCRC["));
+    Serial.print(channel->crcErrors);
+    Serial.print(F("]  rssi["));
+    Serial.print(channel->rssiMin);
+    Serial.print(F(" "));
+    Serial.print(channel->getMeanRSSI());
+    Serial.print(F(" "));
+    Serial.print(channel->rssiMax);
+    Serial.print(F("]"));
+    if (channels.isDead(*channel) == true)
+      Serial.print(F("  dead"));
+    Serial.println();
+  }
+
+  Serial.print(channels.getReads());
+  Serial.print(F(" reads, "));
+  Serial.print(channels.getCRCErrors());
+  Serial.print(F(" with a bad EPC CRC, "));
+  Serial.print(rfidModule.getRejectedFrames());
+  Serial.println(F(" frames lost on the serial link"));
+}
+
+//Gracefully handles a reader that is already configured and already reading continuously
+//Because Stream does not have a .begin() we have to do this outside the library
+boolean setupRfidModule(long baudRate)
+{
+  rfidModule.begin(rfidSerial, moduleType); //Tell the library to communicate over serial port
+
+  //Test to see if we are already connected to a module
+  //This would be the case if the Arduino has been reprogrammed and the module has stayed powered
+  rfidSerial.begin(baudRate); //For this test, assume module is already at our desired baud rate
+  delay(100); //Wait for port to open
+
+  //About 200ms from power on the module will send its firmware version at 115200. We need to ignore this.
+  while (rfidSerial.available())
+    rfidSerial.read();
+
+  rfidModule.getVersion();
+
+  if (rfidModule.msg[0] == ERROR_WRONG_OPCODE_RESPONSE)
+  {
+    //This happens if the baud rate is correct but the module is doing a ccontinuous read
+    rfidModule.stopReading();
+
+    Serial.println(F("Module continuously reading. Asking it to stop..."));
+
+    delay(1500);
+  }
+  else
+  {
+    //The module did not respond so assume it's just been powered on and communicating at 115200bps
+    rfidSerial.begin(115200); //Start serial at 115200
+
+    rfidModule.setBaud(baudRate); //Tell the module to go to the chosen baud rate. Ignore the response msg
+
+    rfidSerial.begin(baudRate); //Start the serial port, this time at user's chosen baud rate
+
+    delay(250);
+  }
+
+  //Test the connection
+  rfidModule.getVersion();
+  if (rfidModule.msg[0] != ALL_GOOD)
+    return false; //Something is not right
+
+  //The module has these settings no matter what
+  rfidModule.setTagProtocol(); //Set protocol to GEN2
+
+  rfidModule.setAntennaPort(); //Set TX/RX antenna ports to 1
+
+  return true; //We are ready to rock
+}
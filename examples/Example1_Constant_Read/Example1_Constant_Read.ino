@@ -76,13 +76,16 @@ void loop()
     else if (responseType == RESPONSE_IS_TAGFOUND)
     {
       //If we have a full record we can pull out the fun bits
-      int rssi = rfidModule.getTagRSSI(); //Get the RSSI for this tag read
+      //parseResponse() has already cracked the record, so this is just a reference to it
+      const RFID_TagRecord &tag = rfidModule.getTagRecord();
 
-      long freq = rfidModule.getTagFreq(); //Get the frequency this tag was detected at
+      int rssi = tag.rssi; //Get the RSSI for this tag read
 
-      long timeStamp = rfidModule.getTagTimestamp(); //Get the time this was read, (ms) since last keep-alive message
+      long freq = tag.freq; //Get the frequency this tag was detected at
 
-      byte tagEPCBytes = rfidModule.getTagEPCBytes(); //Get the number of bytes of EPC from response
+      long timeStamp = tag.timestamp; //Get the time this was read, (ms) since last keep-alive message
+
+      byte tagEPCBytes = tag.epcLength; //Get the number of bytes of EPC from response
 
       Serial.print(F(" rssi["));
       Serial.print(rssi);
@@ -96,12 +99,12 @@ void loop()
       Serial.print(timeStamp);
       Serial.print(F("]"));
 
-      //Print EPC bytes, this is a subsection of bytes from the response/msg array
+      //Print EPC bytes. The record knows where they start, even when embedded data is present
       Serial.print(F(" epc["));
       for (byte x = 0 ; x < tagEPCBytes ; x++)
       {
-        if (rfidModule.msg[31 + x] < 0x10) Serial.print(F("0")); //Pretty print
-        Serial.print(rfidModule.msg[31 + x], HEX);
+        if (tag.epc[x] < 0x10) Serial.print(F("0")); //Pretty print
+        Serial.print(tag.epc[x], HEX);
         Serial.print(F(" "));
       }
       Serial.print(F("]"));
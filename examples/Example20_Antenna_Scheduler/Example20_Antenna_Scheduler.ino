@@ -0,0 +1,145 @@
+/*
+  Covering a shelf with several antenna ports
+  By: SparkFun Electronics
+
+  A module with more than one antenna port can watch several spots, but it only reads on
+  one port at a time. RFID_AntennaScheduler moves the continuous read from port to port,
+  giving each its own read power and dwell time, and keeps reads and RSSI for every port.
+
+  With adaptive dwell, every pass over the ports shares the time out again in proportion to
+  each port's yield (reads per second on its last turn). Ports looking at an empty stretch
+  of shelf drop to a short glance each pass, and the busy ones get the rest.
+
+  The M6E Nano has a single antenna port. This example is for modules with more, like a
+  multiplexed M7E Hecto setup.
+*/
+
+// Library for controlling the RFID module
+#include "SparkFun_UHF_RFID_Reader.h"
+#include "SparkFun_UHF_RFID_Antennas.h"
+
+// Create instances of the RFID module and of the scheduler that takes it from port to port
+RFID rfidModule;
+RFID_AntennaScheduler antennas(rfidModule);
+
+// By default, this example assumes hardware serial, since software serial can't keep up
+// with a busy continuous read
+#define rfidSerial Serial1 // Hardware serial (eg. ESP32 or Teensy)
+
+// Here you can select the baud rate for the module
+#define rfidBaud 115200
+
+// Here you can select which module you are using
+#define moduleType ThingMagic_M7E_HECTO
+
+// Here you can list the ports to use, with the read power and starting dwell time of each
+RFID_AntennaPort ports[] = {
+  RFID_AntennaPort().setPort(1).setReadPower(2000).setDwellTime(1000),
+  RFID_AntennaPort().setPort(2).setReadPower(2000).setDwellTime(1000),
+  RFID_AntennaPort().setPort(3).setReadPower(1500).setDwellTime(1000), //Closer to the tags, needs less
+};
+#define portCount (sizeof(ports) / sizeof(ports[0]))
+
+unsigned long lastReport = 0;
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial); //Wait for the serial port to come online
+
+  if (setupRfidModule(rfidBaud) == false)
+  {
+    Serial.println(F("Module failed to respond. Please check wiring."));
+    while (1); //Freeze!
+  }
+
+  rfidModule.setRegion(REGION_NORTHAMERICA); //Set to North America
+
+  Serial.println(F("Press a key to begin scanning for tags."));
+  while (!Serial.available()); //Wait for user to send a character
+  Serial.read(); //Throw away the user's character
+
+  antennas.enableLogging(Serial); //Print the yield and dwell time of each port after every pass
+  antennas.setAdaptive(200, 3000); //Every port gets between 200ms and 3s each pass
+
+  if (antennas.begin(ports, portCount) != RESPONSE_SUCCESS) //Begin scanning for tags
+  {
+    Serial.println(F("Module turned the ports down. Does it have that many?"));
+    while (1); //Freeze!
+  }
+}
+
+void loop()
+{
+  if (rfidModule.check() == true) //Check to see if any new data has come in from module
+    antennas.feed(rfidModule.parseResponse());
+
+  antennas.update(); //Moves to the next port when the current one has had its time
+
+  if (millis() - lastReport >= 10000)
+  {
+    lastReport = millis();
+    for (uint8_t x = 0; x < antennas.getPortCount(); x++)
+    {
+      const RFID_AntennaStats &stats = antennas.getStats(x);
+      Serial.print(F(" port["));
+      Serial.print(ports[x].port);
+      Serial.print(F("] reads["));
+      Serial.print(stats.reads);
+      Serial.print(F("] rssi["));
+      Serial.print(stats.getMeanRSSI());
+      Serial.print(F("] reads/s["));
+      Serial.print(stats.getReadRate());
+      Serial.println(F("]"));
+    }
+  }
+}
+
+//Gracefully handles a reader that is already configured and already reading continuously
+//Because Stream does not have a .begin() we have to do this outside the library
+boolean setupRfidModule(long baudRate)
+{
+  rfidModule.begin(rfidSerial, moduleType); //Tell the library to communicate over serial port
+
+  //Test to see if we are already connected to a module
+  //This would be the case if the Arduino has been reprogrammed and the module has stayed powered
+  rfidSerial.begin(baudRate); //For this test, assume module is already at our desired baud rate
+  delay(100); //Wait for port to open
+
+  //About 200ms from power on the module will send its firmware version at 115200. We need to ignore this.
+  while (rfidSerial.available())
+    rfidSerial.read();
+
+  rfidModule.getVersion();
+
+  if (rfidModule.msg[0] == ERROR_WRONG_OPCODE_RESPONSE)
+  {
+    //This happens if the baud rate is correct but the module is doing a ccontinuous read
+    rfidModule.stopReading();
+
+    Serial.println(F("Module continuously reading. Asking it to stop..."));
+
+    delay(1500);
+  }
+  else
+  {
+    //The module did not respond so assume it's just been powered on and communicating at 115200bps
+    rfidSerial.begin(115200); //Start serial at 115200
+
+    rfidModule.setBaud(baudRate); //Tell the module to go to the chosen baud rate. Ignore the response msg
+
+    rfidSerial.begin(baudRate); //Start the serial port, this time at user's chosen baud rate
+
+    delay(250);
+  }
+
+  //Test the connection
+  rfidModule.getVersion();
+  if (rfidModule.msg[0] != ALL_GOOD)
+    return false; //Something is not right
+
+  //The module has these settings no matter what
+  rfidModule.setTagProtocol(); //Set protocol to GEN2
+
+  return true; //We are ready to rock
+}
@@ -0,0 +1,165 @@
+/*
+  Keeping a trace of the serial link without slowing it down
+  By: SparkFun Electronics
+
+  enableDebugging() prints every byte to the Serial monitor as it goes by, and the time that
+  takes is enough to miss tags. This keeps the frames in RAM instead, with a time stamp on
+  each, and prints them only when asked.
+
+  Tags are read continuously. Press a key to print the frames that led up to now. When a
+  command fails, the trace is frozen and printed, so the frames around the fault are kept.
+
+  If using the Simultaneous RFID Tag Reader (SRTR) shield, make sure the serial slide
+  switch is in the 'HW-UART' position.
+*/
+
+// Library for controlling the RFID module
+#include "SparkFun_UHF_RFID_Reader.h"
+#include "SparkFun_UHF_RFID_Trace.h"
+
+// Create instance of the RFID module
+RFID rfidModule;
+
+// By default, this example assumes hardware serial, since software serial can't keep up
+// with a busy continuous read
+#define rfidSerial Serial1 // Hardware serial (eg. ESP32 or Teensy)
+
+// Here you can select the baud rate for the module
+#define rfidBaud 115200
+
+// Here you can select which module you are using. This library was originally
+// written for the M6E Nano only, and that is the default if the module is not
+// specified. Support for the M7E Hecto has since been added, which can be
+// selected below
+#define moduleType ThingMagic_M6E_NANO
+// #define moduleType ThingMagic_M7E_HECTO
+
+// Here you can select how much RAM the trace gets. A tag record frame is about 50 bytes.
+#define traceSize 1024
+
+uint8_t traceBuffer[traceSize];
+RFID_Trace trace(traceBuffer, traceSize);
+
+unsigned long tagCount = 0;
+unsigned long lastCheck = 0;
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial); //Wait for the serial port to come online
+
+  if (setupRfidModule(rfidBaud) == false)
+  {
+    Serial.println(F("Module failed to respond. Please check wiring."));
+    while (1); //Freeze!
+  }
+
+  rfidModule.setRegion(REGION_NORTHAMERICA); //Set to North America
+
+  rfidModule.setReadPower(500); //5.00 dBm. Higher values may cause USB port to brown out
+  //Max Read TX Power is 27.00 dBm and may cause temperature-limit throttling
+
+  rfidModule.enableTracing(trace); //From here on every frame is kept
+
+  Serial.println(F("Press a key to begin scanning for tags."));
+  while (!Serial.available()); //Wait for user to send a character
+  Serial.read(); //Throw away the user's character
+
+  rfidModule.startReading();
+}
+
+void loop()
+{
+  if (rfidModule.check() == true && rfidModule.parseResponse() == RESPONSE_IS_TAGFOUND)
+    tagCount++;
+
+  //Every few seconds, send a command in the middle of the read. If it fails, keep the evidence.
+  if (millis() - lastCheck > 5000)
+  {
+    lastCheck = millis();
+
+    int8_t temperature;
+    if (rfidModule.getTemperature(temperature) != RESPONSE_SUCCESS)
+    {
+      trace.freeze();
+      Serial.println(F("Temperature request failed. Frames up to it:"));
+      printTrace();
+    }
+    else
+    {
+      Serial.print(tagCount);
+      Serial.print(F(" tags, module at "));
+      Serial.print(temperature);
+      Serial.println(F("C"));
+    }
+  }
+
+  if (Serial.available())
+  {
+    while (Serial.available()) Serial.read(); //Throw away the user's characters
+    trace.freeze();
+    printTrace();
+  }
+}
+
+//Printing takes a while, so tags that come in meanwhile aren't traced. Start afresh afterwards.
+void printTrace(void)
+{
+  trace.print(Serial);
+  Serial.print(rfidModule.getRejectedFrames());
+  Serial.println(F(" frames rejected so far"));
+
+  trace.clear();
+  trace.resume();
+}
+
+//Gracefully handles a reader that is already configured and already reading continuously
+//Because Stream does not have a .begin() we have to do this outside the library
+boolean setupRfidModule(long baudRate)
+{
+  rfidModule.begin(rfidSerial, moduleType); //Tell the library to communicate over serial port
+
+  //Test to see if we are already connected to a module
+  //This would be the case if the Arduino has been reprogrammed and the module has stayed powered
+  rfidSerial.begin(baudRate); //For this test, assume module is already at our desired baud rate
+  delay(100); //Wait for port to open
+
+  //About 200ms from power on the module will send its firmware version at 115200. We need to ignore this.
+  while (rfidSerial.available())
+    rfidSerial.read();
+
+  rfidModule.getVersion();
+
+  if (rfidModule.msg[0] == ERROR_WRONG_OPCODE_RESPONSE)
+  {
+    //This happens if the baud rate is correct but the module is doing a ccontinuous read
+    rfidModule.stopReading();
+
+    Serial.println(F("Module continuously reading. Asking it to stop..."));
+
+    delay(1500);
+  }
+  else
+  {
+    //The module did not respond so assume it's just been powered on and communicating at 115200bps
+    rfidSerial.begin(115200); //Start serial at 115200
+
+    rfidModule.setBaud(baudRate); //Tell the module to go to the chosen baud rate. Ignore the response msg
+
+    rfidSerial.begin(baudRate); //Start the serial port, this time at user's chosen baud rate
+
+    delay(250);
+  }
+
+  //Test the connection
+  rfidModule.getVersion();
+  if (rfidModule.msg[0] != ALL_GOOD)
+    return false; //Something is not right
+
+  //The module has these settings no matter what
+  rfidModule.setTagProtocol(); //Set protocol to GEN2
+
+  rfidModule.setAntennaPort(); //Set TX/RX antenna ports to 1
+
+  return true; //We are ready to rock
+}
@@ -0,0 +1,161 @@
+/*
+  Antenna port scheduling for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  See SparkFun_UHF_RFID_Antennas.h for an overview.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#if (ARDUINO >= 100)
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "SparkFun_UHF_RFID_Antennas.h"
+
+uint8_t RFID_AntennaScheduler::begin(const RFID_AntennaPort *ports, uint8_t portCount, const RFID_ReadConfig &config)
+{
+  if (portCount > RFID_MAX_ANTENNA_PORTS)
+    portCount = RFID_MAX_ANTENNA_PORTS;
+
+  _ports = ports;
+  _portCount = 0;
+  _config = config;
+  _reads = 0;
+  _passes = 0;
+
+  uint8_t status = _reader.setAntennaPortPowers(ports, portCount);
+  if (status != RESPONSE_SUCCESS)
+    return (status);
+
+  _portCount = portCount;
+  for (uint8_t x = 0; x < portCount; x++)
+  {
+    memset(&_stats[x], 0, sizeof(_stats[x]));
+    _stats[x].dwellTime = ports[x].dwellTime;
+  }
+
+  startTurn(0);
+  return (RESPONSE_SUCCESS);
+}
+
+void RFID_AntennaScheduler::end(void)
+{
+  if (_portCount > 0)
+    endTurn();
+  _reader.stopReading();
+}
+
+void RFID_AntennaScheduler::feed(uint8_t responseType)
+{
+  if (responseType != RESPONSE_IS_TAGFOUND || _portCount == 0)
+    return;
+
+  //Records from the last port can still be on their way after a switch, so go by the
+  //port in the record. Without the antenna metadata field, the active port gets the read.
+  const RFID_TagRecord &tag = _reader.getTagRecord();
+  uint8_t index = _active;
+  for (uint8_t x = 0; x < _portCount; x++)
+    if (_ports[x].port == tag.getTXPort())
+      index = x;
+
+  _stats[index].reads++;
+  _stats[index].rssiSum += tag.rssi;
+  _reads++;
+  if (index == _active)
+    _turnReads++;
+}
+
+void RFID_AntennaScheduler::update(void)
+{
+  if (_portCount < 2)
+    return; //Nothing to switch to
+
+  if (millis() - _turnStart < _stats[_active].dwellTime)
+    return;
+
+  endTurn();
+
+  uint8_t next = _active + 1;
+  if (next == _portCount)
+  {
+    next = 0;
+    _passes++;
+    if (_adaptive == true)
+      rebalance();
+    logPass();
+  }
+
+  _reader.stopReading();
+  startTurn(next);
+}
+
+void RFID_AntennaScheduler::endTurn(void)
+{
+  RFID_AntennaStats &stats = _stats[_active];
+  uint32_t elapsed = millis() - _turnStart;
+  stats.readTime += elapsed;
+  stats.turns++;
+  stats.yield = elapsed ? _turnReads * 1000.0 / elapsed : 0;
+}
+
+//The port's power was set in begin(), so only the search list changes
+void RFID_AntennaScheduler::startTurn(uint8_t index)
+{
+  _active = index;
+  _reader.setAntennaSearchList(&_ports[index].port, 1);
+  _reader.startReading(_config);
+  _turnReads = 0;
+  _turnStart = millis();
+}
+
+//Shares the ports' total dwell time out in proportion to yield. A pass where nothing
+//was read leaves the dwell times alone.
+void RFID_AntennaScheduler::rebalance(void)
+{
+  uint32_t budget = 0;
+  float totalYield = 0;
+  for (uint8_t x = 0; x < _portCount; x++)
+  {
+    budget += _ports[x].dwellTime;
+    totalYield += _stats[x].yield;
+  }
+  if (totalYield == 0)
+    return;
+
+  for (uint8_t x = 0; x < _portCount; x++)
+  {
+    uint32_t dwell = budget * _stats[x].yield / totalYield;
+    if (dwell < _minDwell)
+      dwell = _minDwell;
+    if (dwell > _maxDwell)
+      dwell = _maxDwell;
+    _stats[x].dwellTime = dwell;
+  }
+}
+
+//Antennas: pass 12, port 1 208.50/s 1800ms, port 2 0.00/s 200ms
+void RFID_AntennaScheduler::logPass(void)
+{
+  if (_log == NULL)
+    return;
+
+  _log->print(F("Antennas: pass "));
+  _log->print(_passes);
+  for (uint8_t x = 0; x < _portCount; x++)
+  {
+    _log->print(F(", port "));
+    _log->print(_ports[x].port);
+    _log->print(F(" "));
+    _log->print(_stats[x].yield);
+    _log->print(F("/s "));
+    _log->print(_stats[x].dwellTime);
+    _log->print(F("ms"));
+  }
+  _log->println();
+}
@@ -0,0 +1,102 @@
+/*
+  Antenna port scheduling for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  Runs a continuous read on one antenna port at a time, moving to the next port once the
+  current one has had its dwell time. Each port reads at its own power. Every tag record
+  says which port it came in on, and reads, RSSI and time spent are kept for each port.
+
+  A port's yield is reads per second over its last turn. With setAdaptive() the dwell times
+  are shared out again after every pass over the ports: each port gets a slice of the total
+  in proportion to its yield, held between a floor and a ceiling. An empty stretch of shelf
+  then costs little more than a glance each pass, and the floor keeps it in the rotation so
+  tags placed there later are still found.
+
+    RFID_AntennaPort ports[] = {RFID_AntennaPort().setPort(1), RFID_AntennaPort().setPort(2)};
+    RFID_AntennaScheduler antennas(rfidModule);
+    antennas.setAdaptive(200, 3000);
+    antennas.begin(ports, 2); //Starts the continuous read on port 1
+    ...
+    if (rfidModule.check() == true)
+      antennas.feed(rfidModule.parseResponse());
+    antennas.update();
+
+  Switching ports stops and restarts the read, three commands in all, so keep dwell times
+  well above the few ms that takes.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#ifndef SPARKFUN_UHF_RFID_ANTENNAS_H
+#define SPARKFUN_UHF_RFID_ANTENNAS_H
+
+#include "SparkFun_UHF_RFID_Reader.h"
+
+struct RFID_AntennaStats
+{
+  int64_t rssiSum;    //For getMeanRSSI(), over every turn
+  uint32_t reads;
+  uint32_t readTime;  //ms spent reading on the port
+  uint16_t turns;
+  uint16_t dwellTime; //ms the port gets each turn, as adapted
+  float yield;        //Reads/s over the port's last turn
+
+  int8_t getMeanRSSI(void) const { return (reads ? (int8_t)(rssiSum / (int64_t)reads) : 0); }
+  float getReadRate(void) const { return (readTime ? reads * 1000.0 / readTime : 0); } //Reads/s over all turns
+};
+
+class RFID_AntennaScheduler
+{
+public:
+  RFID_AntennaScheduler(RFID &reader) : _reader(reader) {}
+
+  //Sets each port's power and starts the continuous read with config on the first port
+  //ports must stay around until end(). The read must be stopped when this is called.
+  //Returns RESPONSE_SUCCESS, or what the module said to the ports (see RFID::setAntennaPortPowers())
+  uint8_t begin(const RFID_AntennaPort *ports, uint8_t portCount, const RFID_ReadConfig &config = RFID_ReadConfig());
+  void end(void); //Stops the continuous read
+
+  void feed(uint8_t responseType); //Pass every parseResponse() result
+  void update(void);               //Call every loop. Moves to the next port when it's time.
+
+  void setAdaptive(uint16_t minDwell, uint16_t maxDwell) { _minDwell = minDwell; _maxDwell = maxDwell; _adaptive = true; }
+  void setFixed(void) { _adaptive = false; } //Each port keeps the dwell time it was given. The default.
+
+  void enableLogging(Print &logPort = Serial) { _log = &logPort; }
+  void disableLogging(void) { _log = NULL; }
+
+  uint8_t getPortCount(void) { return (_portCount); }
+  uint8_t getActivePort(void) { return (_portCount ? _ports[_active].port : 0); } //Port number being read
+  const RFID_AntennaStats &getStats(uint8_t index) { return (_stats[index < _portCount ? index : 0]); } //In the order of ports
+  uint32_t getReads(void) { return (_reads); }   //All ports
+  uint16_t getPasses(void) { return (_passes); } //Times every port has had its turn
+
+private:
+  void endTurn(void);
+  void startTurn(uint8_t index);
+  void rebalance(void);
+  void logPass(void);
+
+  RFID &_reader;
+  RFID_ReadConfig _config;
+  Print *_log = NULL;
+
+  const RFID_AntennaPort *_ports = NULL;
+  uint8_t _portCount = 0;
+  RFID_AntennaStats _stats[RFID_MAX_ANTENNA_PORTS];
+
+  boolean _adaptive = false;
+  uint16_t _minDwell = 0;
+  uint16_t _maxDwell = 0;
+
+  uint8_t _active = 0;
+  uint32_t _turnStart = 0;
+  uint32_t _turnReads = 0; //Reads on the active port this turn
+  uint32_t _reads = 0;
+  uint16_t _passes = 0;
+};
+
+#endif //SPARKFUN_UHF_RFID_ANTENNAS_H
@@ -0,0 +1,136 @@
+/*
+  Per-channel read statistics for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  See SparkFun_UHF_RFID_ChannelStats.h for an overview.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#if (ARDUINO >= 100)
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "SparkFun_UHF_RFID_ChannelStats.h"
+
+void RFID_ChannelStats::begin(const uint32_t *freqs, uint8_t count)
+{
+  clear();
+
+  if (count > RFID_MAX_HOP_CHANNELS)
+    count = RFID_MAX_HOP_CHANNELS;
+
+  for (uint8_t x = 0; x < count; x++)
+  {
+    if (find(freqs[x]) != NULL)
+      continue; //Listed twice
+
+    RFID_ChannelEntry &channel = _channels[_count++];
+    memset(&channel, 0, sizeof(channel));
+    channel.freq = freqs[x];
+  }
+}
+
+RFID_ChannelEntry *RFID_ChannelStats::add(const RFID_TagRecord &record)
+{
+  RFID_ChannelEntry *channel = (record.freq != 0) ? find(record.freq) : NULL;
+  if (channel == NULL)
+  {
+    if (record.freq == 0 || _count == RFID_MAX_HOP_CHANNELS)
+    {
+      _skipped++;
+      return (NULL);
+    }
+
+    channel = &_channels[_count++];
+    memset(channel, 0, sizeof(*channel));
+    channel->freq = record.freq;
+  }
+
+  if (channel->reads == 0)
+  {
+    channel->rssiMin = record.rssi;
+    channel->rssiMax = record.rssi;
+  }
+  channel->reads++;
+  channel->rssiSum += record.rssi;
+  if (record.rssi < channel->rssiMin)
+    channel->rssiMin = record.rssi;
+  if (record.rssi > channel->rssiMax)
+    channel->rssiMax = record.rssi;
+  _reads++;
+
+  if (validEPCCRC(record) == false)
+  {
+    channel->crcErrors++;
+    _crcErrors++;
+  }
+
+  return (channel);
+}
+
+//A hop table is a few dozen channels at most, so a straight search is fine
+RFID_ChannelEntry *RFID_ChannelStats::find(uint32_t freq)
+{
+  for (uint8_t x = 0; x < _count; x++)
+    if (_channels[x].freq == freq)
+      return (&_channels[x]);
+  return (NULL);
+}
+
+bool RFID_ChannelStats::isDead(const RFID_ChannelEntry &channel) const
+{
+  if (_count == 0)
+    return (false);
+
+  uint32_t meanGoodReads = (_reads - _crcErrors) / _count;
+  if (meanGoodReads < RFID_CHANNEL_MIN_READS)
+    return (false); //Too early to tell
+
+  if (channel.getGoodReads() * 100 < meanGoodReads * RFID_CHANNEL_DEAD_PERCENT)
+    return (true);
+  //The module normally drops bad replies itself, so this only fires if it lets them through
+  return (channel.crcErrors * 100 > channel.reads * RFID_CHANNEL_ERROR_PERCENT);
+}
+
+uint8_t RFID_ChannelStats::buildHopTable(uint32_t *freqs, uint8_t maxCount) const
+{
+  uint8_t count = 0;
+  for (uint8_t x = 0; x < _count && count < maxCount; x++)
+    if (isDead(_channels[x]) == false)
+      freqs[count++] = _channels[x].freq;
+  return (count);
+}
+
+void RFID_ChannelStats::clear(void)
+{
+  _count = 0;
+  _reads = 0;
+  _crcErrors = 0;
+  _skipped = 0;
+}
+
+//The EPC CRC is the Gen2 CRC-16 over the PC and EPC: poly 0x1021, preset 0xFFFF, inverted.
+//RFID::calculateCRC() is the module's frame CRC, which shifts the bytes in differently, so it can't be used here.
+static uint16_t gen2CRC(uint16_t crc, uint8_t value)
+{
+  crc ^= (uint16_t)value << 8;
+  for (uint8_t bit = 0; bit < 8; bit++)
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+  return (crc);
+}
+
+bool RFID_ChannelStats::validEPCCRC(const RFID_TagRecord &record)
+{
+  uint16_t crc = 0xFFFF;
+  crc = gen2CRC(crc, record.pc >> 8);
+  crc = gen2CRC(crc, record.pc & 0xFF);
+  for (uint8_t x = 0; x < record.epcLength; x++)
+    crc = gen2CRC(crc, record.epc[x]);
+  return ((uint16_t)~crc == record.epcCRC);
+}
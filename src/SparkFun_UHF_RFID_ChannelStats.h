@@ -0,0 +1,98 @@
+/*
+  Per-channel read statistics for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  Every tag record from a continuous read says which channel it was read on. Adding the
+  records here keeps, for each channel, how many reads it brought in and their RSSI. A channel
+  with interference on it stands out by bringing in far fewer reads than the rest.
+
+  Each record's EPC CRC is checked too, but that only catches what reaches the host. The
+  module already checks the tag's CRC and drops replies that fail, so on real hardware
+  crcErrors stays at 0 and the read count is the signal to go on. A non-zero count points
+  at a module or firmware passing damaged records along, not at the air.
+
+  Once enough reads are in, buildHopTable() leaves out the dead channels. Hand the result to
+  setHopTable() and the module stops spending dwell time where reads don't succeed.
+
+    RFID_ChannelStats channels;
+    uint32_t freqs[RFID_MAX_HOP_CHANNELS];
+    uint8_t count = RFID_MAX_HOP_CHANNELS;
+    if (rfidModule.getHopTable(freqs, count) == RESPONSE_SUCCESS)
+      channels.begin(freqs, count); //So channels that never read a tag show up too
+    ...
+    if (rfidModule.parseResponse() == RESPONSE_IS_TAGFOUND)
+      channels.add(rfidModule.getTagRecord());
+    ...
+    count = channels.buildHopTable(freqs, RFID_MAX_HOP_CHANNELS);
+    rfidModule.stopReading();
+    rfidModule.setHopTable(freqs, count);
+
+  The read needs the frequency metadata field, which startReading() asks for by default.
+  Frames lost to a bad frame CRC can't be put down to a channel; getRejectedFrames() counts those.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#ifndef SPARKFUN_UHF_RFID_CHANNEL_STATS_H
+#define SPARKFUN_UHF_RFID_CHANNEL_STATS_H
+
+#include "SparkFun_UHF_RFID_Reader.h"
+
+#define RFID_CHANNEL_MIN_READS 20      //Good reads per channel, on average, before any channel is called dead
+#define RFID_CHANNEL_DEAD_PERCENT 25   //A channel with fewer good reads than this share of the average is dead...
+#define RFID_CHANNEL_ERROR_PERCENT 10  //...and so is one where more than this share of reads fail the EPC CRC (see above)
+
+struct RFID_ChannelEntry
+{
+  int64_t rssiSum;    //For getMeanRSSI(), over the whole survey
+  uint32_t freq;      //kHz
+  uint32_t reads;     //Every record read on the channel, ones that fail the EPC CRC included
+  uint32_t crcErrors; //Records that reached the host with an EPC CRC that doesn't match. Normally 0, see above
+  int8_t rssiMin;
+  int8_t rssiMax;
+
+  uint32_t getGoodReads(void) const { return (reads - crcErrors); }
+  int8_t getMeanRSSI(void) const { return (reads ? (int8_t)(rssiSum / (int64_t)reads) : 0); }
+};
+
+class RFID_ChannelStats
+{
+public:
+  RFID_ChannelStats(void) { clear(); }
+
+  //Starts over with these channels, in this order. Optional: channels are also added as reads turn up on them.
+  void begin(const uint32_t *freqs, uint8_t count);
+
+  //Records a read. Returns its channel, or NULL if the record has no frequency or the table is full.
+  RFID_ChannelEntry *add(const RFID_TagRecord &record);
+
+  RFID_ChannelEntry *find(uint32_t freq);
+  const RFID_ChannelEntry *getChannel(uint8_t index) const { return (index < _count ? &_channels[index] : NULL); } //0 to getCount() - 1
+
+  //True once there are enough reads to go by and the channel trails the rest
+  bool isDead(const RFID_ChannelEntry &channel) const;
+
+  //Copies the channels that aren't dead, in table order, into freqs. Returns how many.
+  uint8_t buildHopTable(uint32_t *freqs, uint8_t maxCount) const;
+
+  void clear(void);
+
+  uint8_t getCount(void) const { return (_count); }
+  uint32_t getReads(void) const { return (_reads); }
+  uint32_t getCRCErrors(void) const { return (_crcErrors); } //Only what got past the module, see above
+  uint32_t getSkipped(void) const { return (_skipped); } //Records with no frequency, or on a channel that didn't fit
+
+private:
+  static bool validEPCCRC(const RFID_TagRecord &record);
+
+  RFID_ChannelEntry _channels[RFID_MAX_HOP_CHANNELS];
+  uint8_t _count;
+  uint32_t _reads;
+  uint32_t _crcErrors;
+  uint32_t _skipped;
+};
+
+#endif //SPARKFUN_UHF_RFID_CHANNEL_STATS_H
@@ -0,0 +1,207 @@
+/*
+  Tag commissioning for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  See SparkFun_UHF_RFID_Commissioner.h for an overview.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#if (ARDUINO >= 100)
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "SparkFun_UHF_RFID_Commissioner.h"
+
+//An EPC a job can't write fails the job straight away, see begin()
+static bool validEPCLength(uint8_t epcLength)
+{
+  return (epcLength <= RFID_MAX_EPC_BYTES && (epcLength & 0x01) == 0);
+}
+
+RFID_CommissionJob &RFID_CommissionJob::setEPC(const uint8_t *epc, uint8_t epcLength)
+{
+  newEPCLength = epcLength;
+  if (validEPCLength(epcLength))
+    memcpy(newEPC, epc, epcLength);
+  return (*this);
+}
+
+void RFID_Commissioner::begin(RFID_CommissionJob *jobs, uint16_t jobCount)
+{
+  _jobs = jobs;
+  _jobCount = jobCount;
+  _next = 0;
+
+  _done = 0;
+  _failed = 0;
+  _attempts = 0;
+  _latencySum = 0;
+  _startTime = millis();
+  _lastDone = _startTime;
+
+  for (uint16_t x = 0; x < jobCount; x++)
+  {
+    RFID_CommissionJob &job = jobs[x];
+    job.attempts = 0;
+    job.latency = 0;
+    job.retryAt = _startTime;
+    job.state = RFID_JOB_PENDING;
+
+    if (validEPCLength(job.newEPCLength) == false)
+    {
+      job.state = RFID_JOB_FAILED;
+      _failed++;
+    }
+  }
+}
+
+bool RFID_Commissioner::process(void)
+{
+  //Round robin from where we left off, so a job that keeps failing
+  //waits behind everything else instead of being tried again and again
+  bool pending = false;
+  uint16_t spot = _next;
+  for (uint16_t x = 0; x < _jobCount; x++, spot++)
+  {
+    if (spot == _jobCount)
+      spot = 0;
+
+    RFID_CommissionJob &job = _jobs[spot];
+    if (job.state != RFID_JOB_PENDING)
+      continue;
+    pending = true;
+
+    if ((int32_t)(millis() - job.retryAt) < 0)
+      continue; //Still backing off
+
+    //Each retry gets twice the time out of the one before
+    uint32_t timeOut = (uint32_t)_timeOut << job.attempts;
+    if (timeOut > COMMAND_TIME_OUT)
+      timeOut = COMMAND_TIME_OUT;
+
+    RFID_TagFilter previousFilter = _reader.getTagFilter();
+    uint32_t startTime = millis();
+    bool success = commission(job, timeOut);
+    uint32_t now = millis();
+    _reader.setTagFilter(previousFilter);
+
+    job.attempts++;
+    _attempts++;
+    if (success == true)
+    {
+      job.state = RFID_JOB_DONE;
+      job.latency = now - startTime;
+      _latencySum += job.latency;
+      _lastDone = now;
+      _done++;
+    }
+    else if (job.attempts >= _maxAttempts)
+    {
+      job.state = RFID_JOB_FAILED;
+      _failed++;
+    }
+    else
+      job.retryAt = now + (uint32_t)_retryDelay * job.attempts;
+
+    _next = spot + 1;
+    if (_next == _jobCount)
+      _next = 0;
+    return (true);
+  }
+
+  return (pending);
+}
+
+float RFID_Commissioner::getTagsPerMinute(void)
+{
+  uint32_t elapsed = _lastDone - _startTime;
+  if (elapsed == 0)
+    return (0);
+  return (_done * 60000.0 / elapsed);
+}
+
+//One attempt at everything a job asks for, with every command Selecting the job's tag
+//The EPC goes last since it changes what the tag answers to
+bool RFID_Commissioner::commission(RFID_CommissionJob &job, uint16_t timeOut)
+{
+  _reader.setTagFilter(job.target);
+
+  if (job.writePasswords == true)
+  {
+    //Reserved bank: kill password then access password, MSB first
+    uint8_t passwords[8];
+    for (uint8_t x = 0; x < 4; x++)
+    {
+      passwords[x] = job.killPassword >> (24 - x * 8) & 0xFF;
+      passwords[4 + x] = job.accessPassword >> (24 - x * 8) & 0xFF;
+    }
+    if (_reader.writeBlocks(TMR_GEN2_BANK_RESERVED, 0, passwords, sizeof(passwords), _verify, timeOut) != RESPONSE_SUCCESS)
+      return (false);
+  }
+
+  if (job.userData != NULL && job.userDataLength > 0)
+  {
+    if (_reader.writeBlocks(TMR_GEN2_BANK_USER, 0, job.userData, job.userDataLength, _verify, timeOut) != RESPONSE_SUCCESS)
+      return (false);
+  }
+
+  if (job.newEPCLength > 0)
+    return (writeEPC(job, timeOut));
+
+  return (true);
+}
+
+//Writes the PC and new EPC together so the PC's length field matches the EPC
+bool RFID_Commissioner::writeEPC(RFID_CommissionJob &job, uint16_t timeOut)
+{
+  RFID_TagFilter newFilter;
+  newFilter.setEPC(job.newEPC, job.newEPCLength);
+
+  //Keep the PC's other bits (UMI, XPC, NSI), only the length changes
+  uint8_t pc[2];
+  uint8_t pcLength = sizeof(pc);
+  if (_reader.readData(TMR_GEN2_BANK_EPC, 1, pc, pcLength, timeOut) != RESPONSE_SUCCESS || pcLength < 2)
+  {
+    //An earlier attempt may have got the EPC on but lost the answer.
+    //If the tag already carries the new EPC, carry on from there.
+    if (job.attempts == 0 || job.target.bank != TMR_GEN2_BANK_EPC)
+      return (false);
+
+    _reader.setTagFilter(newFilter);
+    pcLength = sizeof(pc);
+    if (_reader.readData(TMR_GEN2_BANK_EPC, 1, pc, pcLength, timeOut) != RESPONSE_SUCCESS || pcLength < 2)
+      return (false);
+    job.target = newFilter;
+  }
+
+  uint8_t epcWords[2 + RFID_MAX_EPC_BYTES];
+  epcWords[0] = (pc[0] & 0x07) | (job.newEPCLength / 2) << 3;
+  epcWords[1] = pc[1];
+  memcpy(&epcWords[2], job.newEPC, job.newEPCLength);
+
+  //Word 0 of the EPC bank is the CRC, the PC is word 1. This has to be one command: the tag
+  //is Selected on its old EPC, so a write split by setBlockWriteSize() would lose the tag
+  //after the first chunk and leave it half written.
+  if (_reader.writeData(TMR_GEN2_BANK_EPC, 1, epcWords, 2 + job.newEPCLength, timeOut) != RESPONSE_SUCCESS)
+    return (false);
+
+  //From here on the tag only answers to its new EPC
+  if (job.target.bank == TMR_GEN2_BANK_EPC)
+    job.target = newFilter;
+  _reader.setTagFilter(newFilter);
+
+  if (_verify == false)
+    return (true);
+
+  uint8_t readBack[2 + RFID_MAX_EPC_BYTES];
+  uint8_t readLength = 2 + job.newEPCLength;
+  if (_reader.readData(TMR_GEN2_BANK_EPC, 1, readBack, readLength, timeOut) != RESPONSE_SUCCESS)
+    return (false);
+  return (readLength == 2 + job.newEPCLength && memcmp(readBack, epcWords, readLength) == 0);
+}
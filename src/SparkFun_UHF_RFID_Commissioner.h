@@ -0,0 +1,111 @@
+/*
+  Tag commissioning for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  Works through a list of jobs, each one naming a tag (by its current EPC or TID) and what it
+  should end up with: a new EPC, access and kill passwords, user memory. Every write for a tag
+  goes out back to back under one Select, so nothing lands on the tag next to it, and is read
+  back to check it stuck.
+
+  A tag that fails (not in the field yet, a weak read) goes to the back of the queue with a
+  longer time out and is tried again later, so one bad tag doesn't hold up the line.
+  The job list belongs to the sketch; nothing is allocated.
+
+    RFID_CommissionJob jobs[2];
+    jobs[0].setTarget(RFID_TagFilter().setEPC(oldEPC, 12)).setEPC(newEPC, 12).setPasswords(0x12345678, 0x87654321);
+    ...
+    RFID_Commissioner commissioner(rfidModule);
+    commissioner.begin(jobs, 2);
+    while (commissioner.process() == true)
+      ;
+
+  Stop any continuous read first.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#ifndef SPARKFUN_UHF_RFID_COMMISSIONER_H
+#define SPARKFUN_UHF_RFID_COMMISSIONER_H
+
+#include "SparkFun_UHF_RFID_Reader.h"
+
+#define RFID_COMMISSION_TIME_OUT 250   //ms tag operations get on the first attempt. Doubles with every retry.
+#define RFID_COMMISSION_ATTEMPTS 5     //Attempts before a job is given up on
+#define RFID_COMMISSION_RETRY_DELAY 100 //ms a failed job waits before its next attempt, times the attempts so far
+
+//Where a job is at
+#define RFID_JOB_PENDING 0
+#define RFID_JOB_DONE 1
+#define RFID_JOB_FAILED 2
+
+struct RFID_CommissionJob
+{
+  RFID_TagFilter target;          //Which tag, by its current EPC or TID
+  const uint8_t *userData = NULL; //Written to the start of user memory. NULL = leave it alone.
+  uint32_t accessPassword = 0;
+  uint32_t killPassword = 0;
+  uint32_t latency = 0;           //ms the successful attempt took
+  uint32_t retryAt = 0;           //millis() the next attempt is due at
+  uint8_t newEPC[RFID_MAX_EPC_BYTES];
+  uint8_t newEPCLength = 0;       //0 = keep the EPC
+  uint8_t userDataLength = 0;
+  boolean writePasswords = false;
+  uint8_t attempts = 0;
+  uint8_t state = RFID_JOB_PENDING;
+
+  RFID_CommissionJob &setTarget(const RFID_TagFilter &filter) { target = filter; return (*this); }
+  RFID_CommissionJob &setEPC(const uint8_t *epc, uint8_t epcLength); //epcLength must be even, and at most RFID_MAX_EPC_BYTES
+  RFID_CommissionJob &setPasswords(uint32_t access, uint32_t kill) { accessPassword = access; killPassword = kill; writePasswords = true; return (*this); }
+  RFID_CommissionJob &setUserData(const uint8_t *data, uint8_t length) { userData = data; userDataLength = length; return (*this); }
+};
+
+class RFID_Commissioner
+{
+public:
+  RFID_Commissioner(RFID &reader) : _reader(reader) {}
+
+  void begin(RFID_CommissionJob *jobs, uint16_t jobCount); //Resets the jobs and the statistics
+
+  //Makes one attempt at the next job that is due. Call until it returns false, which
+  //means every job is done or has failed. Returns true without doing anything while the
+  //only jobs left are waiting to be retried.
+  bool process(void);
+
+  void setVerify(boolean verify) { _verify = verify; } //Read everything back. On by default.
+  void setMaxAttempts(uint8_t attempts) { _maxAttempts = attempts; }
+  void setTimeOut(uint16_t timeOut) { _timeOut = timeOut; } //ms for the first attempt at each job
+  void setRetryDelay(uint16_t retryDelay) { _retryDelay = retryDelay; }
+
+  uint16_t getDone(void) { return (_done); }
+  uint16_t getFailed(void) { return (_failed); }
+  uint16_t getPending(void) { return (_jobCount - _done - _failed); }
+  uint32_t getAttempts(void) { return (_attempts); }                     //Attempts made across all jobs
+  uint32_t getMeanLatency(void) { return (_done ? _latencySum / _done : 0); } //ms per commissioned tag
+  float getTagsPerMinute(void);
+
+private:
+  bool commission(RFID_CommissionJob &job, uint16_t timeOut);
+  bool writeEPC(RFID_CommissionJob &job, uint16_t timeOut);
+
+  RFID &_reader;
+  RFID_CommissionJob *_jobs = NULL;
+  uint16_t _jobCount = 0;
+  uint16_t _next = 0; //Where the search for the next due job starts
+
+  boolean _verify = true;
+  uint8_t _maxAttempts = RFID_COMMISSION_ATTEMPTS;
+  uint16_t _timeOut = RFID_COMMISSION_TIME_OUT;
+  uint16_t _retryDelay = RFID_COMMISSION_RETRY_DELAY;
+
+  uint16_t _done = 0;
+  uint16_t _failed = 0;
+  uint32_t _attempts = 0;
+  uint32_t _latencySum = 0;
+  uint32_t _startTime = 0;
+  uint32_t _lastDone = 0;
+};
+
+#endif //SPARKFUN_UHF_RFID_COMMISSIONER_H
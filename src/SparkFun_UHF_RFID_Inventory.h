@@ -0,0 +1,176 @@
+/*
+  Tag inventory for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  Keeps one entry per unique EPC along with when it was first and last seen, how many
+  times it was read, and its min/max/mean RSSI. Lookups are O(1): entries live in an
+  open-addressing hash table whose size is fixed at compile time, so there is no heap use
+  and nothing to scan linearly as the population grows.
+
+  Feed it straight from a continuous read:
+
+    RFID_Inventory<256> inventory;
+    ...
+    if (rfidModule.parseResponse() == RESPONSE_IS_TAGFOUND)
+    {
+      RFID_InventoryEntry *tag = inventory.add(rfidModule.getTagRecord());
+      if (tag != NULL && tag->readCount == 1)
+        //First time we've seen this tag
+    }
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#ifndef SPARKFUN_UHF_RFID_INVENTORY_H
+#define SPARKFUN_UHF_RFID_INVENTORY_H
+
+#include "SparkFun_UHF_RFID_Reader.h"
+
+//Reads with an empty EPC, or one longer than RFID_MAX_EPC_BYTES, are counted by getSkipped() rather than stored
+struct RFID_InventoryEntry
+{
+  int64_t rssiSum;    //For getMeanRSSI(). A tag left in the field can outlast 32 bits
+  uint32_t firstSeen; //millis() of the first read
+  uint32_t lastSeen;  //millis() of the latest read
+  uint32_t readCount;
+  int8_t rssiMin;
+  int8_t rssiMax;
+  uint8_t epcLength;  //0 = empty slot
+  uint8_t epc[RFID_MAX_EPC_BYTES];
+
+  int8_t getMeanRSSI(void) const { return (readCount ? (int8_t)(rssiSum / (int64_t)readCount) : 0); }
+};
+
+//CAPACITY is the number of slots in the table and must be a power of two
+//Keep it comfortably above the expected number of unique tags; probing gets slower as it fills
+template <uint16_t CAPACITY>
+class RFID_Inventory
+{
+  static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "RFID_Inventory capacity must be a power of two");
+
+public:
+  RFID_Inventory(void) { clear(); }
+
+  //Records a read of a tag. Returns its entry (readCount == 1 means the tag is new),
+  //or NULL if the table is full or the EPC is empty or too long to store.
+  RFID_InventoryEntry *add(const uint8_t *epc, uint8_t epcLength, int8_t rssi, uint32_t now = millis())
+  {
+    if (epcLength == 0 || epcLength > RFID_MAX_EPC_BYTES)
+    {
+      _skipped++;
+      return (NULL);
+    }
+
+    uint16_t slot = hash(epc, epcLength) & (CAPACITY - 1);
+    for (uint16_t probe = 0; probe < CAPACITY; probe++)
+    {
+      RFID_InventoryEntry &entry = _entries[slot];
+
+      if (entry.epcLength == 0)
+      {
+        //Empty slot, so this tag isn't in the table yet
+        if (_count == CAPACITY)
+          break;
+
+        entry.epcLength = epcLength;
+        memcpy(entry.epc, epc, epcLength);
+        entry.firstSeen = now;
+        entry.readCount = 0;
+        entry.rssiSum = 0;
+        entry.rssiMin = rssi;
+        entry.rssiMax = rssi;
+        _count++;
+        return (update(entry, rssi, now));
+      }
+
+      if (entry.epcLength == epcLength && memcmp(entry.epc, epc, epcLength) == 0)
+        return (update(entry, rssi, now));
+
+      slot = (slot + 1) & (CAPACITY - 1); //Linear probing
+    }
+
+    _overflows++;
+    return (NULL);
+  }
+
+  RFID_InventoryEntry *add(const RFID_TagRecord &record, uint32_t now = millis())
+  {
+    return (add(record.epc, record.epcLength, record.rssi, now));
+  }
+
+  //Returns the entry for an EPC, or NULL if it hasn't been seen
+  RFID_InventoryEntry *find(const uint8_t *epc, uint8_t epcLength)
+  {
+    if (epcLength == 0 || epcLength > RFID_MAX_EPC_BYTES)
+      return (NULL);
+
+    uint16_t slot = hash(epc, epcLength) & (CAPACITY - 1);
+    for (uint16_t probe = 0; probe < CAPACITY; probe++)
+    {
+      RFID_InventoryEntry &entry = _entries[slot];
+      if (entry.epcLength == 0)
+        return (NULL);
+      if (entry.epcLength == epcLength && memcmp(entry.epc, epc, epcLength) == 0)
+        return (&entry);
+      slot = (slot + 1) & (CAPACITY - 1);
+    }
+    return (NULL);
+  }
+
+  //Walk the table with slot = 0 to getCapacity() - 1. Returns NULL for empty slots.
+  const RFID_InventoryEntry *getEntry(uint16_t slot) const
+  {
+    if (slot >= CAPACITY || _entries[slot].epcLength == 0)
+      return (NULL);
+    return (&_entries[slot]);
+  }
+
+  void clear(void)
+  {
+    for (uint16_t x = 0; x < CAPACITY; x++)
+      _entries[x].epcLength = 0;
+    _count = 0;
+    _overflows = 0;
+    _skipped = 0;
+  }
+
+  uint16_t getCount(void) const { return (_count); } //Unique tags in the table
+  uint16_t getCapacity(void) const { return (CAPACITY); }
+  uint32_t getOverflows(void) const { return (_overflows); } //Reads of new tags that didn't fit
+  uint32_t getSkipped(void) const { return (_skipped); }     //Reads with an empty EPC or one longer than RFID_MAX_EPC_BYTES
+
+private:
+  RFID_InventoryEntry *update(RFID_InventoryEntry &entry, int8_t rssi, uint32_t now)
+  {
+    entry.lastSeen = now;
+    entry.readCount++;
+    entry.rssiSum += rssi;
+    if (rssi < entry.rssiMin)
+      entry.rssiMin = rssi;
+    if (rssi > entry.rssiMax)
+      entry.rssiMax = rssi;
+    return (&entry);
+  }
+
+  //FNV-1a. Serialized EPCs often differ only in their last bytes, so every byte counts.
+  static uint32_t hash(const uint8_t *epc, uint8_t epcLength)
+  {
+    uint32_t value = 2166136261UL;
+    for (uint8_t x = 0; x < epcLength; x++)
+    {
+      value ^= epc[x];
+      value *= 16777619UL;
+    }
+    return (value ^ (value >> 16));
+  }
+
+  RFID_InventoryEntry _entries[CAPACITY];
+  uint16_t _count;
+  uint32_t _overflows;
+  uint32_t _skipped;
+};
+
+#endif //SPARKFUN_UHF_RFID_INVENTORY_H
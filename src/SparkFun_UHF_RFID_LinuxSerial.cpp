@@ -0,0 +1,267 @@
+/*
+  POSIX serial port for the SparkFun UHF RFID library on Linux
+  By: SparkFun Electronics
+
+  See SparkFun_UHF_RFID_LinuxSerial.h for an overview.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#if defined(__linux__)
+
+#if (ARDUINO >= 100)
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "SparkFun_UHF_RFID_LinuxSerial.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <linux/serial.h>
+
+//termios only takes its own constants. 0 = not one of them.
+static speed_t termiosSpeed(long baudRate)
+{
+  switch (baudRate)
+  {
+  case 9600:
+    return (B9600);
+  case 19200:
+    return (B19200);
+  case 38400:
+    return (B38400);
+  case 57600:
+    return (B57600);
+  case 115200:
+    return (B115200);
+  case 230400:
+    return (B230400);
+  case 460800:
+    return (B460800);
+  case 921600:
+    return (B921600);
+  default:
+    return (0);
+  }
+}
+
+bool RFID_LinuxSerial::begin(long baudRate)
+{
+  speed_t speed = termiosSpeed(baudRate);
+  if (speed == 0)
+    return (false);
+
+  bool opening = (_fd < 0);
+  if (opening == true)
+  {
+    _fd = ::open(_device, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (_fd < 0)
+      return (false);
+  }
+
+  struct termios tio;
+  if (tcgetattr(_fd, &tio) != 0)
+  {
+    end();
+    return (false);
+  }
+
+  //Raw 8N1, no flow control. read() never blocks, wait() does the waiting.
+  cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 0;
+  cfsetispeed(&tio, speed);
+  cfsetospeed(&tio, speed);
+
+  //A rate change waits for anything still going out at the old rate
+  sendPending();
+  if (tcsetattr(_fd, opening ? TCSANOW : TCSADRAIN, &tio) != 0)
+  {
+    end();
+    return (false);
+  }
+
+  if (opening == true)
+  {
+    //USB serial adapters hold received bytes for a few ms unless asked not to.
+    //Ports that don't know the request (ptys, some drivers) are fine as they are.
+    struct serial_struct serial;
+    if (ioctl(_fd, TIOCGSERIAL, &serial) == 0)
+    {
+      serial.flags |= ASYNC_LOW_LATENCY;
+      ioctl(_fd, TIOCSSERIAL, &serial);
+    }
+
+    tcflush(_fd, TCIOFLUSH); //Nothing from before we opened the port
+    _rxCount = 0;
+    _txCount = 0;
+  }
+
+  return (true);
+}
+
+void RFID_LinuxSerial::end(void)
+{
+  if (_fd < 0)
+    return;
+
+  sendPending();
+  ::close(_fd);
+  _fd = -1;
+  _rxCount = 0;
+  _txCount = 0;
+}
+
+bool RFID_LinuxSerial::wait(uint32_t timeOut)
+{
+  if (available() > 0)
+    return (true);
+  if (_fd < 0)
+  {
+    delay(timeOut); //Nothing will ever arrive, don't let the caller spin
+    return (false);
+  }
+
+  uint32_t start = millis();
+  while (true)
+  {
+    uint32_t elapsed = millis() - start;
+    if (elapsed >= timeOut)
+      return (false);
+
+    struct pollfd waitFor = {_fd, POLLIN, 0};
+    int ready = poll(&waitFor, 1, timeOut - elapsed);
+    if (ready > 0)
+    {
+      if (fill() == true)
+        return (true);
+      if ((waitFor.revents & (POLLHUP | POLLERR | POLLNVAL)) != 0)
+      {
+        //Nothing left to read and the adapter was unplugged or the port broke.
+        //poll() would keep saying so straight away, so close it.
+        end();
+        return (false);
+      }
+    }
+    if (ready < 0 && errno != EINTR)
+      return (false);
+  }
+}
+
+void RFID_LinuxSerial::waitCallback(Stream &port, uint32_t maxWait)
+{
+  static_cast<RFID_LinuxSerial &>(port).wait(maxWait);
+}
+
+int RFID_LinuxSerial::available(void)
+{
+  if (_rxCount == 0)
+    fill();
+  return (_rxCount);
+}
+
+int RFID_LinuxSerial::read(void)
+{
+  if (available() == 0)
+    return (-1);
+
+  _rxCount--;
+  return (_rxBuffer[_rxHead++]);
+}
+
+int RFID_LinuxSerial::peek(void)
+{
+  if (available() == 0)
+    return (-1);
+  return (_rxBuffer[_rxHead]);
+}
+
+size_t RFID_LinuxSerial::write(uint8_t value)
+{
+  return (write(&value, 1));
+}
+
+//Gathered until flush(), or the port is next read, so a command goes out in one write()
+size_t RFID_LinuxSerial::write(const uint8_t *buffer, size_t size)
+{
+  if (_fd < 0)
+    return (0);
+
+  size_t written = 0;
+  while (written < size)
+  {
+    if (_txCount == RFID_LINUX_TX_BUFFER && sendPending() == false)
+      break;
+
+    size_t chunk = size - written;
+    if (chunk > (size_t)(RFID_LINUX_TX_BUFFER - _txCount))
+      chunk = RFID_LINUX_TX_BUFFER - _txCount;
+    memcpy(&_txBuffer[_txCount], &buffer[written], chunk);
+    _txCount += chunk;
+    written += chunk;
+  }
+  return (written);
+}
+
+void RFID_LinuxSerial::flush(void)
+{
+  if (sendPending() == true)
+    tcdrain(_fd);
+}
+
+//Pulls in whatever the port has, once the buffer has been used up
+//Returns true if there are bytes to read
+bool RFID_LinuxSerial::fill(void)
+{
+  if (_rxCount > 0)
+    return (true);
+  if (_fd < 0 || sendPending() == false)
+    return (false);
+
+  _rxHead = 0;
+  ssize_t received = ::read(_fd, _rxBuffer, sizeof(_rxBuffer));
+  if (received > 0)
+    _rxCount = received;
+  return (_rxCount > 0);
+}
+
+//Hands the gathered bytes to the port, waiting for room if the driver is full
+//Returns false if the port has gone away
+bool RFID_LinuxSerial::sendPending(void)
+{
+  uint16_t sent = 0;
+  while (sent < _txCount)
+  {
+    ssize_t written = ::write(_fd, &_txBuffer[sent], _txCount - sent);
+    if (written > 0)
+      sent += written;
+    else if (written < 0 && errno == EAGAIN)
+    {
+      struct pollfd waitFor = {_fd, POLLOUT, 0};
+      poll(&waitFor, 1, 100);
+    }
+    else if (written < 0 && errno == EINTR)
+      continue;
+    else
+    {
+      _txCount = 0;
+      return (false);
+    }
+  }
+
+  _txCount = 0;
+  return (true);
+}
+
+#endif //__linux__
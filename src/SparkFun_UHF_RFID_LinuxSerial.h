@@ -0,0 +1,88 @@
+/*
+  POSIX serial port for the SparkFun UHF RFID library on Linux
+  By: SparkFun Electronics
+
+  A Stream on top of a tty (/dev/ttyUSB0, /dev/ttyAMA0, ...) for running the library on a
+  Linux gateway. The port is put in raw mode, 8N1 with no flow control, and asked for low
+  latency so the USB serial driver doesn't sit on received bytes.
+
+  Bytes move in bulk: received bytes are pulled in with one read() into a buffer that
+  available() and read() work from, and the pieces of a command are gathered up and go out
+  with one write() when the library flush()es at the end of the command.
+
+  Instead of spinning, wait() sleeps in poll() until the module sends something. Hand
+  waitCallback() to the reader so blocking commands sleep the same way:
+
+    RFID_LinuxSerial rfidSerial("/dev/ttyUSB0");
+    rfidSerial.begin(115200);
+    rfidModule.begin(rfidSerial, ThingMagic_M7E_HECTO);
+    rfidModule.setWaitCallback(RFID_LinuxSerial::waitCallback);
+    ...
+    if (rfidModule.check() == true)
+      rfidModule.parseResponse();
+    else
+      rfidSerial.wait(100); //Back as soon as a tag frame starts arriving
+
+  Only built on Linux.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#ifndef SPARKFUN_UHF_RFID_LINUX_SERIAL_H
+#define SPARKFUN_UHF_RFID_LINUX_SERIAL_H
+
+#if defined(__linux__)
+
+#include "SparkFun_UHF_RFID_Reader.h"
+
+#define RFID_LINUX_RX_BUFFER 4096 //Bytes pulled in per read(). A second of tags at 921600 is about 90k.
+#define RFID_LINUX_TX_BUFFER 256  //Bytes gathered before a write(). Holds the largest command.
+
+class RFID_LinuxSerial : public Stream
+{
+public:
+  RFID_LinuxSerial(const char *device) : _device(device) {}
+  ~RFID_LinuxSerial(void) { end(); }
+
+  //Opens the port the first time, after that just changes the baud rate
+  //Returns false if the port can't be opened or the rate isn't one termios knows
+  bool begin(long baudRate);
+  void end(void);
+  bool isOpen(void) { return (_fd >= 0); }
+  int getFD(void) { return (_fd); } //For poll() or epoll() on several ports at once
+
+  //Sleeps until there's something to read or timeOut ms pass. True if there's something to read.
+  //A port that hangs up (USB adapter unplugged) is closed, and isOpen() goes false.
+  bool wait(uint32_t timeOut);
+  static void waitCallback(Stream &port, uint32_t maxWait); //For RFID::setWaitCallback(). port must be an RFID_LinuxSerial.
+
+  //Stream interface
+  int available(void);
+  int read(void);
+  int peek(void);
+  size_t write(uint8_t value);
+  size_t write(const uint8_t *buffer, size_t size);
+  void flush(void); //Sends what's gathered and waits for it to leave the port
+  using Print::write;
+
+private:
+  bool fill(void);
+  bool sendPending(void);
+
+  const char *_device;
+  int _fd = -1;
+
+  uint8_t _rxBuffer[RFID_LINUX_RX_BUFFER];
+  uint16_t _rxHead = 0;
+  uint16_t _rxCount = 0;
+
+  uint8_t _txBuffer[RFID_LINUX_TX_BUFFER];
+  uint16_t _txCount = 0;
+};
+
+#endif //__linux__
+
+#endif //SPARKFUN_UHF_RFID_LINUX_SERIAL_H
@@ -22,9 +22,11 @@
   Available Functions:
     setBaudRate
     setRegion
+    setHopTable / setHopTime (custom frequency hopping)
     setReadPower
     startReading (continuous read)
     stopReading
+    readTagsBuffered (timed inventory, tags pulled from the module's buffer)
     readTagEPC
     writeTagEPC
     readTagData
@@ -40,6 +42,16 @@
 #endif
 
 #include "SparkFun_UHF_RFID_Reader.h"
+#include "SparkFun_UHF_RFID_Trace.h"
+
+//Reads a big-endian value of 'bytes' length out of msg and moves spot past it
+static uint32_t readField(const uint8_t *msg, uint8_t &spot, uint8_t bytes)
+{
+  uint32_t value = 0;
+  for (uint8_t x = 0; x < bytes; x++)
+    value = (value << 8) | msg[spot++];
+  return (value);
+}
 
 RFID::RFID(void)
 {
@@ -74,48 +86,375 @@ void RFID::disableDebugging(void)
 //Returns response in the msg array
 void RFID::setBaud(long baudRate)
 {
-  //Copy this setting into a temp data array
-  uint8_t size = sizeof(baudRate);
-  uint8_t data[size];
-  for (uint8_t x = 0; x < size; x++)
-    data[x] = (uint8_t)(baudRate >> (8 * (size - 1 - x)));
+  //Copy this setting into a temp data array. The module wants 4 bytes, whatever size a long is.
+  uint8_t data[4];
+  for (uint8_t x = 0; x < sizeof(data); x++)
+    data[x] = (uint8_t)(baudRate >> (8 * (3 - x)));
+
+  sendMessage(TMR_SR_OPCODE_SET_BAUD_RATE, data, sizeof(data), COMMAND_TIME_OUT, false);
+}
+
+//Baud rates the modules support, slowest first
+static const long baudRates[] = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600};
+
+//Steps the module and the host up through the supported baud rates, as far as maxBaud
+//Every step is checked with RFID_BAUD_TEST_ROUNDS version round trips. A step that times out
+//or sees a single bad CRC is undone and the climb stops there, since faster is only going to
+//be worse. If currentBaud itself isn't clean, steps down until a rate is.
+//Both ends are left at the rate returned, or 0 if the module can't be found anymore.
+//currentBaud is the rate both ends are at now. Stop any continuous read first.
+long RFID::autoBaud(long currentBaud, RFID_BaudCallback setHostBaud, long maxBaud)
+{
+  if (_continuousReading == true)
+    return (0);
+
+  if (testLink() == false)
+  {
+    for (int8_t x = sizeof(baudRates) / sizeof(baudRates[0]) - 1; x >= 0; x--)
+    {
+      if (baudRates[x] >= currentBaud)
+        continue;
+
+      switchBaud(baudRates[x], setHostBaud);
+      if (testLink() == true)
+        return (baudRates[x]);
+    }
+    return (0);
+  }
+
+  long goodBaud = currentBaud;
+
+  for (uint8_t x = 0; x < sizeof(baudRates) / sizeof(baudRates[0]); x++)
+  {
+    long baudRate = baudRates[x];
+    if (baudRate <= goodBaud)
+      continue;
+    if (baudRate > maxBaud)
+      break;
+
+    if (switchBaud(baudRate, setHostBaud) == true && testLink() == true)
+    {
+      goodBaud = baudRate;
+      continue;
+    }
+
+    //Back down. If the module never got the change it ignores this and is already where we want it.
+    switchBaud(goodBaud, setHostBaud);
+    if (testLink() == false)
+      return (0);
+    break;
+  }
+
+  if (_printDebug == true)
+  {
+    _debugSerial->print(F("autoBaud: settled at "));
+    _debugSerial->println(goodBaud);
+  }
+
+  return (goodBaud);
+}
+
+//Tells the module to change baud rate and follows it
+//The module answers at the old rate before switching. Returns false if it didn't answer,
+//which on a noisy link may only mean the answer was lost.
+bool RFID::switchBaud(long baudRate, RFID_BaudCallback setHostBaud)
+{
+  uint8_t data[4];
+  for (uint8_t x = 0; x < sizeof(data); x++)
+    data[x] = (uint8_t)(baudRate >> (8 * (3 - x)));
+
+  boolean answered = false;
+  for (uint8_t tries = 0; tries < 3 && answered == false; tries++)
+  {
+    sendMessage(TMR_SR_OPCODE_SET_BAUD_RATE, data, sizeof(data), 100);
+    answered = (msg[0] == ALL_GOOD);
+  }
+
+  setHostBaud(baudRate);
+  delay(RFID_BAUD_SETTLE_TIME);
+
+  return (answered);
+}
+
+//Version round trips at the current baud rate. Passes only if every one comes back with a
+//good CRC, including any frames check() had to throw away along the way.
+bool RFID::testLink(void)
+{
+  uint32_t rejected = _rxRejected;
+  uint32_t errors = 0;
+
+  for (uint8_t x = 0; x < RFID_BAUD_TEST_ROUNDS; x++)
+  {
+    getVersion();
+    if (msg[0] != ALL_GOOD)
+      errors++;
+  }
+  errors += _rxRejected - rejected;
+
+  if (_printDebug == true)
+  {
+    _debugSerial->print(F("testLink: "));
+    _debugSerial->print(errors);
+    _debugSerial->print(F(" errors in "));
+    _debugSerial->print(RFID_BAUD_TEST_ROUNDS);
+    _debugSerial->println(F(" round trips"));
+  }
 
-  sendMessage(TMR_SR_OPCODE_SET_BAUD_RATE, data, size, COMMAND_TIME_OUT, false);
+  return (errors == 0);
 }
 
 //Begin scanning for tags
 //There are many many options and features to the nano, this sets options
 //for continuous read of GEN2 type tags
 void RFID::startReading()
+{
+  startReading(RFID_ReadConfig()); //Full metadata, RF on all the time
+}
+
+//Begin scanning for tags with the options in config
+void RFID::startReading(const RFID_ReadConfig &config)
 {
   disableReadFilter(); //Don't filter for a specific tag, read all tags
 
-  //This blob was found by using the 'Transport Logs' option from the Universal Reader Assistant
-  //And connecting the Nano eval kit from Thing Magic to the URA
-  //A lot of it has been deciphered but it's easier and faster just to pass a blob than to
-  //assemble every option and sub-opcode.
-  uint8_t configBlob[] = {0x00, 0x00, 0x01, 0x22, 0x00, 0x00, 0x05, 0x07, 0x22, 0x10, 0x00, 0x1B, 0x03, 0xE8, 0x01, 0xFF};
-
-  /*
-    //Timeout should be zero for true continuous reading
-    SETU16(newMsg, i, 0);
-    SETU8(newMsg, i, (uint8_t)0x1); // TM Option 1, for continuous reading
-    SETU8(newMsg, i, (uint8_t)TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE); // sub command opcode
-    SETU16(newMsg, i, (uint16_t)0x0000); // search flags, only 0x0001 is supported
-    SETU8(newMsg, i, (uint8_t)TMR_TAG_PROTOCOL_GEN2); // protocol ID
-  */
+  uint8_t configBlob[18 + 4 + 5 + RFID_MAX_FILTER_BYTES + 12];
+  uint8_t size = buildReadCommand(config, configBlob);
 
-  sendMessage(TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP, configBlob, sizeof(configBlob));
+  sendMessage(TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP, configBlob, size);
+
+  //From here on tag records stream in, and commands mustn't flush them
+  if (msg[0] == ALL_GOOD)
+    _continuousReading = true;
+}
+
+//Assembles the MULTI_PROTOCOL_TAG_OP data that starts a continuous read
+//Returns the number of bytes put in blob
+//
+//This started life as a blob found by using the 'Transport Logs' option from the Universal
+//Reader Assistant and connecting the Nano eval kit from Thing Magic to the URA:
+//  00 00 01 22 00 00 05 07 22 10 00 1B 03 E8 01 FF
+//  [0, 1] 00 00 = Timeout, should be zero for true continuous reading
+//  [2] 01 = TM Option 1, for continuous reading
+//  [3] 22 = Sub command opcode
+//  [4, 5] 00 00 = Search flags, only 0x0001 is supported
+//  [6] 05 = Protocol ID (GEN2)
+//  [7] 07 = Length of the embedded command after its opcode
+//  [8] 22 = Embedded READ_TAG_ID_MULTIPLE
+//  [9] 10 = Option, 0x10 = metadata flags follow
+//  [10, 11] 00 1B = Search flags
+//  [12, 13] 03 E8 = RF on time in ms
+//  [14, 15] 01 FF = Metadata flags
+//With the duty cycle search flag set, the RF off time goes between the on time and the metadata flags.
+//With a filter, the access password and the Select come next.
+//An embedded read goes last, as a count of embedded commands (1) then a READ_TAG_DATA of its own:
+//  09 = Length after the opcode, 28 = READ_TAG_DATA, 00 00 = Timeout, 00 = Option,
+//  then bank, word address (4) and word count
+uint8_t RFID::buildReadCommand(const RFID_ReadConfig &config, uint8_t *blob)
+{
+  uint16_t searchFlags = config.searchFlags;
+  if (config.offTime > 0)
+    searchFlags |= TMR_SR_SEARCH_FLAG_DUTY_CYCLE_CONTROL;
+  else
+    searchFlags &= ~TMR_SR_SEARCH_FLAG_DUTY_CYCLE_CONTROL;
+
+  //The embedded read's data comes back in the data metadata field
+  uint16_t metadataFlags = config.metadataFlags;
+  if (config.readWords > 0)
+  {
+    searchFlags |= TMR_SR_SEARCH_FLAG_EMBEDDED_COMMAND;
+    metadataFlags |= TMR_TRD_METADATA_FLAG_DATA;
+  }
+  else
+    searchFlags &= ~TMR_SR_SEARCH_FLAG_EMBEDDED_COMMAND;
+
+  uint8_t spot = 0;
+  blob[spot++] = 0x00; //Timeout
+  blob[spot++] = 0x00;
+  blob[spot++] = 0x01; //Continuous reading
+  blob[spot++] = TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE;
+  blob[spot++] = 0x00; //Search flags
+  blob[spot++] = 0x00;
+  blob[spot++] = config.protocol;
+
+  uint8_t lengthSpot = spot++; //Filled in once the embedded command is done
+
+  blob[spot++] = TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE;
+  uint8_t optionSpot = spot++;
+  blob[optionSpot] = (metadataFlags != TMR_TRD_METADATA_FLAG_NONE) ? TMR_SR_GEN2_SINGULATION_OPTION_FLAG_METADATA : 0x00;
+  blob[spot++] = searchFlags >> 8;
+  blob[spot++] = searchFlags & 0xFF;
+  blob[spot++] = config.onTime >> 8;
+  blob[spot++] = config.onTime & 0xFF;
+
+  if (searchFlags & TMR_SR_SEARCH_FLAG_DUTY_CYCLE_CONTROL)
+  {
+    blob[spot++] = config.offTime >> 8;
+    blob[spot++] = config.offTime & 0xFF;
+  }
+
+  if (metadataFlags != TMR_TRD_METADATA_FLAG_NONE)
+  {
+    blob[spot++] = metadataFlags >> 8;
+    blob[spot++] = metadataFlags & 0xFF;
+  }
+
+  if (config.filter.isActive())
+  {
+    for (uint8_t x = 0; x < 4; x++)
+      blob[spot++] = 0x00; //Access password
+    spot += addSelect(config.filter, &blob[spot], blob[optionSpot]);
+  }
+
+  if (config.readWords > 0)
+  {
+    blob[spot++] = 0x01; //One embedded command
+    blob[spot++] = 0x09;
+    blob[spot++] = TMR_SR_OPCODE_READ_TAG_DATA;
+    blob[spot++] = 0x00; //Timeout
+    blob[spot++] = 0x00;
+    blob[spot++] = 0x00; //Option
+    blob[spot++] = config.readBank;
+    for (uint8_t x = 0; x < 4; x++)
+      blob[spot++] = config.readAddress >> (8 * (3 - x)) & 0xFF;
+    blob[spot++] = config.readWords;
+  }
+
+  blob[lengthSpot] = spot - lengthSpot - 2; //Everything after the embedded opcode
+
+  return (spot);
 }
 
 //Stop a continuous read
+//Tag records already on their way are handed to the tag callback while we wait for the module to
+//acknowledge. Assumes the module may be reading even if we didn't start it (sketch was reset).
 void RFID::stopReading()
 {
   //00 00 = Timeout, currently ignored
   //02 = Option - stop continuous reading
   uint8_t configBlob[] = {0x00, 0x00, 0x02};
 
-  sendMessage(TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP, configBlob, sizeof(configBlob), false); //Do not wait for response
+  _continuousReading = true;
+  sendMessage(TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP, configBlob, sizeof(configBlob));
+  _continuousReading = false;
+}
+
+//Run a timed inventory and leave the tags in the module's tag buffer
+//The module searches for searchTime ms and keeps one entry per unique tag, so nothing
+//crosses the serial link while it reads. Then pull the tags out with nextBufferedTag():
+//each GET_TAG_ID_BUFFER response carries as many records as fit in a frame.
+//metadataFlags picks what each record carries (TMR_TRD_METADATA_FLAG_...).
+//Only tags matching the filter from setTagFilter() (if any) are collected.
+//Returns RESPONSE_SUCCESS, even when no tags were found, or RESPONSE_FAIL
+uint8_t RFID::readTagsBuffered(uint16_t searchTime, uint16_t metadataFlags)
+{
+  //Don't mix this search with leftovers from the last one
+  if (_bufferNeedsClear == true && clearTagBuffer() != RESPONSE_SUCCESS)
+    return (RESPONSE_FAIL);
+
+  _bufferTagCount = 0;
+  _bufferTagsLeft = 0;
+  _bufferRecordsLeft = 0;
+  _bufferMetadata = metadataFlags;
+
+  //Option 00 = no metadata here, it comes with the buffer, then search flags and search time
+  //With a tag filter, the access password and the Select follow
+  uint16_t searchFlags = TMR_SR_SEARCH_FLAG_CONFIGURED_LIST | TMR_SR_SEARCH_FLAG_LARGE_TAG_POPULATION;
+  uint8_t data[5 + 4 + 5 + RFID_MAX_FILTER_BYTES] = {0x00,
+                                                    (uint8_t)(searchFlags >> 8), (uint8_t)(searchFlags & 0xFF),
+                                                    (uint8_t)(searchTime >> 8), (uint8_t)(searchTime & 0xFF)};
+  uint8_t size = 5;
+  if (_tagFilter.isActive())
+  {
+    size += 4; //Access password, already zero
+    size += addSelect(_tagFilter, &data[size], data[0]);
+  }
+
+  //The module doesn't answer until the search is over
+  uint32_t timeOut = (uint32_t)searchTime + COMMAND_TIME_OUT;
+  if (timeOut > 0xFFFF)
+    timeOut = 0xFFFF;
+
+  _bufferNeedsClear = true;
+  sendMessage(TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE, data, size, timeOut);
+
+  if (msg[0] != ALL_GOOD)
+    return (RESPONSE_FAIL);
+
+  uint16_t status = (msg[3] << 8) | msg[4];
+  if (status == 0x0400) //No tags found
+    return (RESPONSE_SUCCESS);
+  if (status != 0x0000 || msg[1] < 4)
+    return (RESPONSE_FAIL);
+
+  //Response: [5] option, [6, 7] search flags, then the tag count
+  //The count is 1 byte, or 4 with large tag population support, so go by the length
+  uint8_t spot = 8;
+  _bufferTagCount = readField(msg, spot, msg[1] - 3 > 4 ? 4 : msg[1] - 3);
+  _bufferTagsLeft = _bufferTagCount;
+
+  return (RESPONSE_SUCCESS);
+}
+
+//Loads the next tag from the last readTagsBuffered() into getTagRecord()
+//Fetches another frame of records from the module whenever the current one runs out.
+//Returns false once every tag has been handed out, and clears the module's buffer then.
+//Don't send other commands until this returns false, they would overwrite msg.
+bool RFID::nextBufferedTag(uint16_t timeOut)
+{
+  if (_bufferRecordsLeft == 0)
+  {
+    if (_bufferTagsLeft == 0)
+    {
+      if (_bufferNeedsClear == true)
+        clearTagBuffer();
+      return (false);
+    }
+
+    uint8_t data[] = {(uint8_t)(_bufferMetadata >> 8), (uint8_t)(_bufferMetadata & 0xFF), 0x00}; //Metadata flags, read options
+    sendMessage(TMR_SR_OPCODE_GET_TAG_ID_BUFFER, data, sizeof(data), timeOut);
+
+    //Response: [5, 6] metadata flags, [7] read options, [8] number of records, then the records
+    if (msg[0] != ALL_GOOD || msg[3] != 0x00 || msg[4] != 0x00 || msg[1] < 4 || msg[8] == 0)
+    {
+      _bufferTagsLeft = 0; //Give up on the rest. The next search clears the buffer.
+      return (false);
+    }
+
+    _bufferRecordsLeft = msg[8];
+    _bufferSpot = 9;
+  }
+
+  uint8_t end = msg[1] + 5; //First CRC byte
+  uint16_t metadataFlags = (msg[5] << 8) | msg[6]; //Go by what the module says it sent
+  uint8_t spot = _bufferSpot;
+
+  if (decodeMetadata(metadataFlags, spot, end) == false || decodeEPC(spot, end) == false)
+  {
+    _bufferRecordsLeft = 0;
+    _bufferTagsLeft = 0;
+    return (false);
+  }
+
+  _bufferSpot = spot;
+  _bufferRecordsLeft--;
+  if (_bufferTagsLeft > 0)
+    _bufferTagsLeft--;
+
+  return (true);
+}
+
+//Empty the module's tag buffer
+uint8_t RFID::clearTagBuffer(void)
+{
+  sendMessage(TMR_SR_OPCODE_CLEAR_TAG_ID_BUFFER);
+
+  _bufferTagsLeft = 0;
+  _bufferRecordsLeft = 0;
+
+  if (msg[0] != ALL_GOOD || msg[3] != 0x00 || msg[4] != 0x00)
+    return (RESPONSE_FAIL);
+
+  _bufferNeedsClear = false;
+  return (RESPONSE_SUCCESS);
 }
 
 // Set one of the GPIO pins as INPUT or OUTPUT
@@ -185,20 +524,158 @@ void RFID::setRegion(uint8_t region)
   sendMessage(TMR_SR_OPCODE_SET_REGION, &region, sizeof(region));
 }
 
-//Sets the TX and RX antenna ports to 01
-//Because the Nano module has only one antenna port, it is not user configurable
-void RFID::setAntennaPort(void)
+//Load a custom hop table: each channel is 4 bytes of kHz, MSB first
+//902750 = 902.75MHz
+uint8_t RFID::setHopTable(const uint32_t *freqs, uint8_t count)
+{
+  if (count == 0 || count > RFID_MAX_HOP_CHANNELS)
+    return (ERROR_INVALID_PARAMETER);
+
+  uint8_t data[RFID_MAX_HOP_CHANNELS * 4];
+  for (uint8_t x = 0; x < count; x++)
+    for (uint8_t y = 0; y < 4; y++)
+      data[x * 4 + y] = (uint8_t)(freqs[x] >> (24 - y * 8));
+
+  sendMessage(TMR_SR_OPCODE_SET_FREQ_HOP_TABLE, data, count * 4);
+
+  if (msg[0] != ALL_GOOD || msg[3] != 0x00 || msg[4] != 0x00)
+    return (RESPONSE_FAIL);
+  return (RESPONSE_SUCCESS);
+}
+
+//Response: [5] onward, 4 bytes per channel
+//Copies as many channels as fit in count
+uint8_t RFID::getHopTable(uint32_t *freqs, uint8_t &count)
+{
+  sendMessage(TMR_SR_OPCODE_GET_FREQ_HOP_TABLE);
+
+  if (msg[0] != ALL_GOOD || msg[3] != 0x00 || msg[4] != 0x00)
+    return (RESPONSE_FAIL);
+
+  uint8_t channels = msg[1] / 4;
+  if (channels > count)
+    channels = count;
+
+  for (uint8_t x = 0; x < channels; x++)
+  {
+    uint8_t spot = 5 + x * 4;
+    freqs[x] = (uint32_t)msg[spot] << 24 | (uint32_t)msg[spot + 1] << 16 | (uint32_t)msg[spot + 2] << 8 | msg[spot + 3];
+  }
+  count = channels;
+  return (RESPONSE_SUCCESS);
+}
+
+//The hop time shares the hop table's opcodes: option 0x01 then the time in ms
+uint8_t RFID::setHopTime(uint32_t hopTime)
+{
+  uint8_t data[] = {0x01, (uint8_t)(hopTime >> 24), (uint8_t)(hopTime >> 16), (uint8_t)(hopTime >> 8), (uint8_t)hopTime};
+
+  sendMessage(TMR_SR_OPCODE_SET_FREQ_HOP_TABLE, data, sizeof(data));
+
+  if (msg[0] != ALL_GOOD || msg[3] != 0x00 || msg[4] != 0x00)
+    return (RESPONSE_FAIL);
+  return (RESPONSE_SUCCESS);
+}
+
+//Response: [5] option, [6 to 9] hop time
+uint8_t RFID::getHopTime(uint32_t &hopTime)
+{
+  uint8_t data[] = {0x01};
+
+  sendMessage(TMR_SR_OPCODE_GET_FREQ_HOP_TABLE, data, sizeof(data));
+
+  if (msg[0] != ALL_GOOD || msg[3] != 0x00 || msg[4] != 0x00 || msg[1] < 5)
+    return (RESPONSE_FAIL);
+
+  hopTime = (uint32_t)msg[6] << 24 | (uint32_t)msg[7] << 16 | (uint32_t)msg[8] << 8 | msg[9];
+  return (RESPONSE_SUCCESS);
+}
+
+//Sets the TX and RX antenna ports, 1 and 1 unless told otherwise
+//The Nano module has only one antenna port
+uint8_t RFID::setAntennaPort(uint8_t txPort, uint8_t rxPort)
 {
-  uint8_t configBlob[] = {0x01, 0x01}; //TX port = 1, RX port = 1
+  if (validAntennaPort(txPort) == false || validAntennaPort(rxPort) == false)
+    return (ERROR_INVALID_PARAMETER);
+
+  uint8_t configBlob[] = {txPort, rxPort};
   sendMessage(TMR_SR_OPCODE_SET_ANTENNA_PORT, configBlob, sizeof(configBlob));
+
+  if (msg[0] != ALL_GOOD || msg[3] != 0x00 || msg[4] != 0x00)
+    return (RESPONSE_FAIL);
+  return (RESPONSE_SUCCESS);
 }
 
 //This was found in the logs. It seems to be very close to setAntennaPort
 //Search serial_reader_l3.c for cmdSetAntennaSearchList for more info
 void RFID::setAntennaSearchList(void)
 {
-  uint8_t configBlob[] = {0x02, 0x01, 0x01}; //logical antenna list option, TX port = 1, RX port = 1
-  sendMessage(TMR_SR_OPCODE_SET_ANTENNA_PORT, configBlob, sizeof(configBlob));
+  uint8_t port = 1;
+  setAntennaSearchList(&port, 1);
+}
+
+//Logical antenna list option, then TX port and RX port for each antenna
+//Reads with TMR_SR_SEARCH_FLAG_CONFIGURED_LIST (startReading() sets it) cycle through the list
+uint8_t RFID::setAntennaSearchList(const uint8_t *ports, uint8_t portCount)
+{
+  if (portCount == 0 || portCount > RFID_MAX_ANTENNA_PORTS)
+    return (ERROR_INVALID_PARAMETER);
+
+  uint8_t configBlob[1 + RFID_MAX_ANTENNA_PORTS * 2];
+  configBlob[0] = TMR_SR_ANTENNA_OPTION_SEARCH_LIST;
+  for (uint8_t x = 0; x < portCount; x++)
+  {
+    if (validAntennaPort(ports[x]) == false)
+      return (ERROR_INVALID_PARAMETER);
+    configBlob[1 + x * 2] = ports[x]; //TX
+    configBlob[2 + x * 2] = ports[x]; //RX
+  }
+
+  sendMessage(TMR_SR_OPCODE_SET_ANTENNA_PORT, configBlob, 1 + portCount * 2);
+
+  if (msg[0] != ALL_GOOD || msg[3] != 0x00 || msg[4] != 0x00)
+    return (RESPONSE_FAIL);
+  return (RESPONSE_SUCCESS);
+}
+
+//Port powers option, then port, read power and write power for each port
+//Powers are capped at 27.00 dBm like setReadPower()
+uint8_t RFID::setAntennaPortPowers(const RFID_AntennaPort *ports, uint8_t portCount)
+{
+  if (portCount == 0 || portCount > RFID_MAX_ANTENNA_PORTS)
+    return (ERROR_INVALID_PARAMETER);
+
+  uint8_t configBlob[1 + RFID_MAX_ANTENNA_PORTS * 5];
+  uint8_t spot = 0;
+  configBlob[spot++] = TMR_SR_ANTENNA_OPTION_PORT_POWERS;
+  for (uint8_t x = 0; x < portCount; x++)
+  {
+    if (validAntennaPort(ports[x].port) == false)
+      return (ERROR_INVALID_PARAMETER);
+
+    int16_t readPower = (ports[x].readPower > 2700) ? 2700 : ports[x].readPower;
+    int16_t writePower = (ports[x].writePower > 2700) ? 2700 : ports[x].writePower;
+    configBlob[spot++] = ports[x].port;
+    configBlob[spot++] = readPower >> 8;
+    configBlob[spot++] = readPower & 0xFF;
+    configBlob[spot++] = writePower >> 8;
+    configBlob[spot++] = writePower & 0xFF;
+  }
+
+  sendMessage(TMR_SR_OPCODE_SET_ANTENNA_PORT, configBlob, spot);
+
+  if (msg[0] != ALL_GOOD || msg[3] != 0x00 || msg[4] != 0x00)
+    return (RESPONSE_FAIL);
+  return (RESPONSE_SUCCESS);
+}
+
+bool RFID::validAntennaPort(uint8_t port)
+{
+  if (port == 0 || port > RFID_MAX_ANTENNA_PORTS)
+    return (false);
+  if (port != 1 && _moduleType == ThingMagic_M6E_NANO)
+    return (false);
+  return (true);
 }
 
 //Sets the protocol of the module
@@ -258,6 +735,287 @@ void RFID::getOptionalParameters(uint8_t option1, uint8_t option2)
   sendMessage(TMR_SR_OPCODE_GET_READER_OPTIONAL_PARAMS, data, sizeof(data));
 }
 
+//Gets a protocol parameter from the module
+//option1 is the protocol (0x05 = GEN2), option2 the key. The answer is left in msg.
+void RFID::getProtocolParameters(uint8_t option1, uint8_t option2)
+{
+  uint8_t data[2];
+  data[0] = option1;
+  data[1] = option2;
+  sendMessage(TMR_SR_OPCODE_GET_PROTOCOL_PARAM, data, sizeof(data));
+}
+
+RFID_Gen2Parameters RFID_Gen2Parameters::maxThroughput(void)
+{
+  RFID_Gen2Parameters parameters;
+  parameters.session = ThingMagic_Gen2Session_S0;
+  parameters.target = ThingMagic_Gen2Target_A;
+  parameters.q = 2;
+  parameters.encoding = ThingMagic_Gen2Encoding_FM0;
+  parameters.linkFrequency = ThingMagic_Gen2LinkFrequency_640kHz;
+  parameters.tari = ThingMagic_Gen2Tari_25us;
+  return (parameters);
+}
+
+RFID_Gen2Parameters RFID_Gen2Parameters::densePopulation(void)
+{
+  RFID_Gen2Parameters parameters;
+  parameters.session = ThingMagic_Gen2Session_S2;
+  parameters.target = ThingMagic_Gen2Target_A;
+  parameters.q = RFID_GEN2_DYNAMIC_Q;
+  parameters.encoding = ThingMagic_Gen2Encoding_M4;
+  parameters.linkFrequency = ThingMagic_Gen2LinkFrequency_250kHz;
+  parameters.tari = ThingMagic_Gen2Tari_25us;
+  return (parameters);
+}
+
+//Sends each Gen2 setting with its own SET_PROTOCOL_PARAM, stopping at the first the module turns down
+//Tari goes before the link frequency: some pairings are only allowed once the other has changed
+uint8_t RFID::setProtocolParameters(const RFID_Gen2Parameters &parameters)
+{
+  if (validGen2Parameters(parameters) == false)
+    return (ERROR_INVALID_PARAMETER);
+
+  uint8_t status = setGen2Session(parameters.session);
+  if (status == RESPONSE_SUCCESS)
+    status = setGen2Target(parameters.target);
+  if (status == RESPONSE_SUCCESS)
+    status = setGen2Q(parameters.q);
+  if (status == RESPONSE_SUCCESS)
+    status = setGen2Tari(parameters.tari);
+  if (status == RESPONSE_SUCCESS)
+    status = setGen2LinkFrequency(parameters.linkFrequency);
+  if (status == RESPONSE_SUCCESS)
+    status = setGen2Encoding(parameters.encoding);
+  return (status);
+}
+
+uint8_t RFID::getProtocolParameters(RFID_Gen2Parameters &parameters)
+{
+  uint8_t status = getGen2Session(parameters.session);
+  if (status == RESPONSE_SUCCESS)
+    status = getGen2Target(parameters.target);
+  if (status == RESPONSE_SUCCESS)
+    status = getGen2Q(parameters.q);
+  if (status == RESPONSE_SUCCESS)
+    status = getGen2Tari(parameters.tari);
+  if (status == RESPONSE_SUCCESS)
+    status = getGen2LinkFrequency(parameters.linkFrequency);
+  if (status == RESPONSE_SUCCESS)
+    status = getGen2Encoding(parameters.encoding);
+  return (status);
+}
+
+uint8_t RFID::setGen2Session(ThingMagic_Gen2Session_t session)
+{
+  RFID_Gen2Parameters parameters;
+  parameters.session = session;
+  if (validGen2Parameters(parameters) == false)
+    return (ERROR_INVALID_PARAMETER);
+
+  uint8_t value = session;
+  return (setGen2Parameter(TMR_SR_GEN2_CONFIGURATION_SESSION, &value, 1));
+}
+
+uint8_t RFID::getGen2Session(ThingMagic_Gen2Session_t &session)
+{
+  uint8_t value;
+  if (getGen2Parameter(TMR_SR_GEN2_CONFIGURATION_SESSION, &value, 1) != RESPONSE_SUCCESS)
+    return (RESPONSE_FAIL);
+
+  session = (ThingMagic_Gen2Session_t)value;
+  return (RESPONSE_SUCCESS);
+}
+
+//Target goes over as two bytes: [0] 01 = single target, 00 = swap every round, [1] 00 = start with A, 01 = start with B
+uint8_t RFID::setGen2Target(ThingMagic_Gen2Target_t target)
+{
+  RFID_Gen2Parameters parameters;
+  parameters.target = target;
+  if (validGen2Parameters(parameters) == false)
+    return (ERROR_INVALID_PARAMETER);
+
+  uint8_t value[2];
+  value[0] = (target == ThingMagic_Gen2Target_A || target == ThingMagic_Gen2Target_B) ? 0x01 : 0x00;
+  value[1] = (target == ThingMagic_Gen2Target_B || target == ThingMagic_Gen2Target_BA) ? 0x01 : 0x00;
+  return (setGen2Parameter(TMR_SR_GEN2_CONFIGURATION_TARGET, value, sizeof(value)));
+}
+
+uint8_t RFID::getGen2Target(ThingMagic_Gen2Target_t &target)
+{
+  uint8_t value[2];
+  if (getGen2Parameter(TMR_SR_GEN2_CONFIGURATION_TARGET, value, sizeof(value)) != RESPONSE_SUCCESS)
+    return (RESPONSE_FAIL);
+
+  if (value[0] == 0x01)
+    target = (value[1] == 0x00) ? ThingMagic_Gen2Target_A : ThingMagic_Gen2Target_B;
+  else
+    target = (value[1] == 0x00) ? ThingMagic_Gen2Target_AB : ThingMagic_Gen2Target_BA;
+  return (RESPONSE_SUCCESS);
+}
+
+//Q goes over as 00 for dynamic, or 01 then the Q value for static
+uint8_t RFID::setGen2Q(uint8_t q)
+{
+  RFID_Gen2Parameters parameters;
+  parameters.q = q;
+  if (validGen2Parameters(parameters) == false)
+    return (ERROR_INVALID_PARAMETER);
+
+  uint8_t value[2];
+  if (q == RFID_GEN2_DYNAMIC_Q)
+  {
+    value[0] = 0x00;
+    return (setGen2Parameter(TMR_SR_GEN2_CONFIGURATION_Q, value, 1));
+  }
+
+  value[0] = 0x01;
+  value[1] = q;
+  return (setGen2Parameter(TMR_SR_GEN2_CONFIGURATION_Q, value, 2));
+}
+
+uint8_t RFID::getGen2Q(uint8_t &q)
+{
+  uint8_t value;
+  if (getGen2Parameter(TMR_SR_GEN2_CONFIGURATION_Q, &value, 1) != RESPONSE_SUCCESS)
+    return (RESPONSE_FAIL);
+
+  if (value == 0x00)
+    q = RFID_GEN2_DYNAMIC_Q;
+  else if (msg[1] >= 4) //Protocol, key, type and Q
+    q = msg[8];
+  else
+    return (RESPONSE_FAIL);
+  return (RESPONSE_SUCCESS);
+}
+
+uint8_t RFID::setGen2Encoding(ThingMagic_Gen2Encoding_t encoding)
+{
+  RFID_Gen2Parameters parameters;
+  parameters.encoding = encoding;
+  if (validGen2Parameters(parameters) == false)
+    return (ERROR_INVALID_PARAMETER);
+
+  uint8_t value = encoding;
+  return (setGen2Parameter(TMR_SR_GEN2_CONFIGURATION_TAGENCODING, &value, 1));
+}
+
+uint8_t RFID::getGen2Encoding(ThingMagic_Gen2Encoding_t &encoding)
+{
+  uint8_t value;
+  if (getGen2Parameter(TMR_SR_GEN2_CONFIGURATION_TAGENCODING, &value, 1) != RESPONSE_SUCCESS)
+    return (RESPONSE_FAIL);
+
+  encoding = (ThingMagic_Gen2Encoding_t)value;
+  return (RESPONSE_SUCCESS);
+}
+
+uint8_t RFID::setGen2LinkFrequency(ThingMagic_Gen2LinkFrequency_t linkFrequency)
+{
+  RFID_Gen2Parameters parameters;
+  parameters.linkFrequency = linkFrequency;
+  if (validGen2Parameters(parameters) == false)
+    return (ERROR_INVALID_PARAMETER);
+
+  uint8_t value = linkFrequency;
+  return (setGen2Parameter(TMR_SR_GEN2_CONFIGURATION_LINKFREQUENCY, &value, 1));
+}
+
+uint8_t RFID::getGen2LinkFrequency(ThingMagic_Gen2LinkFrequency_t &linkFrequency)
+{
+  uint8_t value;
+  if (getGen2Parameter(TMR_SR_GEN2_CONFIGURATION_LINKFREQUENCY, &value, 1) != RESPONSE_SUCCESS)
+    return (RESPONSE_FAIL);
+
+  linkFrequency = (ThingMagic_Gen2LinkFrequency_t)value;
+  return (RESPONSE_SUCCESS);
+}
+
+uint8_t RFID::setGen2Tari(ThingMagic_Gen2Tari_t tari)
+{
+  RFID_Gen2Parameters parameters;
+  parameters.tari = tari;
+  if (validGen2Parameters(parameters) == false)
+    return (ERROR_INVALID_PARAMETER);
+
+  uint8_t value = tari;
+  return (setGen2Parameter(TMR_SR_GEN2_CONFIGURATION_TARI, &value, 1));
+}
+
+uint8_t RFID::getGen2Tari(ThingMagic_Gen2Tari_t &tari)
+{
+  uint8_t value;
+  if (getGen2Parameter(TMR_SR_GEN2_CONFIGURATION_TARI, &value, 1) != RESPONSE_SUCCESS)
+    return (RESPONSE_FAIL);
+
+  tari = (ThingMagic_Gen2Tari_t)value;
+  return (RESPONSE_SUCCESS);
+}
+
+//True if the module type can take every setting
+//The M6E Nano runs Tari 25us only and has no 320kHz link. The M7E Hecto takes them all.
+bool RFID::validGen2Parameters(const RFID_Gen2Parameters &parameters)
+{
+  if (parameters.session > ThingMagic_Gen2Session_S3)
+    return (false);
+  if (parameters.target > ThingMagic_Gen2Target_BA)
+    return (false);
+  if (parameters.q > RFID_GEN2_MAX_Q && parameters.q != RFID_GEN2_DYNAMIC_Q)
+    return (false);
+  if (parameters.encoding > ThingMagic_Gen2Encoding_M8)
+    return (false);
+
+  switch (parameters.linkFrequency)
+  {
+  case ThingMagic_Gen2LinkFrequency_250kHz:
+  case ThingMagic_Gen2LinkFrequency_640kHz:
+    break;
+  case ThingMagic_Gen2LinkFrequency_320kHz:
+    if (_moduleType == ThingMagic_M6E_NANO)
+      return (false);
+    break;
+  default:
+    return (false);
+  }
+
+  if (parameters.tari > ThingMagic_Gen2Tari_6_25us)
+    return (false);
+  if (parameters.tari != ThingMagic_Gen2Tari_25us && _moduleType == ThingMagic_M6E_NANO)
+    return (false);
+
+  return (true);
+}
+
+//SET_PROTOCOL_PARAM: [0] Protocol, [1] Key, then the value
+uint8_t RFID::setGen2Parameter(uint8_t key, const uint8_t *value, uint8_t size)
+{
+  uint8_t data[2 + 2];
+  data[0] = TMR_TAG_PROTOCOL_GEN2;
+  data[1] = key;
+  memcpy(&data[2], value, size);
+
+  sendMessage(TMR_SR_OPCODE_SET_PROTOCOL_PARAM, data, 2 + size);
+
+  if (msg[0] != ALL_GOOD || msg[3] != 0x00 || msg[4] != 0x00)
+    return (RESPONSE_FAIL);
+  return (RESPONSE_SUCCESS);
+}
+
+//GET_PROTOCOL_PARAM answers with the protocol and key, then the value
+//Copies the first size bytes of the value
+uint8_t RFID::getGen2Parameter(uint8_t key, uint8_t *value, uint8_t size)
+{
+  getProtocolParameters(TMR_TAG_PROTOCOL_GEN2, key);
+
+  if (msg[0] != ALL_GOOD || msg[3] != 0x00 || msg[4] != 0x00)
+    return (RESPONSE_FAIL);
+  if (msg[1] < 2 + size || msg[6] != key)
+    return (RESPONSE_FAIL);
+
+  memcpy(value, &msg[7], size);
+  return (RESPONSE_SUCCESS);
+}
+
 //Get the version number from the module
 void RFID::getVersion(void)
 {
@@ -267,7 +1025,8 @@ void RFID::getVersion(void)
 //Set the read TX power
 //Maximum power is 2700 = 27.00 dBm
 //1005 = 10.05dBm
-void RFID::setReadPower(int16_t powerSetting)
+//Returns RESPONSE_SUCCESS, or RESPONSE_FAIL if the module didn't take it. msg holds the response.
+uint8_t RFID::setReadPower(int16_t powerSetting)
 {
   if (powerSetting > 2700)
     powerSetting = 2700; //Limit to 27dBm
@@ -279,6 +1038,10 @@ void RFID::setReadPower(int16_t powerSetting)
     data[x] = (uint8_t)(powerSetting >> (8 * (size - 1 - x)));
 
   sendMessage(TMR_SR_OPCODE_SET_READ_TX_POWER, data, size);
+
+  if (msg[0] != ALL_GOOD || msg[3] != 0x00 || msg[4] != 0x00)
+    return (RESPONSE_FAIL);
+  return (RESPONSE_SUCCESS);
 }
 
 //Get the read TX power
@@ -312,6 +1075,20 @@ void RFID::getWritePower()
   sendMessage(TMR_SR_OPCODE_GET_WRITE_TX_POWER, data, sizeof(data));
 }
 
+//Get the module's temperature in C
+//Works during a continuous read too. Tag records that arrive meanwhile go to the tag callback.
+uint8_t RFID::getTemperature(int8_t &temperature)
+{
+  sendMessage(TMR_SR_OPCODE_GET_TEMPERATURE);
+
+  //Response: [5] Temperature
+  if (msg[0] != ALL_GOOD || msg[3] != 0x00 || msg[4] != 0x00 || msg[1] < 1)
+    return (RESPONSE_FAIL);
+
+  temperature = (int8_t)msg[5];
+  return (RESPONSE_SUCCESS);
+}
+
 //Read a single EPC
 //Caller must provide an array for EPC to be stored in
 uint8_t RFID::readTagEPC(uint8_t *epc, uint8_t &epcLength, uint16_t timeOut)
@@ -323,7 +1100,7 @@ uint8_t RFID::readTagEPC(uint8_t *epc, uint8_t &epcLength, uint16_t timeOut)
 }
 
 //This writes a new EPC to the first tag it detects
-//Use with caution. This function doesn't control which tag hears the command.
+//Use with caution. Unless setTagFilter() narrows it down, the first tag to answer gets the new EPC.
 uint8_t RFID::writeTagEPC(char *newID, uint8_t newIDLength, uint16_t timeOut)
 {
   uint8_t bank = 0x01;    //EPC memory
@@ -333,7 +1110,7 @@ uint8_t RFID::writeTagEPC(char *newID, uint8_t newIDLength, uint16_t timeOut)
 }
 
 //This reads the user data area of the tag. 0 to 64 bytes are normally available.
-//Use with caution. The module can't control which tag hears the command.
+//Use setTagFilter() to pick which tag answers when more than one is in the field.
 //TODO Add support for accessPassword
 uint8_t RFID::readUserData(uint8_t *userData, uint8_t &userDataLength, uint16_t timeOut)
 {
@@ -345,7 +1122,8 @@ uint8_t RFID::readUserData(uint8_t *userData, uint8_t &userDataLength, uint16_t
 
 //This writes data to the tag. 0, 4, 16 or 64 bytes may be available.
 //Writes to the first spot 0x00 and fills up as much of the bytes as user provides
-//Use with caution. Function doesn't control which tag hears the command.
+//It all goes in one command, so a long write with a tag filter set can be turned down (see writeData())
+//Use with caution. Unless setTagFilter() narrows it down, the first tag to answer gets the data.
 uint8_t RFID::writeUserData(uint8_t *userData, uint8_t userDataLength, uint16_t timeOut)
 {
   uint8_t bank = 0x03; //User memory
@@ -411,11 +1189,62 @@ uint8_t RFID::readUID(uint8_t *tid, uint8_t &tidLength, uint16_t timeOut)
   return (readData(bank, address, tid, tidLength, timeOut));
 }
 
-//Writes a data array to a given bank and address
-//Allows for writing of passwords and user data
-//TODO Add support for accessPassword
-//TODO Add support for writing to specific tag
-uint8_t RFID::writeData(uint8_t bank, uint32_t address, uint8_t *dataToRecord, uint8_t dataLengthToRecord, uint16_t timeOut)
+//Points the filter at a bank and loads the mask. Mask bits past maskBits are ignored.
+RFID_TagFilter &RFID_TagFilter::setMask(uint8_t memoryBank, uint32_t pointer, const uint8_t *maskBytes, uint8_t maskBits)
+{
+  if (maskBits > RFID_MAX_FILTER_BYTES * 8)
+    maskBits = RFID_MAX_FILTER_BYTES * 8;
+
+  bank = memoryBank;
+  bitPointer = pointer;
+  bitLength = maskBits;
+  memcpy(mask, maskBytes, (maskBits + 7) / 8);
+  return (*this);
+}
+
+//Adds the Select part of a tag command to data and marks it in the option byte
+//The caller puts the password in front: access password for most commands, kill password for kill.
+//  [0 to 3] Bit pointer
+//  [4] Mask length in bits
+//  [5...] Mask, padded out to whole bytes
+//Returns the number of bytes added, at most 5 + RFID_MAX_FILTER_BYTES. Nothing is added if filter isn't active.
+uint8_t RFID::addSelect(const RFID_TagFilter &filter, uint8_t *data, uint8_t &option)
+{
+  switch (filter.bank)
+  {
+  case TMR_GEN2_BANK_EPC:
+    option |= TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_ADDRESSED_EPC;
+    break;
+  case TMR_GEN2_BANK_TID:
+    option |= TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_TID;
+    break;
+  case TMR_GEN2_BANK_USER:
+    option |= TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_USER_MEM;
+    break;
+  default:
+    return (0);
+  }
+
+  if (filter.invert == true)
+    option |= TMR_SR_GEN2_SINGULATION_OPTION_INVERSE_SELECT_BIT;
+
+  uint8_t spot = 0;
+  for (uint8_t x = 0; x < 4; x++)
+    data[spot++] = filter.bitPointer >> (8 * (3 - x)) & 0xFF;
+  data[spot++] = filter.bitLength;
+
+  uint8_t maskBytes = (filter.bitLength + 7) / 8;
+  memcpy(&data[spot], filter.mask, maskBytes);
+  spot += maskBytes;
+
+  return (spot);
+}
+
+//Writes a data array to a given bank and address
+//Allows for writing of passwords and user data
+//Only a tag matching the filter from setTagFilter() (if any) will take the write
+//TODO Add support for accessPassword
+uint8_t RFID::writeData(uint8_t bank, uint32_t address, uint8_t *dataToRecord, uint8_t dataLengthToRecord, uint16_t timeOut)
 {
   //Example: FF  0A  24  03  E8  00  00  00  00  00  03  00  EE  58  9D
   //FF 0A 24 = Header, LEN, Opcode
@@ -425,8 +1254,10 @@ uint8_t RFID::writeData(uint8_t bank, uint32_t address, uint8_t *dataToRecord, u
   //03 = Bank
   //00 EE = Data
   //58 9D = CRC
+  //With a tag filter, the access password and the Select go between the bank and the data
+  //Returns ERROR_INVALID_PARAMETER, without sending, if all that won't fit in one frame
 
-  uint8_t data[8 + dataLengthToRecord];
+  uint8_t data[MAX_MSG_SIZE - 5]; //Less the header, length, opcode and CRC
 
   //Pre-load array options
   data[0] = timeOut >> 8 & 0xFF; //Timeout msB in ms
@@ -443,11 +1274,22 @@ uint8_t RFID::writeData(uint8_t bank, uint32_t address, uint8_t *dataToRecord, u
   //Bank 3 = User Memory
   data[7] = bank;
 
+  uint8_t size = 8;
+  if (_tagFilter.isActive())
+  {
+    for (uint8_t x = 0; x < 4; x++)
+      data[size++] = 0x00; //Access password
+    size += addSelect(_tagFilter, &data[size], data[2]);
+  }
+
+  if (dataLengthToRecord > sizeof(data) - size)
+    return (ERROR_INVALID_PARAMETER);
+
   //Splice data into array
   for (uint8_t x = 0; x < dataLengthToRecord; x++)
-    data[8 + x] = dataToRecord[x];
+    data[size++] = dataToRecord[x];
 
-  sendMessage(TMR_SR_OPCODE_WRITE_TAG_DATA, data, sizeof(data), timeOut);
+  sendMessage(TMR_SR_OPCODE_WRITE_TAG_DATA, data, size, timeOut);
 
   if (msg[0] == ALL_GOOD) //We received a good response
   {
@@ -461,11 +1303,275 @@ uint8_t RFID::writeData(uint8_t bank, uint32_t address, uint8_t *dataToRecord, u
   return (RESPONSE_FAIL);
 }
 
+//Writes length bytes to a bank, starting wordAddress words in, in as few commands as the tag allows
+//Gen2 BlockWrite puts several words on the tag per command. How many depends on the chip, so
+//the first block that a tag turns down halves the block size, down to 1 word, and after that
+//WRITE_TAG_DATA is used. What works is remembered for the next call (see getBlockWriteSize()),
+//so a run of tags of the same type only pays for finding out once.
+//An odd length leaves the other byte of the last word as it was on the tag.
+//With verify, everything is read back afterwards and compared.
+//Only a tag matching the filter from setTagFilter() (if any) is written.
+uint8_t RFID::writeBlocks(uint8_t bank, uint32_t wordAddress, const uint8_t *data, uint16_t length, boolean verify, uint16_t timeOut)
+{
+  uint16_t wordsLeft = length / 2;
+  uint32_t address = wordAddress;
+  const uint8_t *spot = data;
+
+  uint8_t lastWord[2];
+  if (length & 0x01)
+  {
+    //Fill in the other half of the last word from the tag
+    bool rejected;
+    if (readTagWords(bank, wordAddress + wordsLeft, 1, timeOut, rejected) == false)
+      return (RESPONSE_FAIL);
+    lastWord[0] = data[length - 1];
+    lastWord[1] = msg[9];
+    wordsLeft++;
+  }
+
+  while (wordsLeft > 0)
+  {
+    uint8_t chunk = (_blockWriteWords > 0) ? _blockWriteWords : RFID_MAX_BLOCK_WORDS;
+    if (chunk > wordsLeft)
+      chunk = wordsLeft;
+
+    //The padded last word goes on its own
+    const uint8_t *words = spot;
+    if ((length & 0x01) && wordsLeft == 1)
+      words = lastWord;
+    else if ((length & 0x01) && chunk == wordsLeft)
+      chunk--;
+
+    uint16_t status = writeTagWords(_blockWriteWords > 0, bank, address, words, chunk, timeOut);
+    if (status == 0x0000)
+    {
+      address += chunk;
+      spot += chunk * 2;
+      wordsLeft -= chunk;
+      continue;
+    }
+
+    if (_blockWriteWords == 0)
+      return (RESPONSE_FAIL); //Plain write failed, nothing left to try
+
+    if ((status & 0xFF00) == 0x0100)
+      _blockWriteWords = 0; //Module doesn't know the command
+    else if (status == 0x0420 || status == 0x042F || status == 0x0430)
+      _blockWriteWords /= 2; //Gen2 other, non-specific or unknown error: most likely the block size
+    else
+      return (RESPONSE_FAIL); //No tag, locked memory, out of range...
+  }
+
+  if (verify == false)
+    return (RESPONSE_SUCCESS);
+
+  //Read it all back, as many words per read as fit
+  uint16_t checked = 0;
+  while (checked < length)
+  {
+    uint16_t bytes = length - checked;
+    if (bytes > RFID_MAX_READ_WORDS * 2)
+      bytes = RFID_MAX_READ_WORDS * 2;
+
+    bool rejected;
+    if (readTagWords(bank, wordAddress + checked / 2, (bytes + 1) / 2, timeOut, rejected) == false)
+      return (RESPONSE_FAIL);
+    if (memcmp(&msg[8], &data[checked], bytes) != 0)
+      return (RESPONSE_FAIL);
+    checked += bytes;
+  }
+
+  return (RESPONSE_SUCCESS);
+}
+
+//Puts wordCount words on the tag with one BlockWrite or WRITE_TAG_DATA command
+//Returns the module's status word (0x0000 = written), or 0xFFFF if the module didn't answer
+//
+//BlockWrite goes through WRITE_TAG_SPECIFIC:
+//  [0, 1] Timeout, [2] Chip type (00 = any), [3] Option (40, plus the Select type), [4] 00, [5] C7 = BlockWrite
+//  then the access password and Select if filtering, then
+//  [0] Write flags, [1] Bank, [2 to 5] Word address, [6] Word count, then the words
+//WRITE_TAG_DATA is laid out as in writeData()
+uint16_t RFID::writeTagWords(boolean blockWrite, uint8_t bank, uint32_t address, const uint8_t *words, uint8_t wordCount, uint16_t timeOut)
+{
+  uint8_t data[13 + 4 + 5 + RFID_MAX_FILTER_BYTES + RFID_MAX_BLOCK_WORDS * 2];
+  uint8_t size = 0;
+
+  data[size++] = timeOut >> 8 & 0xFF;
+  data[size++] = timeOut & 0xFF;
+
+  uint8_t opcode;
+  uint8_t optionSpot;
+  if (blockWrite == true)
+  {
+    opcode = TMR_SR_OPCODE_WRITE_TAG_SPECIFIC;
+    data[size++] = 0x00; //Chip type
+    optionSpot = size;
+    data[size++] = 0x40;
+    data[size++] = 0x00;
+    data[size++] = TMR_SR_GEN2_BLOCK_WRITE;
+  }
+  else
+  {
+    opcode = TMR_SR_OPCODE_WRITE_TAG_DATA;
+    optionSpot = size;
+    data[size++] = 0x00;
+    for (uint8_t x = 0; x < 4; x++)
+      data[size++] = address >> (8 * (3 - x)) & 0xFF;
+    data[size++] = bank;
+  }
+
+  if (_tagFilter.isActive())
+  {
+    for (uint8_t x = 0; x < 4; x++)
+      data[size++] = 0x00; //Access password
+    size += addSelect(_tagFilter, &data[size], data[optionSpot]);
+  }
+
+  if (blockWrite == true)
+  {
+    data[size++] = 0x00; //Write flags
+    data[size++] = bank;
+    for (uint8_t x = 0; x < 4; x++)
+      data[size++] = address >> (8 * (3 - x)) & 0xFF;
+    data[size++] = wordCount;
+  }
+
+  memcpy(&data[size], words, wordCount * 2);
+  size += wordCount * 2;
+
+  sendMessage(opcode, data, size, timeOut);
+
+  if (msg[0] != ALL_GOOD)
+    return (0xFFFF);
+  return ((msg[3] << 8) | msg[4]);
+}
+
 //Reads a given bank and address to a data array
 //Allows for writing of passwords and user data
+//Only a tag matching the filter from setTagFilter() (if any) will answer
+//Asks for exactly the words needed to fill dataLengthRead bytes, so a 4 byte password doesn't
+//cost a whole bank of air time. Tags that turn down a read that stops short of the end of the
+//bank get a second try that reads the whole bank, which is then truncated.
 //TODO Add support for accessPassword
-//TODO Add support for writing to specific tag
 uint8_t RFID::readData(uint8_t bank, uint32_t address, uint8_t *dataRead, uint8_t &dataLengthRead, uint16_t timeOut)
+{
+  uint8_t wordCount = (dataLengthRead + 1) / 2;
+  if (wordCount > RFID_MAX_READ_WORDS)
+    wordCount = RFID_MAX_READ_WORDS;
+
+  bool rejected;
+  bool success = readTagWords(bank, address, wordCount, timeOut, rejected);
+  if (success == false && rejected == true && wordCount > 0)
+    success = readTagWords(bank, address, 0, timeOut, rejected); //0 = to the end of the bank
+
+  if (success == true)
+  {
+    // Offset by 3 for the returned option and metadata bytes
+    uint8_t responseLength = msg[1] - 3;
+
+    if (responseLength < dataLengthRead) //User wants us to read more than we have available
+      dataLengthRead = responseLength;
+
+    //There is a case here where responseLegnth is more than dataLengthRead, in which case we ignore (don't load) the additional bytes
+    //Load limited response data into caller's array
+    for (uint8_t x = 0; x < dataLengthRead; x++)
+      // Data starts at byte 8 (header (1), size (1), opcode (1), status (2), option (1), metadata (2))
+      dataRead[x] = msg[8 + x];
+
+    return (RESPONSE_SUCCESS);
+  }
+
+  //Else - msg[0] was timeout or other
+  dataLengthRead = 0; //Inform caller that we weren't able to read anything
+
+  return (RESPONSE_FAIL);
+}
+
+//Reads several ranges of memory from one tag in as few Gen2 reads as possible
+//Ranges in the same bank that overlap or touch are merged into a single read, up to
+//RFID_MAX_READ_WORDS words. Set a filter with setTagFilter() first so every read lands on
+//the same tag. A bank whose tag turns down the exact read is read whole, once, and every
+//range in it is served from that.
+//Each range's done flag says whether it was filled in. Returns RESPONSE_SUCCESS if they all were.
+uint8_t RFID::readRanges(RFID_ReadRange *ranges, uint8_t rangeCount, uint16_t timeOut)
+{
+  uint8_t remaining = 0;
+  for (uint8_t x = 0; x < rangeCount; x++)
+  {
+    ranges[x].done = (ranges[x].wordCount == 0); //Nothing to read
+    if (ranges[x].done == false)
+      remaining++;
+  }
+
+  while (remaining > 0)
+  {
+    //Start from the lowest range not yet read
+    RFID_ReadRange *first = NULL;
+    for (uint8_t x = 0; x < rangeCount; x++)
+    {
+      RFID_ReadRange &range = ranges[x];
+      if (range.done == true)
+        continue;
+      if (first == NULL || range.bank < first->bank || (range.bank == first->bank && range.wordAddress < first->wordAddress))
+        first = &range;
+    }
+    //Grow it while another range in the bank starts inside or right after it
+    uint32_t start = first->wordAddress;
+    uint32_t end = start + first->wordCount;
+    boolean grew = true;
+    while (grew == true)
+    {
+      grew = false;
+      for (uint8_t x = 0; x < rangeCount; x++)
+      {
+        RFID_ReadRange &range = ranges[x];
+        if (range.done == true || range.bank != first->bank || range.wordAddress < start || range.wordAddress > end)
+          continue;
+        uint32_t rangeEnd = range.wordAddress + range.wordCount;
+        if (rangeEnd > end && rangeEnd - start <= RFID_MAX_READ_WORDS)
+        {
+          end = rangeEnd;
+          grew = true;
+        }
+      }
+    }
+    if (end - start > RFID_MAX_READ_WORDS)
+      end = start + RFID_MAX_READ_WORDS; //A single range too long for one frame. It will fail below.
+
+    bool rejected;
+    if (readTagWords(first->bank, start, end - start, timeOut, rejected) == false)
+    {
+      if (rejected == false || readTagWords(first->bank, 0, 0, timeOut, rejected) == false)
+        break; //No tag, or it won't be read at all
+
+      start = 0; //Whole bank: serve every range in it
+      end = (msg[1] - 3) / 2;
+    }
+
+    //Hand out the words to every range the read covered
+    uint8_t *words = &msg[8];
+    for (uint8_t x = 0; x < rangeCount; x++)
+    {
+      RFID_ReadRange &range = ranges[x];
+      if (range.done == true || range.bank != first->bank || range.wordAddress < start || range.wordAddress + range.wordCount > end)
+        continue;
+      memcpy(range.data, &words[(range.wordAddress - start) * 2], range.wordCount * 2);
+      range.done = true;
+      remaining--;
+    }
+
+    if (first->done == false)
+      break; //Tag's bank is shorter than asked for
+  }
+
+  return (remaining == 0 ? RESPONSE_SUCCESS : RESPONSE_FAIL);
+}
+
+//Sends a READ_TAG_DATA for wordCount words (0 = the rest of the bank) and checks the answer
+//Returns true if the words are in msg, starting at msg[8]. When it returns false, rejected
+//says whether a tag answered and turned the read down, rather than no tag answering at all.
+bool RFID::readTagWords(uint8_t bank, uint32_t address, uint8_t wordCount, uint16_t timeOut, bool &rejected)
 {
   //Bank 0
   //response: [00] [08] [28] [00] [00] [10] [00] [00] [EE] [FF] [11] [22] [12] [34] [56] [78]
@@ -488,7 +1594,7 @@ uint8_t RFID::readData(uint8_t bank, uint32_t address, uint8_t *dataRead, uint8_
   //response: [00] [40] [28] [00] [00] [10] [00] [00] [41] [43] [42] [44] [45] [46] [00] [00] [00] [00] [00] [00] ...
   //User data
 
-  uint8_t data[11];
+  uint8_t data[11 + 4 + 5 + RFID_MAX_FILTER_BYTES];
 
   //Insert timeout
   data[0] = timeOut >> 8 & 0xFF; //Timeout msB in ms
@@ -510,62 +1616,54 @@ uint8_t RFID::readData(uint8_t bank, uint32_t address, uint8_t *dataRead, uint8_
     data[6 + x] = address >> (8 * (3 - x)) & 0xFF;
 
   // The last byte is the number of 16-bit words to read. If it's set to zero,
-  // then it will read the entire bank. We could set this to dataLengthRead / 2,
-  // but it's easier to just set it to zero and truncate the response later.
-  // That also helps if dataLengthRead differs from the actual the bank size,
-  // which can cause the read to fail entirely.
-  data[10] = 0x00;
-  // data[10] = dataLengthRead / 2;
-
-  sendMessage(TMR_SR_OPCODE_READ_TAG_DATA, data, sizeof(data), timeOut);
+  // then it will read the entire bank.
+  data[10] = wordCount;
 
-  if (msg[0] == ALL_GOOD) //We received a good response
+  //With a tag filter, the access password and the Select come last
+  uint8_t size = 11;
+  if (_tagFilter.isActive())
   {
-    uint16_t status = (msg[3] << 8) | msg[4];
-
-    if (status == 0x0000)
-    {
-      // Offset by 3 for the returned option and metadata bytes
-      uint8_t responseLength = msg[1] - 3;
-
-      if (responseLength < dataLengthRead) //User wants us to read more than we have available
-        dataLengthRead = responseLength;
+    for (uint8_t x = 0; x < 4; x++)
+      data[size++] = 0x00;
+    size += addSelect(_tagFilter, &data[size], data[2]);
+  }
 
-      //There is a case here where responseLegnth is more than dataLengthRead, in which case we ignore (don't load) the additional bytes
-      //Load limited response data into caller's array
-      for (uint8_t x = 0; x < dataLengthRead; x++)
-        // Data starts at byte 8 (header (1), size (1), opcode (1), status (2), option (1), metadata (2))
-        dataRead[x] = msg[8 + x];
+  sendMessage(TMR_SR_OPCODE_READ_TAG_DATA, data, size, timeOut);
 
-      return (RESPONSE_SUCCESS);
-    }
-  }
+  rejected = false;
+  if (msg[0] != ALL_GOOD) //Time out or bad response
+    return (false);
 
-  //Else - msg[0] was timeout or other
-  dataLengthRead = 0; //Inform caller that we weren't able to read anything
+  uint16_t status = (msg[3] << 8) | msg[4];
+  if (status == 0x0000 && msg[1] >= 3 + wordCount * 2)
+    return (true);
 
-  return (RESPONSE_FAIL);
+  rejected = (status != 0x0400); //0x0400 = no tags found
+  return (false);
 }
 
 //Send the appropriate command to permanently kill a tag. If the password does not
 //match the tag's pw it won't work. Default pw is 0x00000000
-//Use with caution. This function doesn't control which tag hears the command.
-//TODO Can we add ability to write to specific EPC?
+//Use with caution. Without a filter from setTagFilter(), whichever tag answers first is killed.
 uint8_t RFID::killTag(uint8_t *password, uint8_t passwordLength, uint16_t timeOut)
 {
-  uint8_t data[4 + passwordLength];
+  uint8_t data[4 + passwordLength + 5 + RFID_MAX_FILTER_BYTES];
 
   data[0] = timeOut >> 8 & 0xFF; //Timeout msB in ms
   data[1] = timeOut & 0xFF;      //Timeout lsB in ms
   data[2] = 0x00;                //Option initialize
 
   //Splice password into array
+  uint8_t size = 3;
   for (uint8_t x = 0; x < passwordLength; x++)
-    data[3 + x] = password[x];
+    data[size++] = password[x];
+
+  //The Select follows the kill password
+  size += addSelect(_tagFilter, &data[size], data[2]);
 
-  data[3 + passwordLength] = 0x00; //RFU
+  data[size++] = 0x00; //RFU
 
-  sendMessage(TMR_SR_OPCODE_KILL_TAG, data, sizeof(data), timeOut);
+  sendMessage(TMR_SR_OPCODE_KILL_TAG, data, size, timeOut);
 
   if (msg[0] == ALL_GOOD) //We received a good response
   {
@@ -581,42 +1679,112 @@ uint8_t RFID::killTag(uint8_t *password, uint8_t passwordLength, uint16_t timeOu
 
 //Checks incoming buffer for the start characters
 //Returns true if a new message is complete and ready to be cracked
+//Same as update(), kept so existing sketches drive commands sent with sendMessageAsync()
 bool RFID::check()
 {
+  return (update());
+}
+
+//Pumps the serial port: assembles incoming frames and hands each one to whoever is waiting for it
+//The answer to a command sent with sendMessageAsync() completes that command. Everything else
+//(tag records, keep-alives) is left in msg and update() returns true so it can be parsed.
+//Nothing is thrown away, so commands can go out in the middle of a continuous read.
+//Also times out a command the module hasn't answered.
+bool RFID::update(void)
+{
+  if (receiveFrame() == true)
+  {
+    //While reading continuously, 0x22 frames are always tag records or keep-alives
+    boolean streaming = (_continuousReading == true && msg[2] == TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE);
+
+    if (_commandPending == true && msg[2] == _commandOpcode && streaming == false)
+    {
+      finishCommand(ALL_GOOD);
+      return (false);
+    }
+    return (true);
+  }
+
+  if (_commandPending == true)
+  {
+    //With tags streaming in, a bad frame is most likely a tag record, so just wait for our answer
+    if (_continuousReading == false && _rxRejected != _commandRejected)
+      finishCommand(ERROR_CORRUPT_RESPONSE); //Whatever came back didn't survive the trip
+    else if (millis() - _commandStart > _commandTimeOut)
+      finishCommand(ERROR_COMMAND_RESPONSE_TIMEOUT);
+  }
+
+  return (false);
+}
+
+//Assembles bytes from the module into msg
+//Returns true if a new message is complete and ready to be cracked
+//Frames are validated as they arrive: the LEN byte must fit in msg and the CRC is
+//folded in byte by byte. A frame that fails either check is rescanned from the next
+//0xFF so a corrupt or truncated frame costs as few good frames as possible.
+bool RFID::receiveFrame(void)
+{
+  _msgCRCValid = false; //msg is about to change
+
+  //Bytes that arrived behind the last frame we handed out get decoded first
+  if (_rxPending > 0)
+  {
+    memmove(msg, &msg[_frameLength], _rxPending);
+    _head = _rxPending;
+    _rxPending = 0;
+
+    if (syncFrame() == true)
+      return (frameReceived());
+  }
+
   while (_nanoSerial->available())
   {
     uint8_t incomingData = _nanoSerial->read();
 
+#if RFID_ENABLE_METRICS
+    _metrics.bytesIn++;
+#endif
+
     //Wait for header byte
     if (_head == 0 && incomingData != 0xFF)
     {
-      //Do nothing. Ignore this byte because we need a start byte
+      _rxDiscarded++; //Ignore this byte because we need a start byte
+      continue;
     }
-    else
-    {
-      //Load this value into the array
-      msg[_head++] = incomingData;
 
-      _head %= MAX_MSG_SIZE; //Wrap variable
+    //Load this value into the array
+    msg[_head++] = incomingData;
 
-      if ((_head > 0) && (_head == msg[1] + 7))
+    if (_head == 2)
+    {
+      //LEN byte. A frame is LEN + 7 bytes and has to fit in msg.
+      if (incomingData > MAX_MSG_SIZE - 7)
       {
-        //We've got a complete sentence!
-
-        //Erase the remainder of the array
-        for (uint8_t x = _head; x < MAX_MSG_SIZE; x++)
-          msg[x] = 0;
-
-        _head = 0; //Reset
+        if (rejectFrame(true) == true)
+          return (frameReceived());
+        continue;
+      }
 
-        //Used for debugging: Does the user want us to print the command to serial port?
-        if (_printDebug == true)
+      _frameLength = incomingData + 7;
+      _rxCRC = updateCRC(0xFFFF, incomingData);
+    }
+    else if (_head > 2)
+    {
+      if (_head <= _frameLength - 2)
+      {
+        _rxCRC = updateCRC(_rxCRC, incomingData); //Everything but the header and the CRC itself
+      }
+      else if (_head == _frameLength)
+      {
+        if ((msg[_head - 2] == (_rxCRC >> 8)) && (msg[_head - 1] == (_rxCRC & 0xFF)))
         {
-          _debugSerial->print(F("response: "));
-          printMessageArray();
+          //We've got a complete sentence!
+          _head = 0; //Reset
+          return (frameReceived());
         }
 
-        return (true);
+        if (rejectFrame(false) == true)
+          return (frameReceived());
       }
     }
   }
@@ -624,77 +1792,248 @@ bool RFID::check()
   return (false);
 }
 
-//See parseResponse for breakdown of fields
-//Pulls the number of EPC bytes out of the response
-//Often this is 12 bytes
-uint8_t RFID::getTagEPCBytes(void)
+void RFID::resetReceiveCounters(void)
 {
-  uint16_t epcBits = 0; //Number of bits of EPC (including PC, EPC, and EPC CRC)
+  _rxDiscarded = 0;
+  _rxRejected = 0;
+  _rxDropped = 0;
+}
 
-  uint8_t tagDataBytes = getTagDataBytes(); //We need this offset
+//A complete frame with a good CRC is at the front of msg
+bool RFID::frameReceived(void)
+{
+  _msgCRCValid = true; //parseResponse() doesn't need to check it again
 
-  for (uint8_t x = 0; x < 2; x++)
-    epcBits |= (uint16_t)msg[27 + tagDataBytes + x] << (8 * (1 - x));
-  uint8_t epcBytes = epcBits / 8;
-  epcBytes -= 4; //Ignore the first two bytes and last two bytes
+  if (_trace != NULL)
+    _trace->record(RFID_TRACE_RX, msg, msg[1] + 7);
 
-  return (epcBytes);
+  //Used for debugging: Does the user want us to print the command to serial port?
+  if (_printDebug == true)
+  {
+    _debugSerial->print(F("response: "));
+    printMessageArray();
+  }
+
+  return (true);
 }
 
-//See parseResponse for breakdown of fields
-//Pulls the number of data bytes out of the response
-//Often this is zero
-uint8_t RFID::getTagDataBytes(void)
+//The frame at the front of msg is bad. Drop its header byte and look for the next frame in what's left.
+bool RFID::rejectFrame(bool badLength)
+{
+  dropFrame(badLength);
+  return (syncFrame());
+}
+
+//Counts the bad frame at the front of msg, its LEN (badLength) or its CRC, and drops its header byte
+void RFID::dropFrame(bool badLength)
 {
-  //Number of bits of embedded tag data
-  uint8_t tagDataLength = 0;
-  for (uint8_t x = 0; x < 2; x++)
-    tagDataLength |= (uint16_t)msg[24 + x] << (8 * (1 - x));
-  uint8_t tagDataBytes = tagDataLength / 8;
-  if (tagDataLength % 8 > 0)
-    tagDataBytes++; //Ceiling trick
+  _rxRejected++;
+
+  //Header and LEN for a bad length, the whole frame for a bad CRC
+  if (_trace != NULL)
+    _trace->record(RFID_TRACE_REJECTED, msg, (badLength == true) ? 2 : _frameLength);
 
-  return (tagDataBytes);
+#if RFID_ENABLE_METRICS
+  if (badLength == true)
+    _metrics.lengthErrors++;
+  else
+    _metrics.crcErrors++;
+#endif
+
+  memmove(msg, &msg[1], _head - 1);
+  _head--;
+  _rxDiscarded++;
 }
 
-//See parseResponse for breakdown of fields
-//Pulls the timestamp since last Keep-Alive message from a full response record stored in msg
-uint16_t RFID::getTagTimestamp(void)
+//Re-examines the bytes sitting in msg[0 to _head] from scratch
+//Drops bytes until they start a plausible frame and recomputes the running CRC
+//Returns true if a complete frame with a good CRC is at the front of msg. Any bytes
+//past the end of that frame are kept and decoded on the next call to check().
+bool RFID::syncFrame(void)
 {
-  //Timestamp since last Keep-Alive message
-  uint32_t timeStamp = 0;
-  for (uint8_t x = 0; x < 4; x++)
-    timeStamp |= (uint32_t)msg[17 + x] << (8 * (3 - x));
+  while (_head > 0)
+  {
+    //Skip to the next header candidate
+    uint8_t start = 0;
+    while (start < _head && msg[start] != 0xFF)
+      start++;
+
+    if (start > 0)
+    {
+      memmove(msg, &msg[start], _head - start);
+      _head -= start;
+      _rxDiscarded += start;
+      if (_head == 0)
+        break;
+    }
+
+    if (_head < 2)
+      return (false); //Need the LEN byte
+
+    if (msg[1] > MAX_MSG_SIZE - 7)
+    {
+      //Impossible length, this 0xFF wasn't a header
+      dropFrame(true);
+      continue;
+    }
 
-  return (timeStamp);
+    _frameLength = msg[1] + 7;
+
+    uint8_t crcBytes = _head - 1; //CRC covers LEN through the last data byte
+    if (crcBytes > _frameLength - 3)
+      crcBytes = _frameLength - 3;
+    _rxCRC = calculateCRC(&msg[1], crcBytes);
+
+    if (_head < _frameLength)
+      return (false); //Plausible so far, wait for the rest
+
+    if ((msg[_frameLength - 2] == (_rxCRC >> 8)) && (msg[_frameLength - 1] == (_rxCRC & 0xFF)))
+    {
+      _rxPending = _head - _frameLength;
+      _head = 0;
+      return (true);
+    }
+
+    dropFrame(false);
+  }
+
+  return (false);
 }
 
 //See parseResponse for breakdown of fields
-//Pulls the frequency value from a full response record stored in msg
-uint32_t RFID::getTagFreq(void)
+//Number of EPC bytes in the last tag record. Often this is 12 bytes
+uint8_t RFID::getTagEPCBytes(void)
 {
-  //Frequency of the tag detected is loaded over three bytes
-  uint32_t freq = 0;
-  for (uint8_t x = 0; x < 3; x++)
-    freq |= (uint32_t)msg[14 + x] << (8 * (2 - x));
+  return (_tagRecord.epcLength);
+}
 
-  return (freq);
+//Number of embedded data bytes in the last tag record. Often zero
+uint8_t RFID::getTagDataBytes(void)
+{
+  return (_tagRecord.dataLength);
 }
 
-//See parseResponse for breakdown of fields
-//Pulls the RSSI value from a full response record stored in msg
+//Timestamp of the last tag record, in ms since the last Keep-Alive message
+uint32_t RFID::getTagTimestamp(void)
+{
+  return (_tagRecord.timestamp);
+}
+
+//Frequency, in kHz, the last tag record was read at
+uint32_t RFID::getTagFreq(void)
+{
+  return (_tagRecord.freq);
+}
+
+//RSSI of the last tag record
 int8_t RFID::getTagRSSI(void)
 {
-  return (msg[12] - 256);
+  return (_tagRecord.rssi);
+}
+
+//Walks a full continuous read record in msg once, loading every field into _tagRecord
+//Returns false if the record doesn't fit inside the frame
+bool RFID::decodeTagRecord(void)
+{
+  uint8_t end = msg[1] + 5; //First CRC byte. Fields must stop before it.
+  uint8_t spot = 8;
+  uint16_t metadataFlags = TMR_TRD_METADATA_FLAG_NONE;
+
+  if (msg[5] & 0x10) //Option: metadata flags follow the search flags
+    metadataFlags = readField(msg, spot, 2);
+  spot++; //Number of tags in this record
+
+  return (decodeMetadata(metadataFlags, spot, end) && decodeEPC(spot, end));
+}
+
+//Bytes each metadata field takes, in flag bit order. The embedded data field adds its data on top.
+static const uint8_t metadataFieldBytes[] = {1, 1, 1, 3, 4, 2, 1, 2, 1, 1, 1, 1};
+
+//Loads the metadata fields named in metadataFlags, starting at msg[spot], into _tagRecord
+//Moves spot past them. Returns false if they run past end.
+bool RFID::decodeMetadata(uint16_t metadataFlags, uint8_t &spot, uint8_t end)
+{
+  uint16_t last = spot;
+  for (uint8_t x = 0; x < sizeof(metadataFieldBytes); x++)
+    if (metadataFlags & (1 << x))
+      last += metadataFieldBytes[x];
+  if (last > end)
+    return (false);
+
+  _tagRecord.readCount = (metadataFlags & TMR_TRD_METADATA_FLAG_READCOUNT) ? msg[spot++] : 0;
+  _tagRecord.rssi = (metadataFlags & TMR_TRD_METADATA_FLAG_RSSI) ? (int8_t)msg[spot++] : 0;
+  _tagRecord.antenna = (metadataFlags & TMR_TRD_METADATA_FLAG_ANTENNAID) ? msg[spot++] : 0;
+  _tagRecord.freq = (metadataFlags & TMR_TRD_METADATA_FLAG_FREQUENCY) ? readField(msg, spot, 3) : 0;
+  _tagRecord.timestamp = (metadataFlags & TMR_TRD_METADATA_FLAG_TIMESTAMP) ? readField(msg, spot, 4) : 0;
+  _tagRecord.phase = (metadataFlags & TMR_TRD_METADATA_FLAG_PHASE) ? readField(msg, spot, 2) : 0;
+  _tagRecord.protocol = (metadataFlags & TMR_TRD_METADATA_FLAG_PROTOCOL) ? msg[spot++] : 0;
+
+  _tagRecord.data = NULL;
+  _tagRecord.dataLength = 0;
+  if (metadataFlags & TMR_TRD_METADATA_FLAG_DATA)
+  {
+    uint16_t dataBits = readField(msg, spot, 2);
+    uint16_t dataBytes = (dataBits + 7) / 8; //Ceiling trick
+    if (last + dataBytes > end)
+      return (false);
+    _tagRecord.data = &msg[spot];
+    _tagRecord.dataLength = dataBytes;
+    spot += dataBytes;
+  }
+
+  _tagRecord.gpio = (metadataFlags & TMR_TRD_METADATA_FLAG_GPIO_STATUS) ? msg[spot++] : 0;
+
+  //Gen2 Q, link frequency and target aren't kept
+  for (uint16_t flag = TMR_TRD_METADATA_FLAG_GEN2_Q; flag <= TMR_TRD_METADATA_FLAG_GEN2_TARGET; flag <<= 1)
+    if (metadataFlags & flag)
+      spot++;
+
+  return (true);
+}
+
+//Loads the EPC length, PC, EPC and EPC CRC that end every tag record
+//Moves spot past them. Returns false if they run past end.
+bool RFID::decodeEPC(uint8_t &spot, uint8_t end)
+{
+  if (spot + 2 > end)
+    return (false);
+
+  uint16_t epcBytes = readField(msg, spot, 2) / 8; //PC + EPC + EPC CRC
+  if (epcBytes < 4 || spot + epcBytes > end)
+    return (false);
+
+  _tagRecord.pc = readField(msg, spot, 2);
+  _tagRecord.epc = &msg[spot];
+  _tagRecord.epcLength = epcBytes - 4;
+  spot += epcBytes - 4;
+  _tagRecord.epcCRC = readField(msg, spot, 2);
+
+  return (true);
 }
 
 //This will parse whatever response is currently in msg into its constituents
 //Mostly used for parsing out the tag IDs and RSSI from a multi tag continuous read
 uint8_t RFID::parseResponse(void)
+{
+  uint8_t responseType = decodeResponse();
+
+#if RFID_ENABLE_METRICS
+  if (responseType < RFID_METRICS_RESPONSE_TYPES)
+    _metrics.responses[responseType]++;
+#endif
+
+  return (responseType);
+}
+
+uint8_t RFID::decodeResponse(void)
 {
   //See http://www.thingmagic.com/images/Downloads/Docs/AutoConfigTool_1.2-UserGuide_v02RevA.pdf
   //for a breakdown of the response packet
 
+  //Which metadata fields a tag record carries depends on the flags startReading() asked for.
+  //The record echoes them in [8, 9] and decodeTagRecord() goes by those. The layout below
+  //is the full set that startReading() asks for by default.
+
   //Example response:
   //FF  28  22  00  00  10  00  1B  01  FF  01  01  C4  11  0E  16
   //40  00  00  01  27  00  00  05  00  00  0F  00  80  30  00  00
@@ -703,7 +2042,11 @@ uint8_t RFID::parseResponse(void)
   //  [1] 28 = Message length
   //  [2] 22 = OpCode
   //  [3, 4] 00 00 = Status
-  //  [5 to 11] 10 00 1B 01 FF 01 01 = RFU 7 bytes
+  //  [5] 10 = Option, 0x10 = metadata is included
+  //  [6, 7] 00 1B = Search flags
+  //  [8, 9] 01 FF = Metadata flags, which fields are present
+  //  [10] 01 = Number of tags in this record
+  //  [11] 01 = Read count
   //  [12] C4 = RSSI
   //  [13] 11 = Antenna ID (4MSB = TX, 4LSB = RX)
   //  [14, 15, 16] 0E 16 40 = Frequency in kHz
@@ -712,7 +2055,7 @@ uint8_t RFID::parseResponse(void)
   //  [23] 05 = Protocol ID
   //  [24, 25] 00 00 = Number of bits of embedded tag data [M bytes]
   //  [26 to M] (none) = Any embedded data
-  //  [26 + M] 0F = RFU reserved future use
+  //  [26 + M] 0F = GPIO status
   //  [27, 28 + M] 00 80 = EPC Length [N bytes]  (bits in EPC including PC and CRC bits). 128 bits = 16 bytes
   //  [29, 30 + M] 30 00 = Tag EPC Protocol Control (PC) bits
   //  [31 to 42 + M + N] 00 00 00 00 00 00 00 00 00 00 15 45 = EPC ID
@@ -722,11 +2065,14 @@ uint8_t RFID::parseResponse(void)
   uint8_t msgLength = msg[1] + 7; //Add 7 (the header, length, opcode, status, and CRC) to the LEN field to get total bytes
   uint8_t opCode = msg[2];
 
-  //Check the CRC on this response
-  uint16_t messageCRC = calculateCRC(&msg[1], msgLength - 3); //Ignore header (start spot 1), remove 3 bytes (header + 2 CRC)
-  if ((msg[msgLength - 2] != (messageCRC >> 8)) || (msg[msgLength - 1] != (messageCRC & 0xFF)))
+  //Check the CRC on this response, unless check() already did it as the bytes came in
+  if (_msgCRCValid == false)
   {
-    return (ERROR_CORRUPT_RESPONSE);
+    uint16_t messageCRC = calculateCRC(&msg[1], msgLength - 3); //Ignore header (start spot 1), remove 3 bytes (header + 2 CRC)
+    if ((msg[msgLength - 2] != (messageCRC >> 8)) || (msg[msgLength - 1] != (messageCRC & 0xFF)))
+    {
+      return (ERROR_CORRUPT_RESPONSE);
+    }
   }
 
   if (opCode == TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE) //opCode = 0x22
@@ -768,7 +2114,10 @@ uint8_t RFID::parseResponse(void)
     else //Full tag record
     {
       //This is a full tag response
-      //User can now pull out RSSI, frequency of tag, timestamp, EPC, Protocol control bits, EPC CRC, CRC
+      //Crack it once. User can now pull out RSSI, frequency of tag, timestamp, EPC, Protocol control bits,
+      //EPC CRC with getTagRecord() or the getTag...() functions
+      if (decodeTagRecord() == false)
+        return (RESPONSE_IS_UNKNOWN);
       return (RESPONSE_IS_TAGFOUND);
     }
   }
@@ -786,186 +2135,497 @@ uint8_t RFID::parseResponse(void)
 //Given an opcode, a piece of data, and the size of that data, package up a sentence and send it
 void RFID::sendMessage(uint8_t opcode, uint8_t *data, uint8_t size, uint16_t timeOut, boolean waitForResponse)
 {
-  msg[1] = size; //Load the length of this operation into msg array
-  msg[2] = opcode;
-
-  //Copy the data into msg array
-  for (uint8_t x = 0; x < size; x++)
-    msg[3 + x] = data[x];
-
-  sendCommand(timeOut, waitForResponse); //Send and wait for response
+  exchangeCommand(opcode, data, size, timeOut, waitForResponse); //Send and wait for response
 }
 
 //Given an array, calc CRC, assign header, send it out
-//Modifies the caller's msg array
+//The command is whatever the caller loaded into msg[1] (length), msg[2] (opcode) and msg[3+] (data)
+//Turned down with ERROR_COMMAND_PENDING in msg[0] while a sendMessageAsync() command is
+//pending: waiting for its answer would receive it into msg, right over this command.
 void RFID::sendCommand(uint16_t timeOut, boolean waitForResponse)
 {
-  msg[0] = 0xFF; //Universal header
-  uint8_t messageLength = msg[1];
+  if (_commandPending == true)
+  {
+    msg[0] = ERROR_COMMAND_PENDING;
+    return;
+  }
 
-  uint8_t opcode = msg[2]; //Used to see if response from module has the same opcode
+  //msg now holds our command, so any partial frame check() was assembling is gone
+  _head = 0;
+  _rxPending = 0;
+  _msgCRCValid = false;
 
-  //Attach CRC
-  uint16_t crc = calculateCRC(&msg[1], messageLength + 2); //Calc CRC starting from spot 1, not 0. Add 2 for LEN and OPCODE bytes.
-  msg[messageLength + 3] = crc >> 8;
-  msg[messageLength + 4] = crc & 0xFF;
+  exchangeCommand(msg[2], &msg[3], msg[1], timeOut, waitForResponse);
+}
 
-  //Used for debugging: Does the user want us to print the command to serial port?
-  if (_printDebug == true)
+//Sends a command and, unless told not to, waits for the answer
+//Once done, msg holds the response and msg[0] is ALL_GOOD or one of the ERROR_ codes.
+//While reading continuously, tag records that arrive meanwhile go to the tag callback.
+void RFID::exchangeCommand(uint8_t opcode, uint8_t *data, uint8_t size, uint16_t timeOut, boolean waitForResponse)
+{
+  //A command sent with sendMessageAsync() has to finish first or its answer could be taken for ours
+  while (_commandPending == true)
   {
-    _debugSerial->print(F("sendCommand: "));
-    printMessageArray();
+    if (update() == true)
+      streamFrame();
+    else
+      waitForData();
   }
 
-  //Remove anything in the incoming buffer
-  //TODO this is a bad idea if we are constantly readings tags
-  while (_nanoSerial->available())
-    _nanoSerial->read();
+  if (_continuousReading == false)
+  {
+    //Remove anything in the incoming buffer. Nothing should be coming, but the module
+    //sends its version at power on and could still be finishing an answer we gave up on.
+    while (_nanoSerial->available())
+    {
+      _nanoSerial->read();
+#if RFID_ENABLE_METRICS
+      _metrics.flushedBytes++;
+#endif
+    }
 
-  //Send the command to the module
-  for (uint8_t x = 0; x < messageLength + 5; x++)
-    _nanoSerial->write(msg[x]);
+    _head = 0;
+    _rxPending = 0;
+    _msgCRCValid = false;
+  }
 
   //There are some commands (setBaud) that we can't or don't want the response
   if (waitForResponse == false)
   {
-    _nanoSerial->flush(); //Wait for serial sending to complete
+    transmitCommand(opcode, data, size); //Returns once the command has gone out
     return;
   }
 
-  //For debugging, probably remove
-  //for (uint8_t x = 0 ; x < 100 ; x++) msg[x] = 0;
+  beginCommand(opcode, data, size, NULL, timeOut);
 
   //Wait for response with timeout
-  uint32_t startTime = millis();
-  while (_nanoSerial->available() == false)
+  while (_commandPending == true)
   {
-    if (millis() - startTime > timeOut)
+    if (update() == true)
     {
-      if (_printDebug == true)
-        _debugSerial->println(F("Time out 1: No response from module"));
-      msg[0] = ERROR_COMMAND_RESPONSE_TIMEOUT;
-      return;
+      if (streamFrame() == false)
+        finishCommand(ERROR_WRONG_OPCODE_RESPONSE); //Got a response, but not to the command we sent
     }
-    delay(1);
+    else
+      waitForData();
   }
 
-  // Layout of response in data array:
-  // [0] [1] [2] [3]      [4]      [5] [6]  ... [LEN+4] [LEN+5] [LEN+6]
-  // FF  LEN OP  STATUSHI STATUSLO xx  xx   ... xx      CRCHI   CRCLO
-  messageLength = MAX_MSG_SIZE - 1; //Make the max length for now, adjust it when the actual len comes in
-  uint8_t spot = 0;
-  while (spot < messageLength)
-  {
-    if (millis() - startTime > timeOut)
-    {
-      if (_printDebug == true)
-        _debugSerial->println(F("Time out 2: Incomplete response"));
+  msg[0] = _commandResult.error;
+}
 
-      msg[0] = ERROR_COMMAND_RESPONSE_TIMEOUT;
-      return;
-    }
+//Deals with a frame update() didn't match to a command, while a blocking command waits
+//During a continuous read that's a tag record or keep-alive: it's parsed and handed to the
+//tag callback (or counted by getDroppedFrames() if there isn't one). Returns false if the
+//frame isn't part of a continuous read.
+bool RFID::streamFrame(void)
+{
+  if (_continuousReading == false || msg[2] != TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE)
+    return (false);
 
-    if (_nanoSerial->available())
-    {
-      msg[spot] = _nanoSerial->read();
+  if (_tagCallback != NULL)
+    _tagCallback(parseResponse());
+  else
+    _rxDropped++;
 
-      if (spot == 1)                //Grab the length of this response (spot 1)
-        messageLength = msg[1] + 7; //Actual length of response is ? + 7 for extra stuff (header, Length, opcode, 2 status bytes, ..., 2 bytes CRC = 7)
+  return (true);
+}
 
-      spot++;
+//Sends a command without waiting for the answer. update() picks it up.
+bool RFID::sendMessageAsync(uint8_t opcode, uint8_t *data, uint8_t size, RFID_CommandCallback callback, uint16_t timeOut)
+{
+  if (_commandPending == true || size > MAX_MSG_SIZE - 5)
+    return (false);
 
-      //There's a case were we miss the end of one message and spill into another message.
-      //We don't want spot pointing at an illegal spot in the array
-      spot %= MAX_MSG_SIZE; //Wrap condition
-    }
+  beginCommand(opcode, data, size, callback, timeOut);
+  return (true);
+}
+
+//Sends a command and starts the clock on its answer
+void RFID::beginCommand(uint8_t opcode, uint8_t *data, uint8_t size, RFID_CommandCallback callback, uint16_t timeOut)
+{
+  _commandOpcode = opcode;
+  _commandCallback = callback;
+  _commandTimeOut = timeOut;
+  _commandRejected = _rxRejected;
+
+  transmitCommand(opcode, data, size);
+
+  _commandStart = millis();
+#if RFID_ENABLE_METRICS
+  _commandStartMicros = micros();
+#endif
+  _commandPending = true;
+}
+
+//Frames and writes a command straight to the serial port, CRC'ing as it goes
+//Then waits for the command to leave: the module can't answer before its last byte is in, so
+//this costs a blocking command nothing, and ports that gather bytes (RFID_LinuxSerial) send now
+//rather than when they are next read. That keeps command time stamps honest.
+void RFID::transmitCommand(uint8_t opcode, uint8_t *data, uint8_t size)
+{
+  uint8_t frame[3] = {0xFF, size, opcode};
+  uint16_t crc = calculateCRC(&frame[1], 2);   //Calc CRC starting from spot 1, not 0: LEN and OPCODE
+  crc = calculateCRC(data, size, crc);         //Then the data
+  uint8_t crcBytes[2] = {(uint8_t)(crc >> 8), (uint8_t)(crc & 0xFF)};
+
+  _nanoSerial->write(frame, sizeof(frame));
+  if (size > 0)
+    _nanoSerial->write(data, size);
+  _nanoSerial->write(crcBytes, sizeof(crcBytes));
+  _nanoSerial->flush();
+
+#if RFID_ENABLE_METRICS
+  _metrics.bytesOut += size + 5;
+#endif
+
+  if (_trace != NULL)
+  {
+    _trace->start(RFID_TRACE_TX, size + 5);
+    _trace->add(frame, sizeof(frame));
+    _trace->add(data, size);
+    _trace->add(crcBytes, sizeof(crcBytes));
   }
 
   //Used for debugging: Does the user want us to print the command to serial port?
   if (_printDebug == true)
   {
-    _debugSerial->print(F("response: "));
-    printMessageArray();
+    _debugSerial->print(F("sendCommand: "));
+    printBytes(frame, sizeof(frame), false);
+    printBytes(data, size, false);
+    printBytes(crcBytes, sizeof(crcBytes), true);
   }
+}
 
-  //Check CRC
-  crc = calculateCRC(&msg[1], messageLength - 3); //Remove header, remove 2 crc bytes
-  if ((msg[messageLength - 2] != (crc >> 8)) || (msg[messageLength - 1] != (crc & 0xFF)))
+//Nothing to do until the module sends more. A wait callback lets the host sleep until
+//then, or until the command in flight times out. Otherwise other tasks get a turn.
+void RFID::waitForData(void)
+{
+  if (_commandPending == false)
+    return; //The update() that found nothing new may have just taken the answer
+
+  if (_waitCallback == NULL)
   {
-    msg[0] = ERROR_CORRUPT_RESPONSE;
-    if (_printDebug == true)
-      _debugSerial->println(F("Corrupt response"));
+    yield();
     return;
   }
 
-  //If crc is ok, check that opcode matches (did we get a response to the command we sent or a different one?)
-  if (msg[2] != opcode)
+  uint32_t elapsed = millis() - _commandStart;
+  _waitCallback(*_nanoSerial, (elapsed <= _commandTimeOut) ? _commandTimeOut - elapsed + 1 : 0);
+}
+
+//Wraps up the command in flight and tells whoever is waiting
+void RFID::finishCommand(uint8_t error)
+{
+  _commandPending = false;
+
+  _commandResult.error = error;
+  _commandResult.opcode = _commandOpcode;
+  _commandResult.latency = millis() - _commandStart;
+
+#if RFID_ENABLE_METRICS
+  recordCommand(error);
+#endif
+
+  if (_trace != NULL && error != ALL_GOOD)
   {
-    msg[0] = ERROR_WRONG_OPCODE_RESPONSE;
-    if (_printDebug == true)
+    uint8_t failure[2] = {error, _head}; //_head: how much of the answer had arrived
+    _trace->record(RFID_TRACE_ERROR, failure, sizeof(failure));
+  }
+
+  if (error == ALL_GOOD)
+  {
+    // Layout of response in data array:
+    // [0] [1] [2] [3]      [4]      [5] [6]  ... [LEN+4] [LEN+5] [LEN+6]
+    // FF  LEN OP  STATUSHI STATUSLO xx  xx   ... xx      CRCHI   CRCLO
+    _commandResult.status = (msg[3] << 8) | msg[4];
+    _commandResult.data = &msg[5];
+    _commandResult.dataLength = msg[1];
+  }
+  else
+  {
+    _commandResult.status = 0;
+    _commandResult.data = NULL;
+    _commandResult.dataLength = 0;
+  }
+
+  if (_printDebug == true)
+  {
+    if (error == ERROR_COMMAND_RESPONSE_TIMEOUT && _head == 0)
+      _debugSerial->println(F("Time out 1: No response from module"));
+    else if (error == ERROR_COMMAND_RESPONSE_TIMEOUT)
+      _debugSerial->println(F("Time out 2: Incomplete response"));
+    else if (error == ERROR_CORRUPT_RESPONSE)
+      _debugSerial->println(F("Corrupt response"));
+    else if (error == ERROR_WRONG_OPCODE_RESPONSE)
       _debugSerial->println(F("Wrong opcode response"));
-    return;
   }
 
-  //If everything is ok, load all ok into msg array
-  msg[0] = ALL_GOOD;
+  if (_commandCallback != NULL)
+    _commandCallback(_commandResult);
+}
+
+#if RFID_ENABLE_METRICS
+//Counts how the command in flight turned out and files its round trip under its opcode
+//Called before _head is reset, so a time out can tell an answer that never started from one that stopped
+void RFID::recordCommand(uint8_t error)
+{
+  if (error == ERROR_COMMAND_RESPONSE_TIMEOUT && _head == 0)
+    _metrics.noResponse++;
+  else if (error == ERROR_COMMAND_RESPONSE_TIMEOUT)
+    _metrics.incomplete++;
+  else if (error == ERROR_CORRUPT_RESPONSE)
+    _metrics.corrupt++;
+  else if (error == ERROR_WRONG_OPCODE_RESPONSE)
+    _metrics.wrongOpcode++;
+
+  //The opcode's slot, or the first free one. Once they're all taken the last one is shared.
+  uint8_t slot = 0;
+  while (slot < RFID_METRICS_OPCODES - 1 && _metrics.opcodes[slot].opcode != _commandOpcode && _metrics.opcodes[slot].opcode != 0)
+    slot++;
+
+  RFID_OpcodeMetrics &opcode = _metrics.opcodes[slot];
+  if (opcode.opcode == 0)
+    opcode.opcode = _commandOpcode;
+
+  uint32_t elapsed = micros() - _commandStartMicros;
+  opcode.commands++;
+  if (error != ALL_GOOD)
+    opcode.failures++;
+  opcode.totalMicros += elapsed;
+  if (elapsed > opcode.maxMicros)
+    opcode.maxMicros = elapsed;
+
+  uint8_t bucket = 0;
+  for (uint32_t ms = elapsed / 1000; ms > 0 && bucket < RFID_METRICS_LATENCY_BUCKETS - 1; ms >>= 1)
+    bucket++;
+  opcode.latency[bucket]++;
 }
 
+void RFID::resetMetrics(void)
+{
+  memset(&_metrics, 0, sizeof(_metrics));
+}
+
+const RFID_OpcodeMetrics *RFID_Metrics::getOpcode(uint8_t opcode) const
+{
+  for (uint8_t x = 0; x < RFID_METRICS_OPCODES; x++)
+    if (opcodes[x].opcode == opcode)
+      return (&opcodes[x]);
+  return (NULL);
+}
+#endif //RFID_ENABLE_METRICS
+
 //Print the current message array - good for debugging, looking at how the module responded
 //TODO Don't hardcode the serial stream
 void RFID::printMessageArray(void)
+{
+  uint8_t amtToPrint = msg[1] + 5;
+  if (amtToPrint > MAX_MSG_SIZE)
+    amtToPrint = MAX_MSG_SIZE; //Limit this size
+
+  printBytes(msg, amtToPrint, true);
+}
+
+//Prints bytes as [XX] to the debug port
+void RFID::printBytes(const uint8_t *bytes, uint8_t length, boolean endLine)
 {
   if (_printDebug == true) //If user hasn't enabled debug we don't know what port to debug to
   {
-    uint8_t amtToPrint = msg[1] + 5;
-    if (amtToPrint > MAX_MSG_SIZE)
-      amtToPrint = MAX_MSG_SIZE; //Limit this size
-
-    for (uint16_t x = 0; x < amtToPrint; x++)
+    for (uint16_t x = 0; x < length; x++)
     {
       _debugSerial->print(" [");
-      if (msg[x] < 0x10)
+      if (bytes[x] < 0x10)
         _debugSerial->print("0");
-      _debugSerial->print(msg[x], HEX);
+      _debugSerial->print(bytes[x], HEX);
       _debugSerial->print("]");
     }
-    _debugSerial->println();
+    if (endLine == true)
+      _debugSerial->println();
   }
 }
 
 //Comes from serial_reader_l3.c
 //ThingMagic-mutated CRC used for messages.
-//Notably, not a CCITT CRC-16, though it looks close.
-static uint16_t crctable[] =
+//Notably, not a CCITT CRC-16, though it looks close: it is polynomial 0x1021 with a preset
+//of 0xFFFF, but data is shifted in at the bottom of the register instead of being XOR'd
+//in at the top. Mercury does this a nibble at a time with a 16 entry table. Working a
+//byte at a time, the byte that falls off the top is reduced with a 256 entry table,
+//crcTable[v] = v * x^16 mod P, which happens to be the familiar CCITT table.
+//The tables live in flash (PROGMEM) so they don't cost any of our precious RAM.
+static const uint16_t crcTable[256] PROGMEM =
     {
-        0x0000,
-        0x1021,
-        0x2042,
-        0x3063,
-        0x4084,
-        0x50a5,
-        0x60c6,
-        0x70e7,
-        0x8108,
-        0x9129,
-        0xa14a,
-        0xb16b,
-        0xc18c,
-        0xd1ad,
-        0xe1ce,
-        0xf1ef,
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+        0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+        0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
+        0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
+        0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
+        0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
+        0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
+        0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
+        0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
+        0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
+        0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
+        0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
+        0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
+        0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
+        0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+        0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
+        0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
+        0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
+        0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
+        0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
+        0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
+        0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+        0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
+        0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
+        0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
+        0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
+        0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
+        0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
+        0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
+        0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+        0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
+        0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0,
 };
 
-//Calculates the magical CRC value
-uint16_t RFID::calculateCRC(uint8_t *u8Buf, uint8_t len)
+
+#if RFID_CRC_SLICE_BY_4
+//Slice-by-4 tables: crcTableN[v] = v * x^N mod P
+//Four bytes in, the old CRC has been multiplied by x^32 and the new bytes by x^24 down to x^0,
+//so one step of the loop is five lookups instead of four dependent byte steps.
+static const uint16_t crcTable24[256] PROGMEM =
+    {
+        0x0000, 0x3331, 0x6662, 0x5553, 0xccc4, 0xfff5, 0xaaa6, 0x9997,
+        0x89a9, 0xba98, 0xefcb, 0xdcfa, 0x456d, 0x765c, 0x230f, 0x103e,
+        0x0373, 0x3042, 0x6511, 0x5620, 0xcfb7, 0xfc86, 0xa9d5, 0x9ae4,
+        0x8ada, 0xb9eb, 0xecb8, 0xdf89, 0x461e, 0x752f, 0x207c, 0x134d,
+        0x06e6, 0x35d7, 0x6084, 0x53b5, 0xca22, 0xf913, 0xac40, 0x9f71,
+        0x8f4f, 0xbc7e, 0xe92d, 0xda1c, 0x438b, 0x70ba, 0x25e9, 0x16d8,
+        0x0595, 0x36a4, 0x63f7, 0x50c6, 0xc951, 0xfa60, 0xaf33, 0x9c02,
+        0x8c3c, 0xbf0d, 0xea5e, 0xd96f, 0x40f8, 0x73c9, 0x269a, 0x15ab,
+        0x0dcc, 0x3efd, 0x6bae, 0x589f, 0xc108, 0xf239, 0xa76a, 0x945b,
+        0x8465, 0xb754, 0xe207, 0xd136, 0x48a1, 0x7b90, 0x2ec3, 0x1df2,
+        0x0ebf, 0x3d8e, 0x68dd, 0x5bec, 0xc27b, 0xf14a, 0xa419, 0x9728,
+        0x8716, 0xb427, 0xe174, 0xd245, 0x4bd2, 0x78e3, 0x2db0, 0x1e81,
+        0x0b2a, 0x381b, 0x6d48, 0x5e79, 0xc7ee, 0xf4df, 0xa18c, 0x92bd,
+        0x8283, 0xb1b2, 0xe4e1, 0xd7d0, 0x4e47, 0x7d76, 0x2825, 0x1b14,
+        0x0859, 0x3b68, 0x6e3b, 0x5d0a, 0xc49d, 0xf7ac, 0xa2ff, 0x91ce,
+        0x81f0, 0xb2c1, 0xe792, 0xd4a3, 0x4d34, 0x7e05, 0x2b56, 0x1867,
+        0x1b98, 0x28a9, 0x7dfa, 0x4ecb, 0xd75c, 0xe46d, 0xb13e, 0x820f,
+        0x9231, 0xa100, 0xf453, 0xc762, 0x5ef5, 0x6dc4, 0x3897, 0x0ba6,
+        0x18eb, 0x2bda, 0x7e89, 0x4db8, 0xd42f, 0xe71e, 0xb24d, 0x817c,
+        0x9142, 0xa273, 0xf720, 0xc411, 0x5d86, 0x6eb7, 0x3be4, 0x08d5,
+        0x1d7e, 0x2e4f, 0x7b1c, 0x482d, 0xd1ba, 0xe28b, 0xb7d8, 0x84e9,
+        0x94d7, 0xa7e6, 0xf2b5, 0xc184, 0x5813, 0x6b22, 0x3e71, 0x0d40,
+        0x1e0d, 0x2d3c, 0x786f, 0x4b5e, 0xd2c9, 0xe1f8, 0xb4ab, 0x879a,
+        0x97a4, 0xa495, 0xf1c6, 0xc2f7, 0x5b60, 0x6851, 0x3d02, 0x0e33,
+        0x1654, 0x2565, 0x7036, 0x4307, 0xda90, 0xe9a1, 0xbcf2, 0x8fc3,
+        0x9ffd, 0xaccc, 0xf99f, 0xcaae, 0x5339, 0x6008, 0x355b, 0x066a,
+        0x1527, 0x2616, 0x7345, 0x4074, 0xd9e3, 0xead2, 0xbf81, 0x8cb0,
+        0x9c8e, 0xafbf, 0xfaec, 0xc9dd, 0x504a, 0x637b, 0x3628, 0x0519,
+        0x10b2, 0x2383, 0x76d0, 0x45e1, 0xdc76, 0xef47, 0xba14, 0x8925,
+        0x991b, 0xaa2a, 0xff79, 0xcc48, 0x55df, 0x66ee, 0x33bd, 0x008c,
+        0x13c1, 0x20f0, 0x75a3, 0x4692, 0xdf05, 0xec34, 0xb967, 0x8a56,
+        0x9a68, 0xa959, 0xfc0a, 0xcf3b, 0x56ac, 0x659d, 0x30ce, 0x03ff,
+};
+
+static const uint16_t crcTable32[256] PROGMEM =
+    {
+        0x0000, 0x3730, 0x6e60, 0x5950, 0xdcc0, 0xebf0, 0xb2a0, 0x8590,
+        0xa9a1, 0x9e91, 0xc7c1, 0xf0f1, 0x7561, 0x4251, 0x1b01, 0x2c31,
+        0x4363, 0x7453, 0x2d03, 0x1a33, 0x9fa3, 0xa893, 0xf1c3, 0xc6f3,
+        0xeac2, 0xddf2, 0x84a2, 0xb392, 0x3602, 0x0132, 0x5862, 0x6f52,
+        0x86c6, 0xb1f6, 0xe8a6, 0xdf96, 0x5a06, 0x6d36, 0x3466, 0x0356,
+        0x2f67, 0x1857, 0x4107, 0x7637, 0xf3a7, 0xc497, 0x9dc7, 0xaaf7,
+        0xc5a5, 0xf295, 0xabc5, 0x9cf5, 0x1965, 0x2e55, 0x7705, 0x4035,
+        0x6c04, 0x5b34, 0x0264, 0x3554, 0xb0c4, 0x87f4, 0xdea4, 0xe994,
+        0x1dad, 0x2a9d, 0x73cd, 0x44fd, 0xc16d, 0xf65d, 0xaf0d, 0x983d,
+        0xb40c, 0x833c, 0xda6c, 0xed5c, 0x68cc, 0x5ffc, 0x06ac, 0x319c,
+        0x5ece, 0x69fe, 0x30ae, 0x079e, 0x820e, 0xb53e, 0xec6e, 0xdb5e,
+        0xf76f, 0xc05f, 0x990f, 0xae3f, 0x2baf, 0x1c9f, 0x45cf, 0x72ff,
+        0x9b6b, 0xac5b, 0xf50b, 0xc23b, 0x47ab, 0x709b, 0x29cb, 0x1efb,
+        0x32ca, 0x05fa, 0x5caa, 0x6b9a, 0xee0a, 0xd93a, 0x806a, 0xb75a,
+        0xd808, 0xef38, 0xb668, 0x8158, 0x04c8, 0x33f8, 0x6aa8, 0x5d98,
+        0x71a9, 0x4699, 0x1fc9, 0x28f9, 0xad69, 0x9a59, 0xc309, 0xf439,
+        0x3b5a, 0x0c6a, 0x553a, 0x620a, 0xe79a, 0xd0aa, 0x89fa, 0xbeca,
+        0x92fb, 0xa5cb, 0xfc9b, 0xcbab, 0x4e3b, 0x790b, 0x205b, 0x176b,
+        0x7839, 0x4f09, 0x1659, 0x2169, 0xa4f9, 0x93c9, 0xca99, 0xfda9,
+        0xd198, 0xe6a8, 0xbff8, 0x88c8, 0x0d58, 0x3a68, 0x6338, 0x5408,
+        0xbd9c, 0x8aac, 0xd3fc, 0xe4cc, 0x615c, 0x566c, 0x0f3c, 0x380c,
+        0x143d, 0x230d, 0x7a5d, 0x4d6d, 0xc8fd, 0xffcd, 0xa69d, 0x91ad,
+        0xfeff, 0xc9cf, 0x909f, 0xa7af, 0x223f, 0x150f, 0x4c5f, 0x7b6f,
+        0x575e, 0x606e, 0x393e, 0x0e0e, 0x8b9e, 0xbcae, 0xe5fe, 0xd2ce,
+        0x26f7, 0x11c7, 0x4897, 0x7fa7, 0xfa37, 0xcd07, 0x9457, 0xa367,
+        0x8f56, 0xb866, 0xe136, 0xd606, 0x5396, 0x64a6, 0x3df6, 0x0ac6,
+        0x6594, 0x52a4, 0x0bf4, 0x3cc4, 0xb954, 0x8e64, 0xd734, 0xe004,
+        0xcc35, 0xfb05, 0xa255, 0x9565, 0x10f5, 0x27c5, 0x7e95, 0x49a5,
+        0xa031, 0x9701, 0xce51, 0xf961, 0x7cf1, 0x4bc1, 0x1291, 0x25a1,
+        0x0990, 0x3ea0, 0x67f0, 0x50c0, 0xd550, 0xe260, 0xbb30, 0x8c00,
+        0xe352, 0xd462, 0x8d32, 0xba02, 0x3f92, 0x08a2, 0x51f2, 0x66c2,
+        0x4af3, 0x7dc3, 0x2493, 0x13a3, 0x9633, 0xa103, 0xf853, 0xcf63,
+};
+
+static const uint16_t crcTable40[256] PROGMEM =
+    {
+        0x0000, 0x76b4, 0xed68, 0x9bdc, 0xcaf1, 0xbc45, 0x2799, 0x512d,
+        0x85c3, 0xf377, 0x68ab, 0x1e1f, 0x4f32, 0x3986, 0xa25a, 0xd4ee,
+        0x1ba7, 0x6d13, 0xf6cf, 0x807b, 0xd156, 0xa7e2, 0x3c3e, 0x4a8a,
+        0x9e64, 0xe8d0, 0x730c, 0x05b8, 0x5495, 0x2221, 0xb9fd, 0xcf49,
+        0x374e, 0x41fa, 0xda26, 0xac92, 0xfdbf, 0x8b0b, 0x10d7, 0x6663,
+        0xb28d, 0xc439, 0x5fe5, 0x2951, 0x787c, 0x0ec8, 0x9514, 0xe3a0,
+        0x2ce9, 0x5a5d, 0xc181, 0xb735, 0xe618, 0x90ac, 0x0b70, 0x7dc4,
+        0xa92a, 0xdf9e, 0x4442, 0x32f6, 0x63db, 0x156f, 0x8eb3, 0xf807,
+        0x6e9c, 0x1828, 0x83f4, 0xf540, 0xa46d, 0xd2d9, 0x4905, 0x3fb1,
+        0xeb5f, 0x9deb, 0x0637, 0x7083, 0x21ae, 0x571a, 0xccc6, 0xba72,
+        0x753b, 0x038f, 0x9853, 0xeee7, 0xbfca, 0xc97e, 0x52a2, 0x2416,
+        0xf0f8, 0x864c, 0x1d90, 0x6b24, 0x3a09, 0x4cbd, 0xd761, 0xa1d5,
+        0x59d2, 0x2f66, 0xb4ba, 0xc20e, 0x9323, 0xe597, 0x7e4b, 0x08ff,
+        0xdc11, 0xaaa5, 0x3179, 0x47cd, 0x16e0, 0x6054, 0xfb88, 0x8d3c,
+        0x4275, 0x34c1, 0xaf1d, 0xd9a9, 0x8884, 0xfe30, 0x65ec, 0x1358,
+        0xc7b6, 0xb102, 0x2ade, 0x5c6a, 0x0d47, 0x7bf3, 0xe02f, 0x969b,
+        0xdd38, 0xab8c, 0x3050, 0x46e4, 0x17c9, 0x617d, 0xfaa1, 0x8c15,
+        0x58fb, 0x2e4f, 0xb593, 0xc327, 0x920a, 0xe4be, 0x7f62, 0x09d6,
+        0xc69f, 0xb02b, 0x2bf7, 0x5d43, 0x0c6e, 0x7ada, 0xe106, 0x97b2,
+        0x435c, 0x35e8, 0xae34, 0xd880, 0x89ad, 0xff19, 0x64c5, 0x1271,
+        0xea76, 0x9cc2, 0x071e, 0x71aa, 0x2087, 0x5633, 0xcdef, 0xbb5b,
+        0x6fb5, 0x1901, 0x82dd, 0xf469, 0xa544, 0xd3f0, 0x482c, 0x3e98,
+        0xf1d1, 0x8765, 0x1cb9, 0x6a0d, 0x3b20, 0x4d94, 0xd648, 0xa0fc,
+        0x7412, 0x02a6, 0x997a, 0xefce, 0xbee3, 0xc857, 0x538b, 0x253f,
+        0xb3a4, 0xc510, 0x5ecc, 0x2878, 0x7955, 0x0fe1, 0x943d, 0xe289,
+        0x3667, 0x40d3, 0xdb0f, 0xadbb, 0xfc96, 0x8a22, 0x11fe, 0x674a,
+        0xa803, 0xdeb7, 0x456b, 0x33df, 0x62f2, 0x1446, 0x8f9a, 0xf92e,
+        0x2dc0, 0x5b74, 0xc0a8, 0xb61c, 0xe731, 0x9185, 0x0a59, 0x7ced,
+        0x84ea, 0xf25e, 0x6982, 0x1f36, 0x4e1b, 0x38af, 0xa373, 0xd5c7,
+        0x0129, 0x779d, 0xec41, 0x9af5, 0xcbd8, 0xbd6c, 0x26b0, 0x5004,
+        0x9f4d, 0xe9f9, 0x7225, 0x0491, 0x55bc, 0x2308, 0xb8d4, 0xce60,
+        0x1a8e, 0x6c3a, 0xf7e6, 0x8152, 0xd07f, 0xa6cb, 0x3d17, 0x4ba3,
+};
+#endif
+
+//pgm_read_word() is a plain read on cores where flash is memory mapped
+#define CRC_TABLE(table, x) pgm_read_word(&table[x])
+
+//Folds one more byte into a running CRC. Start with 0xFFFF.
+uint16_t RFID::updateCRC(uint16_t crc, uint8_t value)
 {
-  uint16_t crc = 0xFFFF;
+  return ((uint16_t)(crc << 8) | value) ^ CRC_TABLE(crcTable, crc >> 8);
+}
 
-  for (uint8_t i = 0; i < len; i++)
+//Calculates the magical CRC value
+//Pass the CRC of the bytes that came before to continue a calculation, the default starts a new one
+uint16_t RFID::calculateCRC(const uint8_t *u8Buf, uint8_t len, uint16_t crc)
+{
+#if RFID_CRC_SLICE_BY_4
+  while (len >= 4)
   {
-    crc = ((crc << 4) | (u8Buf[i] >> 4)) ^ crctable[crc >> 12];
-    crc = ((crc << 4) | (u8Buf[i] & 0x0F)) ^ crctable[crc >> 12];
+    crc = CRC_TABLE(crcTable40, crc >> 8) ^ CRC_TABLE(crcTable32, crc & 0xFF) ^ CRC_TABLE(crcTable24, u8Buf[0]) ^ CRC_TABLE(crcTable, u8Buf[1]) ^ (((uint16_t)u8Buf[2] << 8) | u8Buf[3]);
+    u8Buf += 4;
+    len -= 4;
   }
+#endif
+
+  for (uint8_t i = 0; i < len; i++)
+    crc = updateCRC(crc, u8Buf[i]);
 
   return crc;
 }
@@ -15,6 +15,9 @@
   substantial portions of the Software.
 */
 
+#ifndef SPARKFUN_UHF_RFID_READER_H
+#define SPARKFUN_UHF_RFID_READER_H
+
 #include "Arduino.h" //Needed for Stream
 
 #define MAX_MSG_SIZE 255
@@ -27,25 +30,114 @@
 #define TMR_SR_OPCODE_WRITE_TAG_DATA 0x24
 #define TMR_SR_OPCODE_KILL_TAG 0x26
 #define TMR_SR_OPCODE_READ_TAG_DATA 0x28
+#define TMR_SR_OPCODE_GET_TAG_ID_BUFFER 0x29
 #define TMR_SR_OPCODE_CLEAR_TAG_ID_BUFFER 0x2A
+#define TMR_SR_OPCODE_WRITE_TAG_SPECIFIC 0x2D
 #define TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP 0x2F
 #define TMR_SR_OPCODE_GET_READ_TX_POWER 0x62
 #define TMR_SR_OPCODE_GET_WRITE_TX_POWER 0x64
+#define TMR_SR_OPCODE_GET_FREQ_HOP_TABLE 0x65
 #define TMR_SR_OPCODE_GET_USER_GPIO_INPUTS 0x66
 #define TMR_SR_OPCODE_GET_POWER_MODE 0x68
 #define TMR_SR_OPCODE_GET_READER_OPTIONAL_PARAMS 0x6A
 #define TMR_SR_OPCODE_GET_PROTOCOL_PARAM 0x6B
+#define TMR_SR_OPCODE_GET_TEMPERATURE 0x72
 #define TMR_SR_OPCODE_SET_ANTENNA_PORT 0x91
 #define TMR_SR_OPCODE_SET_TAG_PROTOCOL 0x93
 #define TMR_SR_OPCODE_SET_READ_TX_POWER 0x92
 #define TMR_SR_OPCODE_SET_WRITE_TX_POWER 0x94
+#define TMR_SR_OPCODE_SET_FREQ_HOP_TABLE 0x95
 #define TMR_SR_OPCODE_SET_USER_GPIO_OUTPUTS 0x96
 #define TMR_SR_OPCODE_SET_REGION 0x97
 #define TMR_SR_OPCODE_SET_READER_OPTIONAL_PARAMS 0x9A
 #define TMR_SR_OPCODE_SET_PROTOCOL_PARAM 0x9B
 
+//Metadata flags: which fields the module reports with each tag read (tmr_tag_data.h in the Mercury API)
+//Fields appear in a tag record in the order of these bits, lowest first
+#define TMR_TRD_METADATA_FLAG_NONE 0x0000
+#define TMR_TRD_METADATA_FLAG_READCOUNT 0x0001
+#define TMR_TRD_METADATA_FLAG_RSSI 0x0002
+#define TMR_TRD_METADATA_FLAG_ANTENNAID 0x0004
+#define TMR_TRD_METADATA_FLAG_FREQUENCY 0x0008
+#define TMR_TRD_METADATA_FLAG_TIMESTAMP 0x0010
+#define TMR_TRD_METADATA_FLAG_PHASE 0x0020
+#define TMR_TRD_METADATA_FLAG_PROTOCOL 0x0040
+#define TMR_TRD_METADATA_FLAG_DATA 0x0080
+#define TMR_TRD_METADATA_FLAG_GPIO_STATUS 0x0100
+#define TMR_TRD_METADATA_FLAG_GEN2_Q 0x0200
+#define TMR_TRD_METADATA_FLAG_GEN2_LF 0x0400
+#define TMR_TRD_METADATA_FLAG_GEN2_TARGET 0x0800
+
+//Search flags for READ_TAG_ID_MULTIPLE
+#define TMR_SR_SEARCH_FLAG_CONFIGURED_LIST 0x0003 //Use the antenna search list
+#define TMR_SR_SEARCH_FLAG_EMBEDDED_COMMAND 0x0004
+#define TMR_SR_SEARCH_FLAG_TAG_STREAMING 0x0008
+#define TMR_SR_SEARCH_FLAG_LARGE_TAG_POPULATION 0x0010
+#define TMR_SR_SEARCH_FLAG_DUTY_CYCLE_CONTROL 0x0800 //An off time follows the on time
+
+#define TMR_TAG_PROTOCOL_GEN2 0x05
+
+//Gen2 memory banks
+#define TMR_GEN2_BANK_RESERVED 0x00 //Kill and access passwords
+#define TMR_GEN2_BANK_EPC 0x01
+#define TMR_GEN2_BANK_TID 0x02
+#define TMR_GEN2_BANK_USER 0x03
+
+//Singulation option: the low bits of the option byte in tag commands say which tags take part
+#define TMR_SR_GEN2_SINGULATION_OPTION_SELECT_DISABLED 0x00
+#define TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_TID 0x02
+#define TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_USER_MEM 0x03
+#define TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_ADDRESSED_EPC 0x04
+#define TMR_SR_GEN2_SINGULATION_OPTION_INVERSE_SELECT_BIT 0x08
+#define TMR_SR_GEN2_SINGULATION_OPTION_FLAG_METADATA 0x10
+
+#define TMR_SR_GEN2_BLOCK_WRITE 0xC7 //Gen2 command sent through WRITE_TAG_SPECIFIC
+
+//Gen2 keys for SET_PROTOCOL_PARAM and GET_PROTOCOL_PARAM (TMR_SR_Gen2Configuration in the Mercury API)
+#define TMR_SR_GEN2_CONFIGURATION_SESSION 0x00
+#define TMR_SR_GEN2_CONFIGURATION_TARGET 0x01
+#define TMR_SR_GEN2_CONFIGURATION_TAGENCODING 0x02
+#define TMR_SR_GEN2_CONFIGURATION_LINKFREQUENCY 0x10
+#define TMR_SR_GEN2_CONFIGURATION_TARI 0x11
+#define TMR_SR_GEN2_CONFIGURATION_Q 0x12
+
+#define RFID_GEN2_DYNAMIC_Q 0xFF //Q value that lets the module adjust Q as it goes
+#define RFID_GEN2_MAX_Q 15
+
+//SET_ANTENNA_PORT options. Plain [TX port] [RX port] has none.
+#define TMR_SR_ANTENNA_OPTION_SEARCH_LIST 0x02 //Logical antenna list: [TX port] [RX port] for each
+#define TMR_SR_ANTENNA_OPTION_PORT_POWERS 0x03 //[port] [read power 2] [write power 2] for each
+
+//Highest antenna port number. The M6E Nano has port 1 only.
+#define RFID_MAX_ANTENNA_PORTS 4
+
+//Longest Select mask RFID_TagFilter holds. 16 bytes covers a 96 bit EPC or TID with room to spare.
+#ifndef RFID_MAX_FILTER_BYTES
+#define RFID_MAX_FILTER_BYTES 16
+#endif
+
+//Metadata startReading() has always asked for: everything up to and including GPIO status
+#define RFID_DEFAULT_METADATA 0x01FF
+
+//Metadata readTagsBuffered() asks for unless told otherwise. Every field costs bytes in
+//each record, and fewer bytes per record means more records per GET_TAG_ID_BUFFER frame.
+#define RFID_BUFFERED_METADATA (TMR_TRD_METADATA_FLAG_READCOUNT | TMR_TRD_METADATA_FLAG_RSSI | TMR_TRD_METADATA_FLAG_ANTENNAID)
+
+//CRC engine. Every board gets a 256 entry table kept in flash. Everything but AVR
+//also gets slice-by-4 tables, another 1.5kB of flash, to work 4 bytes per step.
+#ifndef RFID_CRC_SLICE_BY_4
+#if defined(__AVR__)
+#define RFID_CRC_SLICE_BY_4 0
+#else
+#define RFID_CRC_SLICE_BY_4 1
+#endif
+#endif
+
 #define COMMAND_TIME_OUT 2000 //Number of ms before stop waiting for response from module
 
+#define RFID_BAUD_TEST_ROUNDS 10 //Version round trips autoBaud() needs to pass at a baud rate
+#define RFID_BAUD_SETTLE_TIME 50 //ms to let both ends settle after a baud rate change
+
 //Define all the ways functions can return
 #define ALL_GOOD 0
 #define ERROR_COMMAND_RESPONSE_TIMEOUT 1
@@ -61,6 +153,8 @@
 #define RESPONSE_SUCCESS 11
 #define RESPONSE_FAIL 12
 #define RESPONSE_IS_HIGHRETURNLOSS 13
+#define ERROR_INVALID_PARAMETER 14
+#define ERROR_COMMAND_PENDING 15 //sendCommand() while a sendMessageAsync() command is still waiting for its answer
 
 //Define the allowed regions - these set the internal freq of the module
 #define REGION_NORTHAMERICA 0x01
@@ -88,6 +182,275 @@ typedef enum
   ThingMagic_PinMode_OUTPUT = 1
 } ThingMagic_PinMode_t;
 
+//Gen2 inventory settings. The values are what the module takes over the wire.
+
+//Session: which of the tag's four inventoried flags a search uses. S0 forgets a tag was
+//read as soon as it loses power, S1 after 0.5 to 5s, S2 and S3 keep it for 2s or more
+//after losing power, and as long as it stays powered.
+typedef enum
+{
+  ThingMagic_Gen2Session_S0 = 0,
+  ThingMagic_Gen2Session_S1 = 1,
+  ThingMagic_Gen2Session_S2 = 2,
+  ThingMagic_Gen2Session_S3 = 3
+} ThingMagic_Gen2Session_t;
+
+//Target: which value of the session flag answers. A tag that is read flips from A to B,
+//so with target A each tag answers once per session. AB and BA swap target every round.
+typedef enum
+{
+  ThingMagic_Gen2Target_A,
+  ThingMagic_Gen2Target_B,
+  ThingMagic_Gen2Target_AB,
+  ThingMagic_Gen2Target_BA
+} ThingMagic_Gen2Target_t;
+
+//Tag encoding: FM0 is fastest, Miller M2 to M8 send each bit over more cycles and cope better with noise
+typedef enum
+{
+  ThingMagic_Gen2Encoding_FM0 = 0,
+  ThingMagic_Gen2Encoding_M2 = 1,
+  ThingMagic_Gen2Encoding_M4 = 2,
+  ThingMagic_Gen2Encoding_M8 = 3
+} ThingMagic_Gen2Encoding_t;
+
+//Backscatter link frequency: how fast tags answer
+typedef enum
+{
+  ThingMagic_Gen2LinkFrequency_250kHz = 0,
+  ThingMagic_Gen2LinkFrequency_320kHz = 2,
+  ThingMagic_Gen2LinkFrequency_640kHz = 4
+} ThingMagic_Gen2LinkFrequency_t;
+
+//Tari: length of a data-0 symbol from the reader, shorter is faster
+typedef enum
+{
+  ThingMagic_Gen2Tari_25us = 0,
+  ThingMagic_Gen2Tari_12_5us = 1,
+  ThingMagic_Gen2Tari_6_25us = 2
+} ThingMagic_Gen2Tari_t;
+
+//Longest EPC the classes that keep a copy of one (RFID_InventoryEntry, RFID_CommissionJob,
+//RFID_TagEvent) have room for. Most tags use 96 bit (12 byte) EPCs.
+#ifndef RFID_MAX_EPC_BYTES
+#define RFID_MAX_EPC_BYTES 12
+#endif
+
+//A tag record, cracked once by parseResponse() or nextBufferedTag()
+//Wider fields come first to keep the struct packed. The data and epc spans point into
+//RFID::msg, so they are only good until the next call to check() or the next command.
+//Fields the module wasn't asked to report read as zero.
+struct RFID_TagRecord
+{
+  uint32_t freq;        //Frequency the tag was read at, in kHz
+  uint32_t timestamp;   //ms since the last keep-alive message (continuous) or the start of the search (buffered)
+  const uint8_t *data;  //Embedded tag data, see RFID_ReadConfig::setEmbeddedRead()
+  const uint8_t *epc;   //EPC, not including PC or EPC CRC
+  uint16_t phase;       //Phase of the signal the tag was read at, 0 to 180
+  uint16_t pc;          //Tag EPC Protocol Control bits
+  uint16_t epcCRC;      //CRC the tag sent with its EPC
+  int8_t rssi;          //dBm
+  uint8_t antenna;      //4 MSB = TX port, 4 LSB = RX port
+  uint8_t protocol;     //0x05 = GEN2
+  uint8_t readCount;    //Times the tag was read for this record
+  uint8_t gpio;         //State of the GPIO pins when the tag was read
+  uint8_t dataLength;   //Number of bytes at data
+  uint8_t epcLength;    //Number of bytes at epc
+
+  uint8_t getTXPort(void) const { return (antenna >> 4); }   //0 if the antenna metadata field wasn't asked for
+  uint8_t getRXPort(void) const { return (antenna & 0x0F); }
+};
+
+//A Gen2 Select: only tags whose memory matches mask take part in a command (or, inverted,
+//only tags that don't). The first bitLength bits of mask are compared against the bank
+//starting bitPointer bits in. With 50 tags in the field this is what makes a read or write
+//land on the tag you meant, and on an inventory it keeps the module from spending air time
+//on tags you don't care about.
+//
+//  rfidModule.setTagFilter(RFID_TagFilter().setEPC(myEPC, sizeof(myEPC)));
+//
+//A default RFID_TagFilter matches every tag.
+struct RFID_TagFilter
+{
+  uint8_t bank = 0;        //TMR_GEN2_BANK_EPC, _TID or _USER. 0 = no Select.
+  uint32_t bitPointer = 0; //Bits into the bank. In the EPC bank the EPC itself starts at bit 32, after the CRC and PC.
+  uint8_t bitLength = 0;   //Bits of mask to compare
+  boolean invert = false;  //Select the tags that don't match
+  uint8_t mask[RFID_MAX_FILTER_BYTES];
+
+  RFID_TagFilter &setMask(uint8_t memoryBank, uint32_t pointer, const uint8_t *maskBytes, uint8_t maskBits); //maskBits is capped at RFID_MAX_FILTER_BYTES * 8
+  RFID_TagFilter &setEPC(const uint8_t *epc, uint8_t epcLength) { return (setMask(TMR_GEN2_BANK_EPC, 32, epc, epcLength * 8)); }
+  RFID_TagFilter &setInvert(boolean inverted = true) { invert = inverted; return (*this); }
+  boolean isActive(void) const { return (bank != 0); }
+};
+
+//One antenna port and how to use it, for RFID::setAntennaPortPowers() and RFID_AntennaScheduler
+//
+//  RFID_AntennaPort ports[] = {RFID_AntennaPort().setPort(1).setReadPower(2700), RFID_AntennaPort().setPort(2).setDwellTime(500)};
+struct RFID_AntennaPort
+{
+  uint8_t port = 1;           //1 to RFID_MAX_ANTENNA_PORTS. TX and RX on the same port.
+  int16_t readPower = 2000;   //0.01 dBm, up to 2700
+  int16_t writePower = 2000;
+  uint16_t dwellTime = 1000;  //ms RFID_AntennaScheduler reads on the port each turn
+
+  RFID_AntennaPort &setPort(uint8_t antennaPort) { port = antennaPort; return (*this); }
+  RFID_AntennaPort &setReadPower(int16_t power) { readPower = power; return (*this); }
+  RFID_AntennaPort &setWritePower(int16_t power) { writePower = power; return (*this); }
+  RFID_AntennaPort &setDwellTime(uint16_t dwell) { dwellTime = dwell; return (*this); }
+};
+
+//Everything that shapes a Gen2 inventory, for RFID::setProtocolParameters() and getProtocolParameters()
+//The defaults are the modules' power up settings. Two starting points are provided:
+//
+//  maxThroughput(): a handful of tags to be read as often as possible. S0 with target A,
+//  a small static Q (4 slots) and the fastest link. Tags can be read again almost at once.
+//
+//  densePopulation(): a large population to be read once each. S2 with target A keeps
+//  tags that have been read quiet so the rest get the air time, dynamic Q sizes the rounds
+//  to the population and Miller M4 at 250kHz holds up with other readers and tags nearby.
+//  Switch the target to AB to keep seeing the tags after the first pass.
+struct RFID_Gen2Parameters
+{
+  ThingMagic_Gen2Session_t session = ThingMagic_Gen2Session_S0;
+  ThingMagic_Gen2Target_t target = ThingMagic_Gen2Target_A;
+  uint8_t q = RFID_GEN2_DYNAMIC_Q; //0 to RFID_GEN2_MAX_Q for a static Q
+  ThingMagic_Gen2Encoding_t encoding = ThingMagic_Gen2Encoding_M4;
+  ThingMagic_Gen2LinkFrequency_t linkFrequency = ThingMagic_Gen2LinkFrequency_250kHz;
+  ThingMagic_Gen2Tari_t tari = ThingMagic_Gen2Tari_25us;
+
+  static RFID_Gen2Parameters maxThroughput(void);
+  static RFID_Gen2Parameters densePopulation(void);
+};
+
+//Most words one READ_TAG_DATA can bring back: what fits in a frame after the status, option and metadata
+#define RFID_MAX_READ_WORDS ((MAX_MSG_SIZE - 10) / 2)
+
+//Most channels a hop table can have: what fits in one frame at 4 bytes a channel
+#define RFID_MAX_HOP_CHANNELS ((MAX_MSG_SIZE - 7) / 4)
+
+//Biggest chunk writeBlocks() puts in one command. Each word costs 2 bytes of stack while it's sent.
+#ifndef RFID_MAX_BLOCK_WORDS
+#define RFID_MAX_BLOCK_WORDS 32
+#endif
+
+//BlockWrite size writeBlocks() starts out with. Tags that can't take it get smaller blocks.
+#define RFID_BLOCK_WRITE_WORDS 16
+
+//One piece of tag memory for RFID::readRanges(). data must hold wordCount * 2 bytes.
+struct RFID_ReadRange
+{
+  uint8_t *data;
+  uint32_t wordAddress;
+  uint8_t bank;      //TMR_GEN2_BANK_...
+  uint8_t wordCount;
+  boolean done;      //Set by readRanges() once data is filled in
+};
+
+//Options for a continuous read. Start from the defaults, which match startReading(),
+//and change what's needed:
+//
+//  rfidModule.startReading(RFID_ReadConfig().setMetadata(TMR_TRD_METADATA_FLAG_RSSI).setDutyCycle(500, 500));
+//
+//Each metadata field left out makes every tag frame shorter, so more tags fit through the serial link.
+//
+//An embedded read has the module read some memory of every tag as it inventories it. The words
+//arrive with the EPC in getTagRecord().data, so a whole population's TIDs take one pass:
+//
+//  rfidModule.startReading(RFID_ReadConfig().setEmbeddedRead(TMR_GEN2_BANK_TID, 0, 6));
+struct RFID_ReadConfig
+{
+  uint16_t metadataFlags = RFID_DEFAULT_METADATA; //TMR_TRD_METADATA_FLAG_... fields to report with each tag
+  uint16_t searchFlags = TMR_SR_SEARCH_FLAG_CONFIGURED_LIST | TMR_SR_SEARCH_FLAG_TAG_STREAMING | TMR_SR_SEARCH_FLAG_LARGE_TAG_POPULATION;
+  uint16_t onTime = 1000; //ms the RF is on for each read cycle
+  uint16_t offTime = 0;   //ms the RF rests between read cycles. Lets the module cool down.
+  uint8_t protocol = TMR_TAG_PROTOCOL_GEN2;
+  RFID_TagFilter filter; //Only these tags are inventoried. Matches all tags by default.
+  uint8_t readBank = TMR_GEN2_BANK_TID; //Embedded read of each tag
+  uint32_t readAddress = 0; //In 16 bit words
+  uint8_t readWords = 0;    //0 = no embedded read
+
+  RFID_ReadConfig &setMetadata(uint16_t flags) { metadataFlags = flags; return (*this); }
+  RFID_ReadConfig &setSearchFlags(uint16_t flags) { searchFlags = flags; return (*this); }
+  RFID_ReadConfig &setDutyCycle(uint16_t on, uint16_t off) { onTime = on; offTime = off; return (*this); }
+  RFID_ReadConfig &setProtocol(uint8_t tagProtocol) { protocol = tagProtocol; return (*this); }
+  RFID_ReadConfig &setFilter(const RFID_TagFilter &tagFilter) { filter = tagFilter; return (*this); }
+  RFID_ReadConfig &setEmbeddedRead(uint8_t bank, uint32_t wordAddress, uint8_t wordCount) { readBank = bank; readAddress = wordAddress; readWords = wordCount; return (*this); }
+};
+
+//How a command turned out, filled in when the module answers or the time out runs out
+struct RFID_CommandResult
+{
+  const uint8_t *data; //Response data after the status word. Points into RFID::msg, so only good until the next update().
+  uint32_t latency;    //ms from sending the command to its answer (or time out)
+  uint16_t status;     //Status word from the module. 0x0000 = success.
+  uint8_t error;       //ALL_GOOD, ERROR_COMMAND_RESPONSE_TIMEOUT, ERROR_CORRUPT_RESPONSE or ERROR_WRONG_OPCODE_RESPONSE
+  uint8_t opcode;
+  uint8_t dataLength;  //Number of bytes at data
+};
+
+typedef void (*RFID_CommandCallback)(const RFID_CommandResult &result);
+
+//Counters and command latencies for finding out what the link is doing in the field. Off by
+//default: it costs about 1kB of RAM and a few increments per frame. Turn it on for the
+//whole build (-DRFID_ENABLE_METRICS=1 in build flags), not just in a sketch, or the library and
+//the sketch disagree about what's in an RFID.
+#ifndef RFID_ENABLE_METRICS
+#define RFID_ENABLE_METRICS 0
+#endif
+
+#if RFID_ENABLE_METRICS
+
+#define RFID_METRICS_RESPONSE_TYPES 16   //parseResponse() results, ALL_GOOD to ERROR_COMMAND_PENDING
+#define RFID_METRICS_OPCODES 12          //Opcodes that get their own latencies. Later ones share the last slot.
+#define RFID_METRICS_LATENCY_BUCKETS 12  //Bucket 0 = under 1ms, bucket x = 2^(x-1) to 2^x ms, the last one has the rest
+
+//Round trips of one command opcode
+struct RFID_OpcodeMetrics
+{
+  uint8_t opcode;      //0 = slot not used yet. Slot RFID_METRICS_OPCODES - 1 takes every opcode that didn't get its own.
+  uint32_t commands;   //Answered or not
+  uint32_t failures;   //Timed out, corrupt or wrong opcode
+  uint32_t totalMicros;
+  uint32_t maxMicros;
+  uint32_t latency[RFID_METRICS_LATENCY_BUCKETS];
+
+  uint32_t getMeanMicros(void) const { return (commands ? totalMicros / commands : 0); }
+};
+
+struct RFID_Metrics
+{
+  uint32_t responses[RFID_METRICS_RESPONSE_TYPES]; //parseResponse() results: [RESPONSE_IS_TAGFOUND], [ERROR_CORRUPT_RESPONSE], [ERROR_UNKNOWN_OPCODE], ...
+  uint32_t bytesIn;      //Bytes read from the module
+  uint32_t bytesOut;     //Bytes sent to the module
+  uint32_t flushedBytes; //Bytes thrown away before a command when not reading continuously
+  uint32_t crcErrors;    //Received frames with a bad CRC
+  uint32_t lengthErrors; //Received frames with a LEN that can't be right
+  uint32_t noResponse;   //"Time out 1": the module never started answering
+  uint32_t incomplete;   //"Time out 2": the answer stopped part way
+  uint32_t corrupt;      //Commands whose answer came back corrupt
+  uint32_t wrongOpcode;  //Commands answered with some other opcode
+  RFID_OpcodeMetrics opcodes[RFID_METRICS_OPCODES];
+
+  const RFID_OpcodeMetrics *getOpcode(uint8_t opcode) const; //NULL if the opcode hasn't been sent
+};
+
+#endif //RFID_ENABLE_METRICS
+
+//Changes the baud rate of the host's serial port, for autoBaud(). Stream has no begin(), so
+//this is usually just: void setHostBaud(long baudRate) { Serial1.begin(baudRate); }
+typedef void (*RFID_BaudCallback)(long baudRate);
+
+//Gets the parseResponse() result of each continuous read frame that arrives while a blocking
+//command waits for its answer. Use getTagRecord() for the details. Don't send commands from it.
+typedef void (*RFID_TagCallback)(uint8_t responseType);
+
+//Sleeps until port has bytes to read or maxWait ms have passed, for blocking commands on hosts
+//where spinning on available() burns a core. RFID_LinuxSerial::waitCallback() does this with poll().
+typedef void (*RFID_WaitCallback)(Stream &port, uint32_t maxWait);
+
+class RFID_Trace; //SparkFun_UHF_RFID_Trace.h
+
 class RFID
 {
 public:
@@ -98,19 +461,55 @@ public:
   void enableDebugging(Stream &debugPort = Serial); //Turn on command sending and response printing. If user doesn't specify then Serial will be used
   void disableDebugging(void);
 
+  //Keep raw frames in trace instead of printing them, see SparkFun_UHF_RFID_Trace.h
+  void enableTracing(RFID_Trace &trace) { _trace = &trace; }
+  void disableTracing(void) { _trace = NULL; }
+
   void setBaud(long baudRate);
+  long autoBaud(long currentBaud, RFID_BaudCallback setHostBaud, long maxBaud = 921600); //Find the fastest reliable baud rate. Returns it, or 0 if the module was lost.
   void getVersion(void);
-  void setReadPower(int16_t powerSetting);
+  uint8_t setReadPower(int16_t powerSetting); //RESPONSE_SUCCESS or RESPONSE_FAIL
   void getReadPower();
   void setWritePower(int16_t powerSetting);
   void getWritePower();
+  uint8_t getTemperature(int8_t &temperature); //Module temperature in C
   void setRegion(uint8_t region);
-  void setAntennaPort();
-  void setAntennaSearchList();
+
+  //Channels the module hops between, in kHz, and how long it stays on each. setRegion() loads the
+  //region's own table. A custom one can leave out channels that don't work at your site.
+  //ERROR_INVALID_PARAMETER if count is 0 or over RFID_MAX_HOP_CHANNELS, otherwise RESPONSE_SUCCESS
+  //or RESPONSE_FAIL. Modules turn down channels outside the region's band.
+  uint8_t setHopTable(const uint32_t *freqs, uint8_t count);
+  uint8_t getHopTable(uint32_t *freqs, uint8_t &count); //count: room at freqs going in, channels coming out
+  uint8_t setHopTime(uint32_t hopTime); //ms on each channel
+  uint8_t getHopTime(uint32_t &hopTime);
+
+  //Antenna ports. Ports the module doesn't have are turned down with ERROR_INVALID_PARAMETER
+  //before anything is sent. Otherwise RESPONSE_SUCCESS or RESPONSE_FAIL.
+  uint8_t setAntennaPort(uint8_t txPort = 1, uint8_t rxPort = 1);
+  void setAntennaSearchList(void); //Port 1 only
+  uint8_t setAntennaSearchList(const uint8_t *ports, uint8_t portCount); //Ports a read cycles through, each TX and RX on the same port
+  uint8_t setAntennaPortPowers(const RFID_AntennaPort *ports, uint8_t portCount); //Read and write power of each port
+
   void setTagProtocol(uint8_t protocol = 0x05);
 
   void startReading(void); //Disable filtering and start reading continuously
+  void startReading(const RFID_ReadConfig &config); //Same, with the metadata, search flags, duty cycle, protocol and filter of your choice
   void stopReading(void);  //Stops continuous read. Give 1000 to 2000ms for the module to stop reading.
+  boolean isReading(void) { return (_continuousReading); }
+
+  //Where tag records go when they arrive in the middle of a blocking command, like setReadPower()
+  void setTagCallback(RFID_TagCallback callback) { _tagCallback = callback; }
+
+  //How blocking commands pass the time until the module answers. Without one they call yield().
+  void setWaitCallback(RFID_WaitCallback callback) { _waitCallback = callback; }
+
+  //Buffered inventory: the module searches for searchTime ms, collecting tags in its own
+  //buffer, then nextBufferedTag() pulls them out many records per frame
+  uint8_t readTagsBuffered(uint16_t searchTime, uint16_t metadataFlags = RFID_BUFFERED_METADATA);
+  bool nextBufferedTag(uint16_t timeOut = COMMAND_TIME_OUT); //Loads the next tag into getTagRecord(). False once they're all out.
+  uint32_t getBufferedTagCount(void) { return (_bufferTagCount); } //Unique tags the last readTagsBuffered() found
+  uint8_t clearTagBuffer(void);
 
   void pinMode(uint8_t pin, ThingMagic_PinMode_t mode);
   void digitalWrite(uint8_t pin, uint8_t state);
@@ -121,24 +520,65 @@ public:
 
   void setReaderConfiguration(uint8_t option1, uint8_t option2);
   void getOptionalParameters(uint8_t option1, uint8_t option2);
-  void setProtocolParameters(void);
-  void getProtocolParameters(uint8_t option1, uint8_t option2);
+  void getProtocolParameters(uint8_t option1, uint8_t option2); //Raw GET_PROTOCOL_PARAM for protocol option1, key option2. Answer is left in msg.
+
+  //Gen2 inventory settings. Values the module type can't take are turned down with
+  //ERROR_INVALID_PARAMETER before anything is sent. Otherwise RESPONSE_SUCCESS or RESPONSE_FAIL.
+  uint8_t setProtocolParameters(const RFID_Gen2Parameters &parameters); //All of them, in one go
+  uint8_t getProtocolParameters(RFID_Gen2Parameters &parameters);
+  uint8_t setGen2Session(ThingMagic_Gen2Session_t session);
+  uint8_t getGen2Session(ThingMagic_Gen2Session_t &session);
+  uint8_t setGen2Target(ThingMagic_Gen2Target_t target);
+  uint8_t getGen2Target(ThingMagic_Gen2Target_t &target);
+  uint8_t setGen2Q(uint8_t q); //0 to RFID_GEN2_MAX_Q, or RFID_GEN2_DYNAMIC_Q
+  uint8_t getGen2Q(uint8_t &q);
+  uint8_t setGen2Encoding(ThingMagic_Gen2Encoding_t encoding);
+  uint8_t getGen2Encoding(ThingMagic_Gen2Encoding_t &encoding);
+  uint8_t setGen2LinkFrequency(ThingMagic_Gen2LinkFrequency_t linkFrequency);
+  uint8_t getGen2LinkFrequency(ThingMagic_Gen2LinkFrequency_t &linkFrequency);
+  uint8_t setGen2Tari(ThingMagic_Gen2Tari_t tari);
+  uint8_t getGen2Tari(ThingMagic_Gen2Tari_t &tari);
 
   uint8_t parseResponse(void);
 
+  const RFID_TagRecord &getTagRecord(void) const { return (_tagRecord); } //Everything parseResponse() found in the last tag record
+
   uint8_t getTagEPCBytes(void);   //Pull number of EPC data bytes from record response.
   uint8_t getTagDataBytes(void);  //Pull number of tag data bytes from record response. Often zero.
-  uint16_t getTagTimestamp(void); //Pull timestamp value from full record response
+  uint32_t getTagTimestamp(void); //Pull timestamp value from full record response
   uint32_t getTagFreq(void);      //Pull Freq value from full record response
   int8_t getTagRSSI(void);        //Pull RSSI value from full record response
 
-  bool check(void);
+  bool update(void); //Services the serial port. Returns true when a frame that isn't a command's answer (tag, keep-alive) is ready for parseResponse().
+  bool check(void);  //Same as update()
+
+  //Non-blocking commands. Returns false if a command is already out. update() collects the answer,
+  //then calls callback (if given) and getCommandResult() has the outcome.
+  bool sendMessageAsync(uint8_t opcode, uint8_t *data = 0, uint8_t size = 0, RFID_CommandCallback callback = NULL, uint16_t timeOut = COMMAND_TIME_OUT);
+  bool isCommandPending(void) { return (_commandPending); }
+  const RFID_CommandResult &getCommandResult(void) const { return (_commandResult); }
+
+  uint32_t getDiscardedBytes(void) { return (_rxDiscarded); } //Bytes thrown away while hunting for the start of a frame
+  uint32_t getRejectedFrames(void) { return (_rxRejected); }  //Frames dropped because of a bad length or CRC
+  uint32_t getDroppedFrames(void) { return (_rxDropped); }    //Tag frames that arrived during a blocking command with no tag callback set
+  void resetReceiveCounters(void);
+
+#if RFID_ENABLE_METRICS
+  void getMetrics(RFID_Metrics &metrics) const { metrics = _metrics; } //Snapshot of everything counted so far, or since resetMetrics()
+  void resetMetrics(void);
+#endif
 
   uint8_t readTagEPC(uint8_t *epc, uint8_t &epcLength, uint16_t timeOut = COMMAND_TIME_OUT);
   uint8_t writeTagEPC(char *newID, uint8_t newIDLength, uint16_t timeOut = COMMAND_TIME_OUT);
 
   uint8_t readData(uint8_t bank, uint32_t address, uint8_t *dataRead, uint8_t &dataLengthRead, uint16_t timeOut = COMMAND_TIME_OUT);
-  uint8_t writeData(uint8_t bank, uint32_t address, uint8_t *dataToRecord, uint8_t dataLengthToRecord, uint16_t timeOut = COMMAND_TIME_OUT);
+  uint8_t readRanges(RFID_ReadRange *ranges, uint8_t rangeCount, uint16_t timeOut = COMMAND_TIME_OUT); //Several reads from one tag, merged where they can be
+  uint8_t writeData(uint8_t bank, uint32_t address, uint8_t *dataToRecord, uint8_t dataLengthToRecord, uint16_t timeOut = COMMAND_TIME_OUT); //ERROR_INVALID_PARAMETER if it won't fit in one frame, see writeBlocks()
+
+  //Large writes: split into Gen2 BlockWrites (or plain writes for tags without BlockWrite), optionally read back to check
+  uint8_t writeBlocks(uint8_t bank, uint32_t wordAddress, const uint8_t *data, uint16_t length, boolean verify = false, uint16_t timeOut = COMMAND_TIME_OUT);
+  void setBlockWriteSize(uint8_t words) { _blockWriteWords = (words > RFID_MAX_BLOCK_WORDS) ? RFID_MAX_BLOCK_WORDS : words; } //0 = never use BlockWrite
+  uint8_t getBlockWriteSize(void) { return (_blockWriteWords); } //What writeBlocks() has learned the tags take
 
   uint8_t readUserData(uint8_t *userData, uint8_t &userDataLength, uint16_t timeOut = COMMAND_TIME_OUT);
   uint8_t writeUserData(uint8_t *userData, uint8_t userDataLength, uint16_t timeOut = COMMAND_TIME_OUT);
@@ -154,12 +594,20 @@ public:
 
   uint8_t killTag(uint8_t *password, uint8_t passwordLength, uint16_t timeOut = COMMAND_TIME_OUT);
 
+  //Singulation for the tag commands above and for readTagsBuffered(). Until cleared, only tags
+  //matching filter will answer. Continuous reads take theirs from RFID_ReadConfig instead.
+  void setTagFilter(const RFID_TagFilter &filter) { _tagFilter = filter; }
+  void clearTagFilter(void) { _tagFilter = RFID_TagFilter(); }
+  const RFID_TagFilter &getTagFilter(void) const { return (_tagFilter); }
+
   void sendMessage(uint8_t opcode, uint8_t *data = 0, uint8_t size = 0, uint16_t timeOut = COMMAND_TIME_OUT, boolean waitForResponse = true);
-  void sendCommand(uint16_t timeOut = COMMAND_TIME_OUT, boolean waitForResponse = true);
+  void sendCommand(uint16_t timeOut = COMMAND_TIME_OUT, boolean waitForResponse = true); //msg[0] = ERROR_COMMAND_PENDING while a sendMessageAsync() command is out
 
   void printMessageArray(void);
 
-  uint16_t calculateCRC(uint8_t *u8Buf, uint8_t len);
+  //Static so helpers (like the module simulator) can frame messages too
+  static uint16_t calculateCRC(const uint8_t *u8Buf, uint8_t len, uint16_t crc = 0xFFFF);
+  static uint16_t updateCRC(uint16_t crc, uint8_t value); //Add one byte to a running CRC
 
   //Variables
 
@@ -168,9 +616,7 @@ public:
   //And before returning, response will be recorded into the msg array. Default is 255 bytes.
   uint8_t msg[MAX_MSG_SIZE];
 
-  //uint16_t tags[MAX_NUMBER_OF_TAGS][12]; //Assumes EPC won't be longer than 12 bytes
-  //uint16_t tagRSSI[MAX_NUMBER_OF_TAGS];
-  //uint16_t uniqueTags = 0;
+  //To keep track of unique tags, feed getTagRecord() into an RFID_Inventory (SparkFun_UHF_RFID_Inventory.h)
 
 private:
   Stream *_nanoSerial; //The generic connection to user's chosen serial hardware
@@ -178,8 +624,78 @@ private:
   Stream *_debugSerial; //The stream to send debug messages to if enabled
 
   uint8_t _head = 0; //Tracks the length of the incoming message as we poll the software serial
+  uint8_t _frameLength = 0; //Total length of the frame being received, known once the LEN byte arrives
+  uint16_t _rxCRC = 0xFFFF; //CRC of the frame being received, updated as each byte comes in
+  uint8_t _rxPending = 0;   //Bytes after the last completed frame that still need to be decoded
+  boolean _msgCRCValid = false; //msg holds a frame whose CRC check() has already verified
+  uint32_t _rxDiscarded = 0;
+  uint32_t _rxRejected = 0;
+  uint32_t _rxDropped = 0;
+  boolean _continuousReading = false; //Tag records may arrive at any time
+  RFID_TagCallback _tagCallback = NULL;
+  RFID_WaitCallback _waitCallback = NULL;
+
+  RFID_TagRecord _tagRecord = {}; //Last tag record cracked by parseResponse()
+  bool decodeTagRecord(void);
+  bool decodeMetadata(uint16_t metadataFlags, uint8_t &spot, uint8_t end);
+  bool decodeEPC(uint8_t &spot, uint8_t end);
+
+  //Buffered inventory, see readTagsBuffered()
+  uint32_t _bufferTagCount = 0;     //Tags the last search found
+  uint32_t _bufferTagsLeft = 0;     //Tags still to be pulled from the module
+  uint16_t _bufferMetadata = RFID_BUFFERED_METADATA;
+  uint8_t _bufferRecordsLeft = 0;   //Records in msg not handed out yet
+  uint8_t _bufferSpot = 0;          //Where the next record in msg starts
+  boolean _bufferNeedsClear = false; //Module's buffer may hold tags from an earlier search
+
+  bool receiveFrame(void);
+  bool syncFrame(void);
+  bool rejectFrame(bool badLength);
+  void dropFrame(bool badLength);
+  bool frameReceived(void);
+
+  //Command waiting for its answer, see sendMessageAsync()
+  RFID_CommandResult _commandResult = {};
+  RFID_CommandCallback _commandCallback = NULL;
+  uint32_t _commandStart = 0;
+  uint32_t _commandRejected = 0; //_rxRejected when the command went out
+  uint16_t _commandTimeOut = 0;
+  uint8_t _commandOpcode = 0;
+  boolean _commandPending = false;
+  void beginCommand(uint8_t opcode, uint8_t *data, uint8_t size, RFID_CommandCallback callback, uint16_t timeOut);
+  bool switchBaud(long baudRate, RFID_BaudCallback setHostBaud);
+  bool validGen2Parameters(const RFID_Gen2Parameters &parameters);
+  bool validAntennaPort(uint8_t port);
+  uint8_t setGen2Parameter(uint8_t key, const uint8_t *value, uint8_t size);
+  uint8_t getGen2Parameter(uint8_t key, uint8_t *value, uint8_t size);
+  bool testLink(void);
+  uint8_t buildReadCommand(const RFID_ReadConfig &config, uint8_t *blob);
+  static uint8_t addSelect(const RFID_TagFilter &filter, uint8_t *data, uint8_t &option);
+  bool readTagWords(uint8_t bank, uint32_t address, uint8_t wordCount, uint16_t timeOut, bool &rejected);
+  uint16_t writeTagWords(boolean blockWrite, uint8_t bank, uint32_t address, const uint8_t *words, uint8_t wordCount, uint16_t timeOut);
+  uint8_t _blockWriteWords = RFID_BLOCK_WRITE_WORDS; //BlockWrite size that works, 0 = use WRITE_TAG_DATA
+
+  RFID_TagFilter _tagFilter; //Applied to tag commands, see setTagFilter()
+  void exchangeCommand(uint8_t opcode, uint8_t *data, uint8_t size, uint16_t timeOut, boolean waitForResponse);
+  void transmitCommand(uint8_t opcode, uint8_t *data, uint8_t size);
+  bool streamFrame(void);
+  void finishCommand(uint8_t error);
+  void waitForData(void);
+
+  void printBytes(const uint8_t *bytes, uint8_t length, boolean endLine);
+
+  uint8_t decodeResponse(void);
+
+#if RFID_ENABLE_METRICS
+  RFID_Metrics _metrics = {};
+  uint32_t _commandStartMicros = 0;
+  void recordCommand(uint8_t error);
+#endif
 
   boolean _printDebug = false; //Flag to print the serial commands we are sending to the Serial port for debug
+  RFID_Trace *_trace = NULL;   //Where frames are recorded, if anywhere
 
   ThingMagic_Module_t _moduleType;
 };
+
+#endif //SPARKFUN_UHF_RFID_READER_H
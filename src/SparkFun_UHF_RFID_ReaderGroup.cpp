@@ -0,0 +1,275 @@
+/*
+  Many readers from one Linux process for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  See SparkFun_UHF_RFID_ReaderGroup.h for an overview.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#if defined(__linux__)
+
+#if (ARDUINO >= 100)
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "SparkFun_UHF_RFID_ReaderGroup.h"
+
+#include <new>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+uint8_t RFID_ReaderGroup::add(RFID &reader, RFID_LinuxSerial &port)
+{
+  if (_running == true || _readerCount == RFID_GROUP_MAX_READERS)
+    return (RFID_GROUP_FULL);
+
+  Member &member = _members[_readerCount];
+  member.reader = &reader;
+  member.port = &port;
+  member.tags = 0;
+  member.keepAlives = 0;
+  member.throttles = 0;
+  member.dropped = 0;
+  member.disconnected = 0;
+  return (_readerCount++);
+}
+
+bool RFID_ReaderGroup::begin(uint8_t workers)
+{
+  end();
+
+  if (workers > RFID_GROUP_MAX_WORKERS)
+    workers = RFID_GROUP_MAX_WORKERS;
+  uint8_t shardCount = (workers > 0) ? workers : 1;
+
+  //The queues keep their indexes on separate cache lines, which plain new doesn't promise before C++17
+  void *memory = NULL;
+  if (posix_memalign(&memory, 64, sizeof(Shard) * shardCount) != 0)
+    return (false);
+  _shards = static_cast<Shard *>(memory);
+  for (uint8_t x = 0; x < shardCount; x++)
+    new (&_shards[x]) Shard();
+  _shardCount = shardCount;
+  _workerCount = workers;
+
+  for (uint8_t x = 0; x < _shardCount; x++)
+  {
+    Shard &shard = _shards[x];
+    shard.epollFD = epoll_create1(EPOLL_CLOEXEC);
+    shard.watermark = micros();
+    if (shard.epollFD < 0)
+    {
+      end();
+      return (false);
+    }
+  }
+
+  for (uint8_t x = 0; x < _readerCount; x++)
+  {
+    //A port that hung up stays out until it's opened again
+    _members[x].disconnected = (_members[x].port->isOpen() == false);
+    if (_members[x].disconnected != 0)
+      continue;
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u32 = x;
+    if (epoll_ctl(_shards[x % _shardCount].epollFD, EPOLL_CTL_ADD, _members[x].port->getFD(), &event) != 0)
+    {
+      end();
+      return (false);
+    }
+  }
+
+  _startTime = millis();
+  _running = true;
+  for (uint8_t x = 0; x < _workerCount; x++)
+    _shards[x].thread = std::thread(&RFID_ReaderGroup::runWorker, this, std::ref(_shards[x]));
+
+  return (true);
+}
+
+void RFID_ReaderGroup::end(void)
+{
+  _running = false;
+
+  for (uint8_t x = 0; x < _shardCount; x++)
+  {
+    Shard &shard = _shards[x];
+    if (shard.thread.joinable())
+      shard.thread.join();
+    if (shard.epollFD >= 0)
+      close(shard.epollFD);
+    shard.~Shard();
+  }
+  free(_shards);
+  _shards = NULL;
+  _shardCount = 0;
+  _workerCount = 0;
+}
+
+uint16_t RFID_ReaderGroup::read(RFID_TagEvent *tags, uint16_t maxTags, uint32_t timeOut)
+{
+  if (_shardCount == 0)
+    return (0);
+
+  uint32_t start = millis();
+  uint32_t waitTime = 0; //Take what's already there first
+  while (true)
+  {
+    if (_workerCount == 0)
+      service(_shards[0], waitTime);
+    else if (waitTime > 0)
+    {
+      //Workers signal every tick, so a missed signal costs one tick at most
+      std::unique_lock<std::mutex> hold(_signalLock);
+      _signal.wait_for(hold, std::chrono::milliseconds(waitTime < RFID_GROUP_TICK ? waitTime : RFID_GROUP_TICK));
+    }
+
+    uint16_t count = merge(tags, maxTags);
+    uint32_t elapsed = millis() - start;
+    if (count > 0 || elapsed >= timeOut)
+      return (count);
+    waitTime = timeOut - elapsed;
+  }
+}
+
+RFID_GroupStats RFID_ReaderGroup::getStats(uint8_t reader)
+{
+  RFID_GroupStats stats = {};
+  if (reader >= _readerCount)
+    return (stats);
+
+  Member &member = _members[reader];
+  stats.tags = member.tags;
+  stats.keepAlives = member.keepAlives;
+  stats.throttles = member.throttles;
+  stats.dropped = member.dropped;
+  stats.disconnected = member.disconnected;
+  return (stats);
+}
+
+RFID_GroupStats RFID_ReaderGroup::getTotals(void)
+{
+  RFID_GroupStats totals = {};
+  for (uint8_t x = 0; x < _readerCount; x++)
+  {
+    RFID_GroupStats stats = getStats(x);
+    totals.tags += stats.tags;
+    totals.keepAlives += stats.keepAlives;
+    totals.throttles += stats.throttles;
+    totals.dropped += stats.dropped;
+    totals.disconnected += stats.disconnected;
+  }
+  return (totals);
+}
+
+float RFID_ReaderGroup::getTagRate(uint8_t reader)
+{
+  uint32_t elapsed = millis() - _startTime;
+  return (elapsed ? getStats(reader).tags * 1000.0 / elapsed : 0);
+}
+
+float RFID_ReaderGroup::getTotalRate(void)
+{
+  uint32_t elapsed = millis() - _startTime;
+  return (elapsed ? getTotals().tags * 1000.0 / elapsed : 0);
+}
+
+//Waits up to timeOut ms for any of the shard's ports, then decodes everything that came in
+void RFID_ReaderGroup::service(Shard &shard, int timeOut)
+{
+  struct epoll_event events[RFID_GROUP_MAX_READERS];
+  int ready = epoll_wait(shard.epollFD, events, RFID_GROUP_MAX_READERS, timeOut);
+  for (int x = 0; x < ready; x++)
+  {
+    serviceReader(shard, events[x].data.u32);
+
+    //epoll would report a dead port on every call from now on and the worker would spin
+    if ((events[x].events & (EPOLLHUP | EPOLLERR)) != 0)
+      disconnect(shard, events[x].data.u32);
+  }
+
+  //Anything decoded from here on is stamped later than this
+  shard.watermark = micros();
+}
+
+//Decodes every frame the reader's port has
+void RFID_ReaderGroup::serviceReader(Shard &shard, uint8_t index)
+{
+  Member &member = _members[index];
+  while (member.reader->check() == true)
+  {
+    uint8_t responseType = member.reader->parseResponse();
+    if (responseType == RESPONSE_IS_TAGFOUND)
+    {
+      member.tags++;
+      if (shard.queue.push(member.reader->getTagRecord(), index) == false)
+        member.dropped++;
+    }
+    else if (responseType == RESPONSE_IS_KEEPALIVE)
+      member.keepAlives++;
+    else if (responseType == RESPONSE_IS_TEMPTHROTTLE)
+      member.throttles++;
+  }
+}
+
+//The reader's port hung up. Frames it got out before then have been decoded.
+void RFID_ReaderGroup::disconnect(Shard &shard, uint8_t index)
+{
+  Member &member = _members[index];
+  epoll_ctl(shard.epollFD, EPOLL_CTL_DEL, member.port->getFD(), NULL);
+  member.port->end();
+  member.disconnected = 1;
+}
+
+void RFID_ReaderGroup::runWorker(Shard &shard)
+{
+  while (_running == true)
+  {
+    service(shard, RFID_GROUP_TICK);
+    _signal.notify_one();
+  }
+}
+
+//Hands out queued tags oldest first across all shards. A shard with nothing queued may
+//still be decoding something older than the oldest tag on offer, so that tag waits until
+//the shard's watermark has passed it.
+uint16_t RFID_ReaderGroup::merge(RFID_TagEvent *tags, uint16_t maxTags)
+{
+  uint16_t count = 0;
+  while (count < maxTags)
+  {
+    //Watermarks before queues: a worker queues a tag before moving its watermark past it
+    uint32_t watermarks[RFID_GROUP_MAX_WORKERS];
+    for (uint8_t x = 0; x < _shardCount; x++)
+      watermarks[x] = _shards[x].watermark;
+
+    const RFID_TagEvent *heads[RFID_GROUP_MAX_WORKERS];
+    int8_t oldest = -1;
+    for (uint8_t x = 0; x < _shardCount; x++)
+    {
+      heads[x] = _shards[x].queue.peek();
+      if (heads[x] != NULL && (oldest < 0 || (int32_t)(heads[x]->time - heads[oldest]->time) < 0))
+        oldest = x;
+    }
+    if (oldest < 0)
+      break;
+
+    for (uint8_t x = 0; x < _shardCount; x++)
+      if (heads[x] == NULL && (int32_t)(watermarks[x] - heads[oldest]->time) < 0)
+        return (count);
+
+    count += _shards[oldest].queue.pop(&tags[count], 1);
+  }
+  return (count);
+}
+
+#endif //__linux__
@@ -0,0 +1,143 @@
+/*
+  Many readers from one Linux process for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  A portal with several readers would otherwise need a thread per reader spinning in
+  check(). RFID_ReaderGroup watches all their serial ports with epoll instead and decodes
+  frames only when bytes have arrived. Tags from every reader come out of read() as one
+  feed, oldest first, each marked with the reader it came from.
+
+  With begin(0) everything happens on the thread that calls read(). With begin(workers)
+  the readers are split across that many threads, reader i going to worker i % workers,
+  each with its own epoll. read() merges what the workers decode by time stamp. A worker
+  says how far it has got every RFID_GROUP_TICK ms, so a tag is held back at most that long
+  while the other workers catch up.
+
+    RFID_LinuxSerial port1("/dev/ttyUSB0"), port2("/dev/ttyUSB1");
+    RFID reader1, reader2;
+    ...set up each reader and startReading()...
+    RFID_ReaderGroup group;
+    group.add(reader1, port1); //Reader 0
+    group.add(reader2, port2); //Reader 1
+    group.begin(2);
+    RFID_TagEvent tags[32];
+    while (true)
+    {
+      uint16_t count = group.read(tags, 32, 100);
+      ...
+    }
+
+  The group owns the readers between begin() and end(). Send them commands before begin()
+  or after end(), never in between.
+
+  A reader whose port hangs up (its USB adapter unplugged) is dropped from the group and its
+  port closed, so the others carry on. getStats() shows it as disconnected.
+
+  Each worker (or read() with begin(0)) gets a queue of RFID_GROUP_QUEUE_TAGS tags, about
+  25 KB at the default size. begin() allocates them and end() lets them go.
+
+  Only built on Linux.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#ifndef SPARKFUN_UHF_RFID_READER_GROUP_H
+#define SPARKFUN_UHF_RFID_READER_GROUP_H
+
+#if defined(__linux__)
+
+#include "SparkFun_UHF_RFID_Reader.h"
+#include "SparkFun_UHF_RFID_LinuxSerial.h"
+#include "SparkFun_UHF_RFID_TagQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#define RFID_GROUP_MAX_READERS 64
+#define RFID_GROUP_MAX_WORKERS 16
+#define RFID_GROUP_QUEUE_TAGS 1024 //Tags each worker can hold for read(), a power of two. More are counted as dropped.
+#define RFID_GROUP_TICK 10         //Most ms a worker waits before saying how far it has got
+#define RFID_GROUP_FULL 0xFF       //add() couldn't take the reader
+
+//Counts for one reader, or all of them
+struct RFID_GroupStats
+{
+  uint32_t tags;         //Tag records decoded
+  uint32_t keepAlives;   //Search cycles that found nothing
+  uint32_t throttles;    //Keep-alives saying the module was too hot to transmit
+  uint32_t dropped;      //Tags lost because read() wasn't keeping up
+  uint32_t disconnected; //1 if the reader's port hung up and was closed. In the totals, how many readers.
+};
+
+class RFID_ReaderGroup
+{
+public:
+  RFID_ReaderGroup(void) {}
+  ~RFID_ReaderGroup(void) { end(); }
+
+  //Returns the reader's number, or RFID_GROUP_FULL. Readers can only be added before begin().
+  uint8_t add(RFID &reader, RFID_LinuxSerial &port);
+
+  //0 workers = read() does all the work. Returns false if epoll can't be set up.
+  bool begin(uint8_t workers = 0);
+  void end(void); //Stops the workers. The readers are the caller's again.
+
+  //Waits up to timeOut ms for tags, then copies up to maxTags of them into tags, oldest first
+  //Returns how many. Call it from one thread only.
+  uint16_t read(RFID_TagEvent *tags, uint16_t maxTags, uint32_t timeOut);
+
+  uint8_t getReaderCount(void) { return (_readerCount); }
+  RFID_GroupStats getStats(uint8_t reader);
+  RFID_GroupStats getTotals(void);
+  float getTagRate(uint8_t reader); //Tags/s since begin()
+  float getTotalRate(void);
+
+private:
+  struct Member
+  {
+    RFID *reader;
+    RFID_LinuxSerial *port;
+    std::atomic<uint32_t> tags;
+    std::atomic<uint32_t> keepAlives;
+    std::atomic<uint32_t> throttles;
+    std::atomic<uint32_t> dropped;
+    std::atomic<uint32_t> disconnected;
+  };
+
+  //A worker's readers and the tags it has decoded for read()
+  struct Shard
+  {
+    int epollFD = -1;
+    std::thread thread;
+    RFID_TagQueue<RFID_GROUP_QUEUE_TAGS> queue; //The worker pushes, read() pops
+    std::atomic<uint32_t> watermark; //Everything decoded up to this micros() is in the queue
+  };
+
+  void service(Shard &shard, int timeOut);
+  void serviceReader(Shard &shard, uint8_t index);
+  void disconnect(Shard &shard, uint8_t index);
+  void runWorker(Shard &shard);
+  uint16_t merge(RFID_TagEvent *tags, uint16_t maxTags);
+
+  Member _members[RFID_GROUP_MAX_READERS];
+  uint8_t _readerCount = 0;
+
+  Shard *_shards = NULL; //_shardCount of them, from begin()
+  uint8_t _shardCount = 0;
+  uint8_t _workerCount = 0;
+  std::atomic<bool> _running{false};
+  uint32_t _startTime = 0;
+
+  //Workers nudge read() when there's something new
+  std::mutex _signalLock;
+  std::condition_variable _signal;
+};
+
+#endif //__linux__
+
+#endif //SPARKFUN_UHF_RFID_READER_GROUP_H
@@ -0,0 +1,1387 @@
+/*
+  Simulated ThingMagic module for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  See SparkFun_UHF_RFID_Simulator.h for an overview.
+
+  Frame layouts follow the ones documented in SparkFun_UHF_RFID_Reader.cpp:
+    Command:  FF LEN OPCODE [LEN bytes of data] CRCHI CRCLO
+    Response: FF LEN OPCODE STATUSHI STATUSLO [LEN bytes of data] CRCHI CRCLO
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#if (ARDUINO >= 100)
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "SparkFun_UHF_RFID_Simulator.h"
+
+//Status words the module uses. See tmr__status_8h.html from the Mercury API
+#define SIM_STATUS_OK 0x0000
+#define SIM_STATUS_INVALID_OPCODE 0x0101
+#define SIM_STATUS_UNIMPLEMENTED_OPCODE 0x0102
+#define SIM_STATUS_INVALID_PARAMETER_VALUE 0x0105
+#define SIM_STATUS_NO_TAGS_FOUND 0x0400
+#define SIM_STATUS_GEN2_OTHER_ERROR 0x0420
+#define SIM_STATUS_GEN2_MEMORY_OVERRUN 0x0423
+#define SIM_STATUS_TEMPERATURE_EXCEEDED 0x0504
+
+RFID_Simulator::RFID_Simulator(void)
+{
+  //Default memory contents of the tag that answers single tag operations
+  memset(_reservedBank, 0, sizeof(_reservedBank));
+
+  memset(_epcBank, 0, sizeof(_epcBank));
+  _epcBank[2] = (RFID_SIM_EPC_BYTES / 2) << 3; //PC word: EPC length in words lives in the top 5 bits
+  buildEPC(&_epcBank[4], 0);
+
+  //E2 = class ID, 003412 = Impinj-like vendor and model, then a unique serial
+  const uint8_t tid[] = {0xE2, 0x00, 0x34, 0x12, 0x01, 0x6E, 0xFE, 0x00, 0x03, 0x7D, 0x9A, 0xA3};
+  memcpy(_tidBank, tid, sizeof(_tidBank));
+
+  memset(_userBank, 0, sizeof(_userBank));
+
+  loadRegionHopTable();
+}
+
+void RFID_Simulator::begin(long baudRate)
+{
+  _hostBaud = baudRate;
+}
+
+void RFID_Simulator::setTagPopulation(uint16_t tagCount)
+{
+  _tagCount = tagCount;
+  _nextTag = 0;
+}
+
+void RFID_Simulator::setTagRate(uint16_t tagsPerSecond)
+{
+  _tagRate = tagsPerSecond;
+}
+
+void RFID_Simulator::setRealTime(boolean realTime)
+{
+  _realTime = realTime;
+}
+
+void RFID_Simulator::setErrorRate(uint32_t perMillion)
+{
+  _errorRate = perMillion;
+}
+
+void RFID_Simulator::setReliableBaud(long baudRate)
+{
+  _reliableBaud = baudRate;
+}
+
+void RFID_Simulator::setAntennaPorts(uint8_t portCount)
+{
+  _portCount = (portCount > RFID_MAX_ANTENNA_PORTS) ? RFID_MAX_ANTENNA_PORTS : portCount;
+}
+
+void RFID_Simulator::setPortTags(uint8_t port, uint16_t firstTag, uint16_t tagCount)
+{
+  if (port == 0 || port > RFID_MAX_ANTENNA_PORTS)
+    return;
+  _portFirstTag[port - 1] = firstTag;
+  _portTagCount[port - 1] = tagCount;
+}
+
+void RFID_Simulator::setNoisyChannel(uint32_t freq, uint8_t lossPercent)
+{
+  _noisyFreq = freq;
+  _noisyLoss = (lossPercent > 100) ? 100 : lossPercent;
+}
+
+//Rolls the dice on a byte getting damaged on the wire
+//Above the reliable baud rate, 1 byte in 100 goes bad on top of the configured error rate
+boolean RFID_Simulator::lineError(void)
+{
+  if (_errorRate > 0 && random32() % 1000000UL < _errorRate)
+    return (true);
+  if (_reliableBaud > 0 && _moduleBaud > _reliableBaud && random32() % 100 == 0)
+    return (true);
+  return (false);
+}
+
+//Number of queued bytes that have had time to cross the wire at the module's baud rate
+uint16_t RFID_Simulator::releasedBytes(void)
+{
+  if (_realTime == false)
+    return (_txCount);
+
+  uint32_t elapsed = micros() - _epochUs;
+  uint32_t due = (uint64_t)elapsed * _moduleBaud / 10000000UL; //10 bits per byte on the wire
+
+  if (due < _releasedSinceEpoch)
+    return (0);
+  due -= _releasedSinceEpoch;
+
+  if (due > _txCount)
+    due = _txCount;
+  return (due);
+}
+
+//Generate any unsolicited traffic (tag records, keep-alives) that is due
+void RFID_Simulator::service(void)
+{
+  if (_searching == true && millis() - _searchStart >= _searchTime)
+    finishSearch();
+
+  updateTemperature();
+
+  if (_reading == false)
+    return;
+
+  uint32_t now = millis();
+  if (now - _lastKeepAlive >= 1000)
+  {
+    _lastKeepAlive = now;
+    //Status 0x0400 = keep-alive, 0x0504 = too hot to transmit
+    respond(TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE, _throttled ? SIM_STATUS_TEMPERATURE_EXCEEDED : SIM_STATUS_NO_TAGS_FOUND);
+  }
+
+  if (_tagCount == 0 || _killed == true || _throttled == true)
+    return;
+
+  //RF is off for part of each cycle when a duty cycle was asked for
+  if (_offTime > 0 && (now - _readStart) % ((uint32_t)_onTime + _offTime) >= _onTime)
+    return;
+
+  //Stay a few frames ahead of the host, but don't run away from it
+  while (RFID_SIM_TX_BUFFER_SIZE - _txCount >= MAX_MSG_SIZE)
+  {
+    if (_tagRate > 0)
+    {
+      uint32_t interval = 1000000UL / _tagRate;
+      uint32_t nowUs = micros();
+      if (nowUs - _lastTagUs < interval)
+        return;
+      _lastTagUs += interval;
+      if (nowUs - _lastTagUs > interval * 4)
+        _lastTagUs = nowUs; //Don't try to catch up after a long pause
+    }
+
+    //Only tags the Select picks out, and in view of the port, answer
+    uint8_t port = getActivePort();
+    uint16_t skipped = 0;
+    while (tagInView(_nextTag, port) == false || tagSelected(_nextTag, _streamFilter) == false)
+    {
+      if (++_nextTag >= _tagCount)
+        _nextTag = 0;
+      if (++skipped >= _tagCount)
+        return; //None of them do
+    }
+
+    //Interference on the channel costs reads. The odd one makes it through damaged.
+    boolean lost = false;
+    if (_noisyLoss > 0 && currentChannel() == _noisyFreq && random32() % 100 < _noisyLoss)
+    {
+      lost = true;
+      _corruptEPC = (random32() % 4 == 0);
+    }
+
+    if (lost == false || _corruptEPC == true)
+    {
+      uint8_t frame[MAX_MSG_SIZE];
+      _recordPort = port;
+      uint8_t length = buildTagFrame(frame, _nextTag, _streamMetadata);
+      _recordPort = 1;
+      queueFrame(frame, length);
+      _tagFramesSent++;
+      _corruptEPC = false;
+    }
+
+    if (++_nextTag >= _tagCount)
+      _nextTag = 0;
+
+    if (_realTime == true && _tagRate == 0 && releasedBytes() < _txCount)
+      return; //Link is saturated, let the host catch up
+  }
+}
+
+//Steps the thermal model up to now
+void RFID_Simulator::updateTemperature(void)
+{
+  uint32_t now = millis();
+  uint32_t elapsed = now - _thermalUpdate;
+  if (elapsed == 0)
+    return;
+  _thermalUpdate = now;
+
+  //Share of the time the RF is on
+  float duty = 0;
+  if (_throttled == false)
+  {
+    if (_reading == true)
+      duty = (float)_onTime / (_onTime + _offTime);
+    else if (_searching == true)
+      duty = 1;
+  }
+
+  float watts = pow(10, _readPower / 1000.0) / 1000.0; //_readPower is in 0.01 dBm
+  float settled = _ambient + RFID_SIM_DEGREES_PER_WATT * watts * duty;
+  _temperature += (settled - _temperature) * elapsed / (float)(_thermalTimeConstant + elapsed);
+
+  if (_throttled == false && _temperature >= RFID_SIM_THROTTLE_TEMPERATURE)
+    _throttled = true;
+  else if (_throttled == true && _temperature <= RFID_SIM_RESUME_TEMPERATURE)
+    _throttled = false;
+}
+
+int RFID_Simulator::available(void)
+{
+  if (_pendingBaud != 0 && _txCount == 0)
+  {
+    _moduleBaud = _pendingBaud;
+    _pendingBaud = 0;
+  }
+
+  service();
+  return (releasedBytes());
+}
+
+int RFID_Simulator::peek(void)
+{
+  if (available() == 0)
+    return (-1);
+  return (_txBuffer[_txHead]);
+}
+
+int RFID_Simulator::read(void)
+{
+  if (available() == 0)
+    return (-1);
+
+  uint8_t value = _txBuffer[_txHead++];
+  _txHead %= RFID_SIM_TX_BUFFER_SIZE;
+  _txCount--;
+  _releasedSinceEpoch++;
+
+  //Re-base the pacing clock so the counters never overflow during long runs
+  if (_releasedSinceEpoch >= 10000)
+  {
+    _epochUs += (uint64_t)_releasedSinceEpoch * 10000000UL / _moduleBaud;
+    _releasedSinceEpoch = 0;
+  }
+
+  //A baud rate mismatch produces framing garbage on a real link
+  if (_hostBaud != _moduleBaud)
+    value ^= (uint8_t)random32() | 0x01;
+
+  //Line noise: flip a bit, or lose the byte entirely and hand over the next one
+  if (lineError() == true)
+  {
+    uint32_t damage = random32();
+    if ((damage & 0x08) || available() == 0)
+      value ^= 1 << (damage & 0x07);
+    else
+      return (read());
+  }
+
+  return (value);
+}
+
+//Takes bytes from the host, one command frame at a time
+size_t RFID_Simulator::write(uint8_t value)
+{
+  //A host that talks without reading the baud rate answer still finds the module switched,
+  //as long as the answer has finished going out
+  if (_pendingBaud != 0 && releasedBytes() == _txCount)
+  {
+    _moduleBaud = _pendingBaud;
+    _pendingBaud = 0;
+  }
+
+  if (_hostBaud != _moduleBaud)
+    return (1); //The module can't make sense of what it hears
+
+  if (lineError() == true)
+    value ^= 1 << (random32() & 0x07); //Noise works both ways
+
+  if (_rxCount == 0 && value != 0xFF)
+    return (1); //Wait for header byte
+
+  _rxBuffer[_rxCount++] = value;
+
+  //Commands are LEN + 5 bytes long (header, length, opcode, data, 2 CRC)
+  if (_rxCount > 1 && (_rxBuffer[1] > MAX_MSG_SIZE - 5 || _rxCount == _rxBuffer[1] + 5))
+  {
+    uint8_t length = _rxBuffer[1];
+    uint16_t crc = RFID::calculateCRC(&_rxBuffer[1], length + 2);
+    if (length <= MAX_MSG_SIZE - 5 && _rxBuffer[length + 3] == (crc >> 8) && _rxBuffer[length + 4] == (crc & 0xFF))
+    {
+      _commandsReceived++;
+      processCommand();
+    }
+    _rxCount = 0;
+  }
+
+  return (1);
+}
+
+void RFID_Simulator::flush(void)
+{
+  //Nothing to wait on, commands are handled as soon as they are written
+}
+
+void RFID_Simulator::queueByte(uint8_t value)
+{
+  if (_txCount == RFID_SIM_TX_BUFFER_SIZE)
+    return; //Overrun, just like a real UART
+
+  if (_txCount == 0)
+  {
+    //Line was idle, this byte starts transmitting now
+    _epochUs = micros();
+    _releasedSinceEpoch = 0;
+  }
+
+  _txBuffer[(_txHead + _txCount) % RFID_SIM_TX_BUFFER_SIZE] = value;
+  _txCount++;
+  _bytesSent++;
+}
+
+void RFID_Simulator::queueFrame(const uint8_t *frame, uint8_t length)
+{
+  for (uint8_t x = 0; x < length; x++)
+    queueByte(frame[x]);
+}
+
+//Package up a response frame and queue it for the host
+void RFID_Simulator::respond(uint8_t opcode, uint16_t status, const uint8_t *data, uint8_t size)
+{
+  uint8_t frame[MAX_MSG_SIZE];
+
+  if (size > MAX_MSG_SIZE - 7)
+    size = MAX_MSG_SIZE - 7;
+
+  frame[0] = 0xFF;
+  frame[1] = size;
+  frame[2] = opcode;
+  frame[3] = status >> 8;
+  frame[4] = status & 0xFF;
+  for (uint8_t x = 0; x < size; x++)
+    frame[5 + x] = data[x];
+
+  uint16_t crc = RFID::calculateCRC(&frame[1], size + 4);
+  frame[size + 5] = crc >> 8;
+  frame[size + 6] = crc & 0xFF;
+
+  queueFrame(frame, size + 7);
+}
+
+//Act on a complete, CRC checked command in _rxBuffer
+void RFID_Simulator::processCommand(void)
+{
+  uint8_t size = _rxBuffer[1];
+  uint8_t opcode = _rxBuffer[2];
+  uint8_t *data = &_rxBuffer[3];
+
+  switch (opcode)
+  {
+  case TMR_SR_OPCODE_VERSION:
+  {
+    //Bootloader, hardware, firmware date, firmware version, supported protocols
+    const uint8_t version[] = {0x12, 0x03, 0x00, 0x00,
+                               0x18, 0x16, 0x00, 0x01,
+                               0x20, 0x16, 0x10, 0x03,
+                               0x01, 0x07, 0x00, 0x06,
+                               0x00, 0x00, 0x00, 0x10};
+    respond(opcode, SIM_STATUS_OK, version, sizeof(version));
+    break;
+  }
+
+  case TMR_SR_OPCODE_SET_BAUD_RATE:
+    //Answer at the old rate, then switch once the answer is out
+    if (size >= 4)
+    {
+      _pendingBaud = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+      respond(opcode, SIM_STATUS_OK);
+    }
+    break;
+
+  case TMR_SR_OPCODE_SET_REGION:
+    _region = data[0];
+    loadRegionHopTable();
+    respond(opcode, SIM_STATUS_OK);
+    break;
+
+  case TMR_SR_OPCODE_SET_FREQ_HOP_TABLE:
+  case TMR_SR_OPCODE_GET_FREQ_HOP_TABLE:
+    hopTable(opcode);
+    break;
+
+  case TMR_SR_OPCODE_SET_READ_TX_POWER:
+    _readPower = (data[0] << 8) | data[1];
+    respond(opcode, SIM_STATUS_OK);
+    break;
+
+  case TMR_SR_OPCODE_SET_WRITE_TX_POWER:
+    _writePower = (data[0] << 8) | data[1];
+    respond(opcode, SIM_STATUS_OK);
+    break;
+
+  case TMR_SR_OPCODE_GET_READ_TX_POWER:
+  case TMR_SR_OPCODE_GET_WRITE_TX_POWER:
+  {
+    int16_t power = (opcode == TMR_SR_OPCODE_GET_READ_TX_POWER) ? _readPower : _writePower;
+    uint8_t response[] = {0x00, (uint8_t)(power >> 8), (uint8_t)(power & 0xFF)};
+    respond(opcode, SIM_STATUS_OK, response, sizeof(response));
+    break;
+  }
+
+  case TMR_SR_OPCODE_SET_USER_GPIO_OUTPUTS:
+    if (size == 4) //{option, pin, mode, state} from RFID::pinMode()
+    {
+      if (data[2] == ThingMagic_PinMode_OUTPUT)
+        _gpioMode |= 1 << data[1];
+      else
+        _gpioMode &= ~(1 << data[1]);
+    }
+    else if (size == 2) //{pin, state} from RFID::digitalWrite()
+    {
+      if (data[1])
+        _gpioState |= 1 << data[0];
+      else
+        _gpioState &= ~(1 << data[0]);
+    }
+    respond(opcode, SIM_STATUS_OK);
+    break;
+
+  case TMR_SR_OPCODE_GET_USER_GPIO_INPUTS:
+  {
+    //Option byte, then pin, mode, state for each of the 4 GPIO
+    uint8_t response[1 + 4 * 3];
+    response[0] = 0x01;
+    for (uint8_t pin = 1; pin <= 4; pin++)
+    {
+      response[1 + (pin - 1) * 3] = pin;
+      response[2 + (pin - 1) * 3] = (_gpioMode >> pin) & 0x01;
+      response[3 + (pin - 1) * 3] = (_gpioState >> pin) & 0x01;
+    }
+    respond(opcode, SIM_STATUS_OK, response, sizeof(response));
+    break;
+  }
+
+  case TMR_SR_OPCODE_GET_PROTOCOL_PARAM:
+  case TMR_SR_OPCODE_SET_PROTOCOL_PARAM:
+    protocolParameter(opcode);
+    break;
+
+  case TMR_SR_OPCODE_GET_TEMPERATURE:
+  {
+    updateTemperature();
+    uint8_t response[] = {(uint8_t)(int8_t)_temperature};
+    respond(opcode, SIM_STATUS_OK, response, sizeof(response));
+    break;
+  }
+
+  case TMR_SR_OPCODE_GET_READER_OPTIONAL_PARAMS:
+  {
+    //Echo the keys back with a zero value
+    uint8_t response[] = {data[0], data[1], 0x00};
+    respond(opcode, SIM_STATUS_OK, response, sizeof(response));
+    break;
+  }
+
+  case TMR_SR_OPCODE_SET_ANTENNA_PORT:
+    antennaPort();
+    break;
+
+  case TMR_SR_OPCODE_SET_TAG_PROTOCOL:
+  case TMR_SR_OPCODE_SET_READER_OPTIONAL_PARAMS:
+  case TMR_SR_OPCODE_GET_POWER_MODE:
+    respond(opcode, SIM_STATUS_OK);
+    break;
+
+  case TMR_SR_OPCODE_READ_TAG_DATA:
+    readTagMemory();
+    break;
+
+  case TMR_SR_OPCODE_WRITE_TAG_DATA:
+  case TMR_SR_OPCODE_WRITE_TAG_ID:
+    writeTagMemory();
+    break;
+
+  case TMR_SR_OPCODE_KILL_TAG:
+    killTagCommand();
+    break;
+
+  case TMR_SR_OPCODE_WRITE_TAG_SPECIFIC:
+    blockWrite();
+    break;
+
+  case TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE:
+    startSearch();
+    break;
+
+  case TMR_SR_OPCODE_GET_TAG_ID_BUFFER:
+    sendTagBuffer();
+    break;
+
+  case TMR_SR_OPCODE_CLEAR_TAG_ID_BUFFER:
+    _bufferCount = 0;
+    _bufferNext = 0;
+    _bufferTag = 0;
+    respond(opcode, SIM_STATUS_OK);
+    break;
+
+  case TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP:
+    //00 00 = Timeout, then option: 01 = start continuous reading, 02 = stop
+    if (size >= 3 && data[2] == 0x01)
+    {
+      startContinuousRead();
+      _reading = true;
+      _readStart = millis();
+      _lastKeepAlive = _readStart;
+      _lastTagUs = micros();
+    }
+    else if (size >= 3 && data[2] == 0x02)
+    {
+      _reading = false;
+    }
+    respond(opcode, SIM_STATUS_OK);
+    break;
+
+  default:
+    respond(opcode, SIM_STATUS_INVALID_OPCODE);
+    break;
+  }
+}
+
+//Picks the stream options out of a start continuous read command. See RFID::buildReadCommand().
+//[8] 22, [9] option, [10, 11] search flags, [12, 13] on time, then off time if the
+//duty cycle flag is set, then metadata flags if the option says so, then access password and Select,
+//then the embedded command if the search flags say so
+void RFID_Simulator::startContinuousRead(void)
+{
+  uint8_t size = _rxBuffer[1];
+  uint8_t *data = &_rxBuffer[3];
+
+  _streamSearchFlags = 0x001B;
+  _streamMetadata = RFID_DEFAULT_METADATA;
+  _onTime = 1000;
+  _offTime = 0;
+  _streamFilter = RFID_TagFilter();
+  _embeddedWords = 0;
+
+  if (size < 14 || data[8] != TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE)
+    return;
+
+  uint8_t spot = 9;
+  uint8_t option = data[spot++];
+  _streamSearchFlags = (data[spot] << 8) | data[spot + 1];
+  spot += 2;
+  _onTime = (data[spot] << 8) | data[spot + 1];
+  spot += 2;
+
+  if ((_streamSearchFlags & TMR_SR_SEARCH_FLAG_DUTY_CYCLE_CONTROL) && spot + 2 <= size)
+  {
+    _offTime = (data[spot] << 8) | data[spot + 1];
+    spot += 2;
+  }
+
+  _streamMetadata = TMR_TRD_METADATA_FLAG_NONE;
+  if ((option & 0x10) && spot + 2 <= size)
+  {
+    _streamMetadata = (data[spot] << 8) | data[spot + 1];
+    spot += 2;
+  }
+
+  if (option & 0x07)
+    spot += 4; //Access password
+  parseSelect(option, spot, _streamFilter);
+
+  //[count] [length] 28 [timeout 2] [option] [bank] [address 4] [word count]
+  if ((_streamSearchFlags & TMR_SR_SEARCH_FLAG_EMBEDDED_COMMAND) && spot + 12 <= size && data[spot + 2] == TMR_SR_OPCODE_READ_TAG_DATA)
+  {
+    spot += 6;
+    _embeddedBank = data[spot++];
+    _embeddedAddress = ((uint32_t)data[spot] << 24) | ((uint32_t)data[spot + 1] << 16) | ((uint32_t)data[spot + 2] << 8) | data[spot + 3];
+    _embeddedWords = data[spot + 4];
+  }
+}
+
+//Picks the Select out of a tag command, starting at data[spot] (just past the password)
+//Leaves spot after it. A command without one gets a filter that matches everything.
+//Returns false if the command is too short to hold the Select its option byte promises.
+boolean RFID_Simulator::parseSelect(uint8_t option, uint8_t &spot, RFID_TagFilter &filter)
+{
+  uint8_t size = _rxBuffer[1];
+  uint8_t *data = &_rxBuffer[3];
+
+  filter = RFID_TagFilter();
+
+  uint8_t bank;
+  switch (option & 0x07)
+  {
+  case TMR_SR_GEN2_SINGULATION_OPTION_SELECT_DISABLED:
+    return (true);
+  case TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_ADDRESSED_EPC:
+    bank = TMR_GEN2_BANK_EPC;
+    break;
+  case TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_TID:
+    bank = TMR_GEN2_BANK_TID;
+    break;
+  case TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_USER_MEM:
+    bank = TMR_GEN2_BANK_USER;
+    break;
+  default:
+    return (false); //Not something the library sends
+  }
+
+  if (spot + 5 > size)
+    return (false);
+
+  uint32_t pointer = ((uint32_t)data[spot] << 24) | ((uint32_t)data[spot + 1] << 16) | ((uint32_t)data[spot + 2] << 8) | data[spot + 3];
+  uint8_t bits = data[spot + 4];
+  spot += 5;
+
+  if (spot + (bits + 7) / 8 > size)
+    return (false);
+
+  filter.setMask(bank, pointer, &data[spot], bits);
+  filter.setInvert(option & TMR_SR_GEN2_SINGULATION_OPTION_INVERSE_SELECT_BIT);
+  spot += (bits + 7) / 8;
+  return (true);
+}
+
+//Copies a bank of a tag in the field into memory and returns its size in bytes
+//Only tag 0 has memory that can be written; the others are built from their index
+uint8_t RFID_Simulator::tagMemory(uint16_t tagIndex, uint8_t bank, uint8_t *memory)
+{
+  uint8_t bankWords;
+  uint8_t *bankMemory = bankPointer(bank, bankWords);
+  if (bankMemory == 0)
+    return (0);
+
+  memcpy(memory, bankMemory, bankWords * 2);
+
+  if (tagIndex != 0)
+  {
+    if (bank == TMR_GEN2_BANK_EPC)
+      buildEPC(&memory[4], tagIndex);
+    else if (bank == TMR_GEN2_BANK_TID)
+    {
+      memory[bankWords * 2 - 2] = tagIndex >> 8; //Unique serial
+      memory[bankWords * 2 - 1] = tagIndex & 0xFF;
+    }
+    else
+      memset(memory, 0, bankWords * 2);
+  }
+
+  return (bankWords * 2);
+}
+
+//True if a tag would answer under filter
+boolean RFID_Simulator::tagSelected(uint16_t tagIndex, const RFID_TagFilter &filter)
+{
+  if (filter.isActive() == false)
+    return (true);
+
+  uint8_t memory[RFID_SIM_USER_BYTES];
+  uint16_t memoryBits = tagMemory(tagIndex, filter.bank, memory) * 8;
+
+  boolean match = true;
+  for (uint16_t x = 0; x < filter.bitLength && match == true; x++)
+  {
+    uint32_t bit = filter.bitPointer + x;
+    if (bit >= memoryBits)
+      match = false; //Mask runs off the end of the bank
+    else if (((memory[bit / 8] >> (7 - bit % 8)) & 0x01) != ((filter.mask[x / 8] >> (7 - x % 8)) & 0x01))
+      match = false;
+  }
+
+  return (match != filter.invert);
+}
+
+//Returns the memory behind a Gen2 bank and its size in words
+uint8_t *RFID_Simulator::bankPointer(uint8_t bank, uint8_t &bankWords)
+{
+  switch (bank)
+  {
+  case 0x00:
+    bankWords = sizeof(_reservedBank) / 2;
+    return (_reservedBank);
+  case 0x01:
+    bankWords = sizeof(_epcBank) / 2;
+    return (_epcBank);
+  case 0x02:
+    bankWords = sizeof(_tidBank) / 2;
+    return (_tidBank);
+  case 0x03:
+    bankWords = sizeof(_userBank) / 2;
+    return (_userBank);
+  }
+  bankWords = 0;
+  return (0);
+}
+
+//READ_TAG_DATA: [timeout 2] [option] [metadata 2 if option 0x10] [bank] [address 4] [word count]
+//then [access password 4] [Select] if the option asks for one
+void RFID_Simulator::readTagMemory(void)
+{
+  uint8_t *data = &_rxBuffer[3];
+  uint8_t spot = 2;
+  uint8_t option = data[spot++];
+  if (option & 0x10)
+    spot += 2; //Metadata flags
+
+  uint8_t bank = data[spot++];
+  uint32_t address = ((uint32_t)data[spot] << 24) | ((uint32_t)data[spot + 1] << 16) | ((uint32_t)data[spot + 2] << 8) | data[spot + 3];
+  spot += 4;
+  uint8_t wordCount = data[spot++];
+
+  if (option & 0x07)
+    spot += 4; //Access password
+  RFID_TagFilter filter;
+  if (parseSelect(option, spot, filter) == false)
+  {
+    respond(TMR_SR_OPCODE_READ_TAG_DATA, SIM_STATUS_GEN2_OTHER_ERROR);
+    return;
+  }
+
+  if (_tagCount == 0 || _killed == true || tagSelected(0, filter) == false)
+  {
+    respond(TMR_SR_OPCODE_READ_TAG_DATA, SIM_STATUS_NO_TAGS_FOUND);
+    return;
+  }
+
+  uint8_t bankWords;
+  uint8_t *memory = bankPointer(bank, bankWords);
+  if (memory == 0 || address >= bankWords || address + wordCount > bankWords)
+  {
+    respond(TMR_SR_OPCODE_READ_TAG_DATA, SIM_STATUS_GEN2_MEMORY_OVERRUN);
+    return;
+  }
+  if (wordCount == 0)
+    wordCount = bankWords - address; //Zero means 'rest of the bank'
+  else if (_partialReads == false && address + wordCount < bankWords)
+  {
+    respond(TMR_SR_OPCODE_READ_TAG_DATA, SIM_STATUS_GEN2_OTHER_ERROR);
+    return;
+  }
+
+  //Option and metadata echo, then the words
+  uint8_t response[3 + RFID_SIM_USER_BYTES];
+  response[0] = option;
+  response[1] = 0x00;
+  response[2] = 0x00;
+  memcpy(&response[3], &memory[address * 2], wordCount * 2);
+
+  respond(TMR_SR_OPCODE_READ_TAG_DATA, SIM_STATUS_OK, response, 3 + wordCount * 2);
+}
+
+//WRITE_TAG_DATA: [timeout 2] [option] [address 4] [bank] [access password 4 and Select if the option asks] [data]
+void RFID_Simulator::writeTagMemory(void)
+{
+  uint8_t size = _rxBuffer[1];
+  uint8_t *data = &_rxBuffer[3];
+  uint8_t opcode = _rxBuffer[2];
+
+  uint8_t option = data[2];
+  uint8_t spot = 8;
+  RFID_TagFilter filter;
+  if (option & 0x07)
+    spot += 4; //Access password
+  if (parseSelect(option, spot, filter) == false || spot > size)
+  {
+    respond(opcode, SIM_STATUS_GEN2_OTHER_ERROR);
+    return;
+  }
+
+  if (_tagCount == 0 || _killed == true || tagSelected(0, filter) == false)
+  {
+    respond(opcode, SIM_STATUS_NO_TAGS_FOUND);
+    return;
+  }
+
+  uint32_t address = ((uint32_t)data[3] << 24) | ((uint32_t)data[4] << 16) | ((uint32_t)data[5] << 8) | data[6];
+  uint8_t bank = data[7];
+  uint8_t length = size - spot;
+
+  uint8_t bankWords;
+  uint8_t *memory = bankPointer(bank, bankWords);
+  if (memory == 0 || address * 2 + length > (uint16_t)bankWords * 2)
+  {
+    respond(opcode, SIM_STATUS_GEN2_MEMORY_OVERRUN);
+    return;
+  }
+
+  memcpy(&memory[address * 2], &data[spot], length);
+  respond(opcode, SIM_STATUS_OK);
+}
+
+//WRITE_TAG_SPECIFIC carrying a Gen2 BlockWrite: [timeout 2] [chip type] [option] [00] [C7]
+//[access password 4 and Select if the option asks] [write flags] [bank] [address 4] [word count] [words]
+void RFID_Simulator::blockWrite(void)
+{
+  uint8_t size = _rxBuffer[1];
+  uint8_t *data = &_rxBuffer[3];
+
+  if (size < 6 || data[5] != TMR_SR_GEN2_BLOCK_WRITE)
+  {
+    respond(TMR_SR_OPCODE_WRITE_TAG_SPECIFIC, SIM_STATUS_INVALID_OPCODE);
+    return;
+  }
+
+  uint8_t option = data[3];
+  uint8_t spot = 6;
+  RFID_TagFilter filter;
+  if (option & 0x07)
+    spot += 4; //Access password
+  if (parseSelect(option, spot, filter) == false || spot + 7 > size)
+  {
+    respond(TMR_SR_OPCODE_WRITE_TAG_SPECIFIC, SIM_STATUS_GEN2_OTHER_ERROR);
+    return;
+  }
+
+  if (_tagCount == 0 || _killed == true || tagSelected(0, filter) == false)
+  {
+    respond(TMR_SR_OPCODE_WRITE_TAG_SPECIFIC, SIM_STATUS_NO_TAGS_FOUND);
+    return;
+  }
+
+  spot++; //Write flags
+  uint8_t bank = data[spot++];
+  uint32_t address = ((uint32_t)data[spot] << 24) | ((uint32_t)data[spot + 1] << 16) | ((uint32_t)data[spot + 2] << 8) | data[spot + 3];
+  spot += 4;
+  uint8_t wordCount = data[spot++];
+
+  //Tags only take blocks up to their own size
+  if (wordCount == 0 || wordCount > _blockWriteWords || spot + wordCount * 2 > size)
+  {
+    respond(TMR_SR_OPCODE_WRITE_TAG_SPECIFIC, SIM_STATUS_GEN2_OTHER_ERROR);
+    return;
+  }
+
+  uint8_t bankWords;
+  uint8_t *memory = bankPointer(bank, bankWords);
+  if (memory == 0 || address + wordCount > bankWords)
+  {
+    respond(TMR_SR_OPCODE_WRITE_TAG_SPECIFIC, SIM_STATUS_GEN2_MEMORY_OVERRUN);
+    return;
+  }
+
+  memcpy(&memory[address * 2], &data[spot], wordCount * 2);
+  _blockWrites++;
+  respond(TMR_SR_OPCODE_WRITE_TAG_SPECIFIC, SIM_STATUS_OK);
+}
+
+//SET_PROTOCOL_PARAM: [protocol] [key] [value]
+//GET_PROTOCOL_PARAM: [protocol] [key], answered with [protocol] [key] [value]
+//Only the Gen2 keys RFID knows about are kept. Values aren't checked.
+void RFID_Simulator::protocolParameter(uint8_t opcode)
+{
+  uint8_t size = _rxBuffer[1];
+  uint8_t *data = &_rxBuffer[3];
+  boolean set = (opcode == TMR_SR_OPCODE_SET_PROTOCOL_PARAM);
+
+  if (size < 2 || data[0] != TMR_TAG_PROTOCOL_GEN2)
+  {
+    respond(opcode, SIM_STATUS_INVALID_PARAMETER_VALUE);
+    return;
+  }
+
+  uint8_t *value;
+  uint8_t valueSize;
+  switch (data[1])
+  {
+  case TMR_SR_GEN2_CONFIGURATION_SESSION:
+    value = &_gen2Session;
+    valueSize = 1;
+    break;
+  case TMR_SR_GEN2_CONFIGURATION_TARGET:
+    value = _gen2Target;
+    valueSize = 2;
+    break;
+  case TMR_SR_GEN2_CONFIGURATION_Q:
+    value = _gen2Q;
+    valueSize = 1 + ((set == true ? data[2] : _gen2Q[0]) == 0x01); //Static Q carries the Q value too
+    break;
+  case TMR_SR_GEN2_CONFIGURATION_TAGENCODING:
+    value = &_gen2Encoding;
+    valueSize = 1;
+    break;
+  case TMR_SR_GEN2_CONFIGURATION_LINKFREQUENCY:
+    value = &_gen2LinkFrequency;
+    valueSize = 1;
+    break;
+  case TMR_SR_GEN2_CONFIGURATION_TARI:
+    value = &_gen2Tari;
+    valueSize = 1;
+    break;
+  default:
+    respond(opcode, SIM_STATUS_UNIMPLEMENTED_OPCODE);
+    return;
+  }
+
+  if (set == true)
+  {
+    if (size - 2 != valueSize)
+    {
+      respond(opcode, SIM_STATUS_INVALID_PARAMETER_VALUE);
+      return;
+    }
+    memcpy(value, &data[2], valueSize);
+    respond(opcode, SIM_STATUS_OK);
+    return;
+  }
+
+  uint8_t response[2 + 2];
+  response[0] = data[0];
+  response[1] = data[1];
+  memcpy(&response[2], value, valueSize);
+  respond(opcode, SIM_STATUS_OK, response, 2 + valueSize);
+}
+
+//What SET_REGION loads. Only Europe's four channels and the North American band are modelled,
+//every other region gets the North American channels.
+void RFID_Simulator::loadRegionHopTable(void)
+{
+  if (_region == REGION_EUROPE)
+  {
+    _hopCount = 4;
+    for (uint8_t x = 0; x < _hopCount; x++)
+      _hopTable[x] = 865700 + (uint32_t)x * 600;
+  }
+  else
+  {
+    _hopCount = 50;
+    for (uint8_t x = 0; x < _hopCount; x++)
+      _hopTable[x] = 902750 + (uint32_t)x * 500;
+  }
+}
+
+//SET_FREQ_HOP_TABLE: 4 bytes of kHz per channel, or [0x01] [hop time 4]
+//GET_FREQ_HOP_TABLE: nothing for the table, [0x01] for the hop time
+void RFID_Simulator::hopTable(uint8_t opcode)
+{
+  uint8_t size = _rxBuffer[1];
+  uint8_t *data = &_rxBuffer[3];
+  boolean option = (size % 4 == 1 && data[0] == 0x01);
+
+  if (opcode == TMR_SR_OPCODE_GET_FREQ_HOP_TABLE)
+  {
+    uint8_t response[RFID_MAX_HOP_CHANNELS * 4];
+    uint8_t spot = 0;
+    if (option == true)
+    {
+      response[spot++] = 0x01;
+      for (uint8_t y = 0; y < 4; y++)
+        response[spot++] = _hopTime >> (24 - y * 8);
+    }
+    else
+    {
+      for (uint8_t x = 0; x < _hopCount; x++)
+        for (uint8_t y = 0; y < 4; y++)
+          response[spot++] = _hopTable[x] >> (24 - y * 8);
+    }
+    respond(opcode, SIM_STATUS_OK, response, spot);
+    return;
+  }
+
+  if (option == true && size == 5)
+  {
+    uint32_t hopTime = (uint32_t)data[1] << 24 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 8 | data[4];
+    if (hopTime == 0)
+    {
+      respond(opcode, SIM_STATUS_INVALID_PARAMETER_VALUE);
+      return;
+    }
+    _hopTime = hopTime;
+    respond(opcode, SIM_STATUS_OK);
+    return;
+  }
+
+  //A table has to stay inside the UHF RFID bands
+  uint8_t count = size / 4;
+  if (size % 4 != 0 || count == 0 || count > RFID_MAX_HOP_CHANNELS)
+  {
+    respond(opcode, SIM_STATUS_INVALID_PARAMETER_VALUE);
+    return;
+  }
+  for (uint8_t x = 0; x < count; x++)
+  {
+    uint32_t freq = (uint32_t)data[x * 4] << 24 | (uint32_t)data[x * 4 + 1] << 16 | (uint32_t)data[x * 4 + 2] << 8 | data[x * 4 + 3];
+    if (freq < 860000 || freq > 960000)
+    {
+      respond(opcode, SIM_STATUS_INVALID_PARAMETER_VALUE);
+      return;
+    }
+  }
+
+  _hopCount = count;
+  for (uint8_t x = 0; x < count; x++)
+    _hopTable[x] = (uint32_t)data[x * 4] << 24 | (uint32_t)data[x * 4 + 1] << 16 | (uint32_t)data[x * 4 + 2] << 8 | data[x * 4 + 3];
+  respond(opcode, SIM_STATUS_OK);
+}
+
+//The channel the module is on: hopTime ms on each one, in table order
+uint32_t RFID_Simulator::currentChannel(void)
+{
+  return (_hopTable[(millis() / _hopTime) % _hopCount]);
+}
+
+//SET_ANTENNA_PORT: [TX port] [RX port], or an option then a list
+//  0x02 search list: [TX port] [RX port] for each
+//  0x03 port powers: [port] [read power 2] [write power 2] for each
+//Only monostatic use (TX and RX the same port) is modelled
+void RFID_Simulator::antennaPort(void)
+{
+  uint8_t size = _rxBuffer[1];
+  uint8_t *data = &_rxBuffer[3];
+
+  if (size == 2)
+  {
+    if (data[0] == 0 || data[0] > _portCount || data[1] != data[0])
+    {
+      respond(TMR_SR_OPCODE_SET_ANTENNA_PORT, SIM_STATUS_INVALID_PARAMETER_VALUE);
+      return;
+    }
+    _antennaList[0] = data[0];
+    _antennaCount = 1;
+    respond(TMR_SR_OPCODE_SET_ANTENNA_PORT, SIM_STATUS_OK);
+    return;
+  }
+
+  uint8_t entrySize = (data[0] == TMR_SR_ANTENNA_OPTION_SEARCH_LIST) ? 2 : 5;
+  uint8_t count = (size - 1) / entrySize;
+  boolean valid = (data[0] == TMR_SR_ANTENNA_OPTION_SEARCH_LIST || data[0] == TMR_SR_ANTENNA_OPTION_PORT_POWERS);
+  valid = valid && size > 1 && (size - 1) % entrySize == 0 && count <= RFID_MAX_ANTENNA_PORTS;
+  for (uint8_t x = 0; x < count && valid == true; x++)
+  {
+    uint8_t port = data[1 + x * entrySize];
+    if (port == 0 || port > _portCount)
+      valid = false;
+    if (entrySize == 2 && data[2 + x * entrySize] != port)
+      valid = false;
+  }
+  if (valid == false)
+  {
+    respond(TMR_SR_OPCODE_SET_ANTENNA_PORT, SIM_STATUS_INVALID_PARAMETER_VALUE);
+    return;
+  }
+
+  for (uint8_t x = 0; x < count; x++)
+  {
+    uint8_t *entry = &data[1 + x * entrySize];
+    if (entrySize == 2)
+      _antennaList[x] = entry[0];
+    else
+      _portReadPower[entry[0] - 1] = (entry[1] << 8) | entry[2];
+  }
+  if (entrySize == 2)
+    _antennaCount = count;
+
+  respond(TMR_SR_OPCODE_SET_ANTENNA_PORT, SIM_STATUS_OK);
+}
+
+//A read spends one search cycle (the on time) on each port of the list in turn
+uint8_t RFID_Simulator::getActivePort(void)
+{
+  if (_reading == false || _antennaCount == 1 || _onTime == 0)
+    return (_antennaList[0]);
+  return (_antennaList[((millis() - _readStart) / _onTime) % _antennaCount]);
+}
+
+boolean RFID_Simulator::tagInView(uint16_t tagIndex, uint8_t port)
+{
+  uint16_t first = _portFirstTag[port - 1];
+  return (tagIndex >= first && tagIndex - first < _portTagCount[port - 1]);
+}
+
+//First port of the search list that sees the tag, 0 if none do
+uint8_t RFID_Simulator::portFor(uint16_t tagIndex)
+{
+  for (uint8_t x = 0; x < _antennaCount; x++)
+    if (tagInView(tagIndex, _antennaList[x]) == true)
+      return (_antennaList[x]);
+  return (0);
+}
+
+//KILL_TAG: [timeout 2] [option] [password 4] [Select if the option asks] [RFU]
+void RFID_Simulator::killTagCommand(void)
+{
+  uint8_t *data = &_rxBuffer[3];
+
+  uint8_t spot = 7;
+  RFID_TagFilter filter;
+  if (parseSelect(data[2], spot, filter) == false)
+  {
+    respond(TMR_SR_OPCODE_KILL_TAG, SIM_STATUS_GEN2_OTHER_ERROR);
+    return;
+  }
+
+  if (_tagCount == 0 || _killed == true || tagSelected(0, filter) == false)
+  {
+    respond(TMR_SR_OPCODE_KILL_TAG, SIM_STATUS_NO_TAGS_FOUND);
+    return;
+  }
+
+  //Gen2 tags refuse to die with a zero kill password
+  boolean zero = true;
+  for (uint8_t x = 0; x < 4; x++)
+    if (_reservedBank[x] != 0)
+      zero = false;
+
+  if (zero == true || memcmp(&data[3], _reservedBank, 4) != 0)
+  {
+    respond(TMR_SR_OPCODE_KILL_TAG, SIM_STATUS_GEN2_OTHER_ERROR);
+    return;
+  }
+
+  _killed = true;
+  respond(TMR_SR_OPCODE_KILL_TAG, SIM_STATUS_OK);
+}
+
+//Each simulated tag gets a recognizable EPC: 'SIM' followed by its index
+void RFID_Simulator::buildEPC(uint8_t *epc, uint16_t tagIndex)
+{
+  memset(epc, 0, RFID_SIM_EPC_BYTES);
+  epc[0] = 'S';
+  epc[1] = 'I';
+  epc[2] = 'M';
+  epc[RFID_SIM_EPC_BYTES - 2] = tagIndex >> 8;
+  epc[RFID_SIM_EPC_BYTES - 1] = tagIndex & 0xFF;
+}
+
+//Builds a continuous read tag record frame with the given metadata fields
+//See RFID::parseResponse() for the field breakdown.
+uint8_t RFID_Simulator::buildTagFrame(uint8_t *frame, uint16_t tagIndex, uint16_t metadataFlags)
+{
+  uint8_t spot = 0;
+  uint8_t option = (metadataFlags != TMR_TRD_METADATA_FLAG_NONE) ? 0x10 : 0x00;
+
+  frame[spot++] = 0xFF;
+  spot++; //Length, filled in below
+  frame[spot++] = TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE;
+  frame[spot++] = 0x00; //Status
+  frame[spot++] = 0x00;
+  frame[spot++] = option;
+  frame[spot++] = _streamSearchFlags >> 8;
+  frame[spot++] = _streamSearchFlags & 0xFF;
+  if (option & 0x10)
+  {
+    frame[spot++] = metadataFlags >> 8;
+    frame[spot++] = metadataFlags & 0xFF;
+  }
+  frame[spot++] = 0x01; //Tags in this record
+
+  spot += buildTagRecord(&frame[spot], tagIndex, metadataFlags, millis() - _readStart, 1);
+
+  frame[1] = spot - 5; //Everything after status
+
+  uint16_t crc = RFID::calculateCRC(&frame[1], spot - 1);
+  frame[spot++] = crc >> 8;
+  frame[spot++] = crc & 0xFF;
+
+  return (spot);
+}
+
+//Builds the metadata fields named in metadataFlags followed by the EPC length, PC, EPC
+//and EPC CRC. This is the part of a tag record that continuous reads and the tag buffer share.
+uint8_t RFID_Simulator::buildTagRecord(uint8_t *record, uint16_t tagIndex, uint16_t metadataFlags, uint32_t timeStamp, uint8_t readCount)
+{
+  uint8_t spot = 0;
+  uint32_t random = random32();
+
+  if (metadataFlags & TMR_TRD_METADATA_FLAG_READCOUNT)
+    record[spot++] = readCount;
+  if (metadataFlags & TMR_TRD_METADATA_FLAG_RSSI)
+    record[spot++] = (uint8_t)(-40 - (int8_t)(random % 40)); //-40 to -79 dBm
+  if (metadataFlags & TMR_TRD_METADATA_FLAG_ANTENNAID)
+    record[spot++] = _recordPort << 4 | _recordPort; //TX port, RX port
+  if (metadataFlags & TMR_TRD_METADATA_FLAG_FREQUENCY)
+  {
+    uint32_t freq = currentChannel();
+    record[spot++] = freq >> 16;
+    record[spot++] = freq >> 8;
+    record[spot++] = freq;
+  }
+  if (metadataFlags & TMR_TRD_METADATA_FLAG_TIMESTAMP)
+  {
+    record[spot++] = timeStamp >> 24;
+    record[spot++] = timeStamp >> 16;
+    record[spot++] = timeStamp >> 8;
+    record[spot++] = timeStamp;
+  }
+  if (metadataFlags & TMR_TRD_METADATA_FLAG_PHASE)
+  {
+    uint16_t phase = (random >> 16) % 181;
+    record[spot++] = phase >> 8;
+    record[spot++] = phase;
+  }
+  if (metadataFlags & TMR_TRD_METADATA_FLAG_PROTOCOL)
+    record[spot++] = 0x05; //GEN2
+  if (metadataFlags & TMR_TRD_METADATA_FLAG_DATA)
+  {
+    //Embedded data length in bits, then the data. A read past the end of the bank comes back empty.
+    uint8_t memory[RFID_SIM_USER_BYTES];
+    uint8_t bankBytes = (_embeddedWords > 0) ? tagMemory(tagIndex, _embeddedBank, memory) : 0;
+    uint16_t dataBytes = 0;
+    if (_embeddedAddress * 2 + _embeddedWords * 2 <= bankBytes)
+      dataBytes = _embeddedWords * 2;
+
+    record[spot++] = (dataBytes * 8) >> 8;
+    record[spot++] = (dataBytes * 8) & 0xFF;
+    if (dataBytes > 0)
+      memcpy(&record[spot], &memory[_embeddedAddress * 2], dataBytes);
+    spot += dataBytes;
+  }
+  if (metadataFlags & TMR_TRD_METADATA_FLAG_GPIO_STATUS)
+    record[spot++] = 0x0F;
+  if (metadataFlags & TMR_TRD_METADATA_FLAG_GEN2_Q)
+    record[spot++] = 0x04;
+  if (metadataFlags & TMR_TRD_METADATA_FLAG_GEN2_LF)
+    record[spot++] = 0x00;
+  if (metadataFlags & TMR_TRD_METADATA_FLAG_GEN2_TARGET)
+    record[spot++] = 0x00;
+
+  uint16_t epcBits = (4 + RFID_SIM_EPC_BYTES) * 8; //PC + EPC + EPC CRC
+  record[spot++] = epcBits >> 8;
+  record[spot++] = epcBits & 0xFF;
+
+  uint8_t *pc = &record[spot];
+  record[spot++] = (RFID_SIM_EPC_BYTES / 2) << 3;
+  record[spot++] = 0x00;
+  if (tagIndex == 0)
+    memcpy(&record[spot], &_epcBank[4], RFID_SIM_EPC_BYTES); //Tag 0 shows whatever has been written to it
+  else
+    buildEPC(&record[spot], tagIndex);
+  spot += RFID_SIM_EPC_BYTES;
+
+  //EPC CRC is the Gen2 CRC-16 over PC + EPC (poly 0x1021, preset 0xFFFF, inverted)
+  uint16_t epcCRC = 0xFFFF;
+  for (uint8_t x = 0; x < 2 + RFID_SIM_EPC_BYTES; x++)
+  {
+    epcCRC ^= (uint16_t)pc[x] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++)
+      epcCRC = (epcCRC & 0x8000) ? (epcCRC << 1) ^ 0x1021 : (epcCRC << 1);
+  }
+  epcCRC = ~epcCRC;
+  if (_corruptEPC == true)
+    epcCRC ^= 0x0001 << (random % 16);
+  record[spot++] = epcCRC >> 8;
+  record[spot++] = epcCRC & 0xFF;
+
+  return (spot);
+}
+
+//READ_TAG_ID_MULTIPLE outside of continuous reading: [option] [search flags 2] [timeout 2]
+//then [access password 4] [Select] if the option asks for one
+//Fills the tag buffer with every tag in the field the Select picks out. The answer goes out once the search time is up.
+void RFID_Simulator::startSearch(void)
+{
+  uint8_t *data = &_rxBuffer[3];
+
+  _searchFlags = (data[1] << 8) | data[2];
+  _searchTime = (data[3] << 8) | data[4];
+  _searchStart = millis();
+  _searching = true;
+  _embeddedWords = 0; //Records from the buffer carry no embedded data
+
+  uint8_t spot = 9;
+  parseSelect(data[0], spot, _searchFilter);
+
+  _bufferCount = 0;
+  if (_killed == false)
+  {
+    for (uint16_t x = 0; x < _tagCount; x++)
+      if (portFor(x) != 0 && tagSelected(x, _searchFilter) == true)
+        _bufferCount++;
+  }
+  _bufferNext = 0;
+  _bufferTag = 0;
+
+  if (_realTime == false)
+    finishSearch();
+}
+
+void RFID_Simulator::finishSearch(void)
+{
+  _searching = false;
+
+  if (_bufferCount == 0)
+  {
+    respond(TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE, SIM_STATUS_NO_TAGS_FOUND);
+    return;
+  }
+
+  //Option, search flags, then the tag count: 4 bytes with large tag population support, 1 without
+  uint8_t response[7] = {0x00, (uint8_t)(_searchFlags >> 8), (uint8_t)(_searchFlags & 0xFF)};
+  uint8_t size = 3;
+  if (_searchFlags & TMR_SR_SEARCH_FLAG_LARGE_TAG_POPULATION)
+  {
+    response[size++] = 0x00;
+    response[size++] = 0x00;
+    response[size++] = _bufferCount >> 8;
+    response[size++] = _bufferCount & 0xFF;
+  }
+  else
+    response[size++] = (_bufferCount > 255) ? 255 : _bufferCount;
+
+  respond(TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE, SIM_STATUS_OK, response, size);
+}
+
+//GET_TAG_ID_BUFFER: [metadata flags 2] [read options]
+//Answers with as many buffered records as fit in one frame
+void RFID_Simulator::sendTagBuffer(void)
+{
+  uint8_t *data = &_rxBuffer[3];
+  uint16_t metadataFlags = (data[0] << 8) | data[1];
+
+  if (_bufferNext >= _bufferCount)
+  {
+    respond(TMR_SR_OPCODE_GET_TAG_ID_BUFFER, SIM_STATUS_NO_TAGS_FOUND);
+    return;
+  }
+
+  //Metadata flags, read options, record count, then the records
+  uint8_t response[MAX_MSG_SIZE - 7];
+  response[0] = data[0];
+  response[1] = data[1];
+  response[2] = data[2];
+  response[3] = 0;
+  uint8_t size = 4;
+
+  while (_bufferNext < _bufferCount && response[3] < 255)
+  {
+    while (portFor(_bufferTag) == 0 || tagSelected(_bufferTag, _searchFilter) == false)
+      _bufferTag++;
+
+    uint8_t record[MAX_MSG_SIZE];
+    uint32_t timeStamp = random32() % (_searchTime + 1);
+    uint8_t readCount = 1 + random32() % 8;
+    _recordPort = portFor(_bufferTag);
+    uint8_t length = buildTagRecord(record, _bufferTag, metadataFlags, timeStamp, readCount);
+    _recordPort = 1;
+    if (size + length > sizeof(response))
+      break;
+
+    memcpy(&response[size], record, length);
+    size += length;
+    response[3]++;
+    _bufferNext++;
+    _bufferTag++;
+  }
+
+  respond(TMR_SR_OPCODE_GET_TAG_ID_BUFFER, SIM_STATUS_OK, response, size);
+}
+
+//Small xorshift generator so runs are repeatable
+uint32_t RFID_Simulator::random32(void)
+{
+  _randomState ^= _randomState << 13;
+  _randomState ^= _randomState >> 17;
+  _randomState ^= _randomState << 5;
+  return (_randomState);
+}
@@ -0,0 +1,232 @@
+/*
+  Simulated ThingMagic module for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  Pretends to be an M6E Nano / M7E Hecto sitting on the other end of a serial port.
+  Because it is a Stream it can be handed straight to RFID::begin(), which lets the
+  library (and sketches built on it) run without any hardware attached. Useful for
+  benchmarking the parsing path and for testing sketches on the bench.
+
+  The simulator answers the opcodes listed in SparkFun_UHF_RFID_Reader.h with correctly
+  CRC'd frames. Continuous reading streams tag records for a configurable population
+  of tags, paced at the configured baud rate so throughput numbers match a real link.
+  A timed READ_TAG_ID_MULTIPLE fills the tag buffer with the whole population, ready
+  for GET_TAG_ID_BUFFER.
+
+  An embedded READ_TAG_DATA in a continuous read fills in the data metadata field of each
+  tag record with the words asked for.
+
+  The module warms up while its RF is on, more so at high read power, and throttles
+  (keep-alives with status 0x0504, no tags) if it gets too hot, like a real one.
+
+  The module hops through its hop table (the 50 North American channels unless a custom
+  one is loaded), staying hopTime ms on each. One channel can be made noisy to see what
+  interference looks like in the per-channel numbers.
+
+  The module can have up to RFID_MAX_ANTENNA_PORTS antenna ports, each seeing its own range
+  of the population. A read cycles through the antenna search list, one port per search cycle,
+  and every record carries the port it was read on.
+
+  Gen2 Select is honoured everywhere: inventories only report the tags it picks out.
+  Single tag operations are answered by tag 0, the one with writable memory, and only
+  when the Select (if any) matches it.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#ifndef SPARKFUN_UHF_RFID_SIMULATOR_H
+#define SPARKFUN_UHF_RFID_SIMULATOR_H
+
+#include "SparkFun_UHF_RFID_Reader.h"
+
+#define RFID_SIM_TX_BUFFER_SIZE 512 //Bytes queued for the host. Must hold the largest response plus a tag frame.
+#define RFID_SIM_EPC_BYTES 12       //Length of the EPC each simulated tag reports
+#define RFID_SIM_USER_BYTES 64      //User memory of the simulated tag
+#define RFID_SIM_HOP_TIME 400       //ms on each channel. Power up value.
+
+//Thermal model: the module heats towards ambient + degrees per watt of RF times the share of time
+//the RF is on, and gets there at a rate set by the time constant
+#define RFID_SIM_DEGREES_PER_WATT 140      //27.00 dBm all the time settles near 95C
+#define RFID_SIM_THROTTLE_TEMPERATURE 85   //The module stops transmitting here...
+#define RFID_SIM_RESUME_TEMPERATURE 80     //...and starts again once it has cooled to here
+
+class RFID_Simulator : public Stream
+{
+public:
+  RFID_Simulator(void);
+
+  //Mimics HardwareSerial::begin() so sketches can 'open the port' like they normally do
+  //If the host baud rate doesn't match the module's, received bytes are garbled
+  void begin(long baudRate);
+
+  void setTagPopulation(uint16_t tagCount); //Number of tags in the field. Zero is allowed.
+  void setTagRate(uint16_t tagsPerSecond);  //Limit the RF read rate. 0 = only limited by the serial link.
+  void setRealTime(boolean realTime);       //false = bytes are available instantly (no baud rate pacing)
+  void setErrorRate(uint32_t perMillion);   //Chance per byte of a flipped bit or a lost byte, to mimic a noisy cable
+  void setReliableBaud(long baudRate);      //Fastest rate the cable handles cleanly. 0 = no limit.
+  void setPartialReads(boolean supported) { _partialReads = supported; } //false = tag 0 only allows reads of a whole bank
+  void setBlockWriteWords(uint8_t words) { _blockWriteWords = words; }   //Biggest BlockWrite tag 0 takes. 0 = no BlockWrite.
+  void setAmbient(int8_t celsius) { _ambient = celsius; }
+  void setThermalTimeConstant(uint32_t timeConstant) { _thermalTimeConstant = timeConstant; } //ms. Real modules take minutes to warm up.
+  void setAntennaPorts(uint8_t portCount);   //Ports the module has. Commands naming others are turned down.
+  void setPortTags(uint8_t port, uint16_t firstTag, uint16_t tagCount); //Tags in view of a port. Port 1 sees them all until told otherwise.
+  void setNoisyChannel(uint32_t freq, uint8_t lossPercent); //kHz. That share of reads on the channel fails, 1 in 4 of them with a bad EPC CRC. 0 = no noise.
+
+  long getModuleBaud(void) { return (_moduleBaud); }
+  boolean isReading(void) { return (_reading); }
+
+  uint32_t getTagFramesSent(void) { return (_tagFramesSent); }
+  uint32_t getBytesSent(void) { return (_bytesSent); }
+  uint32_t getCommandsReceived(void) { return (_commandsReceived); }
+  uint32_t getBlockWrites(void) { return (_blockWrites); } //BlockWrites that went through
+  float getTemperature(void) { updateTemperature(); return (_temperature); }
+  boolean isThrottled(void) { return (_throttled); }
+  uint8_t getActivePort(void); //Port the search list has the module on
+  int16_t getPortReadPower(uint8_t port) { return ((port >= 1 && port <= RFID_MAX_ANTENNA_PORTS) ? _portReadPower[port - 1] : 0); }
+
+  //Build a complete continuous-read tag record frame for a given tag into frame
+  //Returns the number of bytes in the frame. frame must hold MAX_MSG_SIZE bytes.
+  uint8_t buildTagFrame(uint8_t *frame, uint16_t tagIndex, uint16_t metadataFlags = RFID_DEFAULT_METADATA);
+
+  //Stream interface
+  int available(void);
+  int read(void);
+  int peek(void);
+  size_t write(uint8_t value);
+  void flush(void);
+  using Print::write;
+
+private:
+  void processCommand(void);
+  void respond(uint8_t opcode, uint16_t status, const uint8_t *data = 0, uint8_t size = 0);
+  void queueFrame(const uint8_t *frame, uint8_t length);
+  void queueByte(uint8_t value);
+  uint16_t releasedBytes(void);
+  boolean lineError(void);
+  void service(void);
+  void updateTemperature(void);
+
+  void readTagMemory(void);
+  void writeTagMemory(void);
+  void blockWrite(void);
+  void killTagCommand(void);
+  void protocolParameter(uint8_t opcode);
+  void hopTable(uint8_t opcode);
+  void antennaPort(void);
+  boolean tagInView(uint16_t tagIndex, uint8_t port);
+  uint8_t portFor(uint16_t tagIndex);
+  void loadRegionHopTable(void);
+  uint32_t currentChannel(void);
+  uint8_t *bankPointer(uint8_t bank, uint8_t &bankWords);
+  boolean parseSelect(uint8_t option, uint8_t &spot, RFID_TagFilter &filter);
+  boolean tagSelected(uint16_t tagIndex, const RFID_TagFilter &filter);
+  uint8_t tagMemory(uint16_t tagIndex, uint8_t bank, uint8_t *memory);
+
+  void startContinuousRead(void);
+  void startSearch(void);
+  void finishSearch(void);
+  void sendTagBuffer(void);
+
+  uint8_t buildTagRecord(uint8_t *record, uint16_t tagIndex, uint16_t metadataFlags, uint32_t timeStamp, uint8_t readCount);
+  void buildEPC(uint8_t *epc, uint16_t tagIndex);
+  uint32_t random32(void);
+
+  //Bytes waiting to go to the host
+  uint8_t _txBuffer[RFID_SIM_TX_BUFFER_SIZE];
+  uint16_t _txHead = 0;
+  uint16_t _txCount = 0;
+
+  //Command being received from the host
+  uint8_t _rxBuffer[MAX_MSG_SIZE];
+  uint8_t _rxCount = 0;
+
+  long _hostBaud = 115200;
+  long _moduleBaud = 115200; //Modules power up at 115200
+  long _pendingBaud = 0;     //Rate to switch to once the answer to SET_BAUD_RATE is out
+  long _reliableBaud = 0;
+  boolean _realTime = true;
+  uint32_t _errorRate = 0;
+  uint32_t _epochUs = 0; //Time the oldest queued byte started 'transmitting'
+  uint16_t _releasedSinceEpoch = 0;
+
+  boolean _reading = false;
+  uint16_t _streamSearchFlags = 0x001B; //What the last start continuous read command asked for
+  uint16_t _streamMetadata = RFID_DEFAULT_METADATA;
+  uint16_t _onTime = 1000;
+  uint16_t _offTime = 0;
+  RFID_TagFilter _streamFilter; //Select of the continuous read
+  uint8_t _embeddedBank = 0;     //Embedded READ_TAG_DATA of the continuous read
+  uint32_t _embeddedAddress = 0;
+  uint8_t _embeddedWords = 0;    //0 = none
+  uint16_t _tagCount = 1;
+  uint16_t _tagRate = 0;
+  uint16_t _nextTag = 0;
+  uint32_t _lastTagUs = 0;
+  uint32_t _lastKeepAlive = 0;
+  uint32_t _readStart = 0;
+  uint32_t _randomState = 0x2545F491;
+
+  //Timed search and the tag buffer it fills
+  boolean _searching = false;
+  uint32_t _searchStart = 0;
+  uint16_t _searchTime = 0;
+  uint16_t _searchFlags = 0;
+  uint16_t _bufferCount = 0; //Tags in the buffer
+  uint16_t _bufferNext = 0;  //Tags GET_TAG_ID_BUFFER has handed out
+  uint16_t _bufferTag = 0;   //Where to look for the next one in the population
+  RFID_TagFilter _searchFilter;
+
+  uint8_t _region = REGION_NORTHAMERICA2;
+  uint32_t _hopTable[RFID_MAX_HOP_CHANNELS]; //kHz
+  uint8_t _hopCount = 0;
+  uint32_t _hopTime = RFID_SIM_HOP_TIME;
+  uint32_t _noisyFreq = 0;
+  uint8_t _noisyLoss = 0;
+  boolean _corruptEPC = false; //Next record goes out with a bad EPC CRC
+
+  //Antenna ports, numbered from 1
+  uint8_t _portCount = 1;
+  uint8_t _antennaList[RFID_MAX_ANTENNA_PORTS] = {1}; //Search list
+  uint8_t _antennaCount = 1;
+  uint16_t _portFirstTag[RFID_MAX_ANTENNA_PORTS] = {0};
+  uint16_t _portTagCount[RFID_MAX_ANTENNA_PORTS] = {0xFFFF};
+  int16_t _portReadPower[RFID_MAX_ANTENNA_PORTS] = {2000, 2000, 2000, 2000};
+  uint8_t _recordPort = 1; //Port the next record says it was read on
+  int16_t _readPower = 2000;
+  int16_t _writePower = 2000;
+  uint8_t _gpioMode = 0; //Bit per pin, 1 = output
+  uint8_t _gpioState = 0;
+
+  float _temperature = 25;
+  int8_t _ambient = 25;
+  uint32_t _thermalTimeConstant = 120000;
+  uint32_t _thermalUpdate = 0; //millis() of the last step of the model
+  boolean _throttled = false;
+
+  //Gen2 settings, as they go over the wire. Power up values: S0, target A, dynamic Q, M4, 250kHz, Tari 25us.
+  uint8_t _gen2Session = 0x00;
+  uint8_t _gen2Target[2] = {0x01, 0x00};
+  uint8_t _gen2Q[2] = {0x00, 0x00}; //Dynamic, or static and the Q value
+  uint8_t _gen2Encoding = 0x02;
+  uint8_t _gen2LinkFrequency = 0x00;
+  uint8_t _gen2Tari = 0x00;
+
+  //Memory banks of the tag that answers single tag operations (tag 0)
+  uint8_t _reservedBank[8]; //Kill password then access password
+  uint8_t _epcBank[4 + RFID_SIM_EPC_BYTES];
+  uint8_t _tidBank[12];
+  uint8_t _userBank[RFID_SIM_USER_BYTES];
+  boolean _killed = false;
+  boolean _partialReads = true;
+  uint8_t _blockWriteWords = 8;
+  uint32_t _blockWrites = 0;
+
+  uint32_t _tagFramesSent = 0;
+  uint32_t _bytesSent = 0;
+  uint32_t _commandsReceived = 0;
+};
+
+#endif //SPARKFUN_UHF_RFID_SIMULATOR_H
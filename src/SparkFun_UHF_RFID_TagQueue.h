@@ -0,0 +1,168 @@
+/*
+  Lock-free tag queue for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  Hands decoded tags from the thread running check() and parseResponse() to the thread
+  that uses them. One thread pushes and one thread pops. Neither ever waits on the other
+  or allocates. When the queue is full, push() refuses the tag and counts it as an overflow
+  instead of blocking the reader thread.
+
+  The size is set at compile time and must be a power of two:
+
+    RFID_TagQueue<256> tagQueue;
+
+    //Reader thread
+    if (rfidModule.check() == true && rfidModule.parseResponse() == RESPONSE_IS_TAGFOUND)
+      tagQueue.push(rfidModule.getTagRecord());
+
+    //Application thread
+    RFID_TagEvent tags[32];
+    uint16_t count = tagQueue.pop(tags, 32);
+
+  Needs <atomic>, so it isn't available on AVR.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#ifndef SPARKFUN_UHF_RFID_TAG_QUEUE_H
+#define SPARKFUN_UHF_RFID_TAG_QUEUE_H
+
+#include "SparkFun_UHF_RFID_Reader.h"
+
+#if defined(__has_include)
+#if __has_include(<atomic>)
+#define RFID_HAS_TAG_QUEUE
+#endif
+#endif
+
+//A tag record copied out of the reader's msg, so it can outlive the next frame
+struct RFID_TagEvent
+{
+  uint32_t time;      //micros() when the record was decoded
+  uint32_t freq;      //kHz
+  int8_t rssi;        //dBm
+  uint8_t reader;     //Which reader, for code that runs more than one
+  uint8_t antenna;    //4 MSB = TX port, 4 LSB = RX port
+  uint8_t epcLength;  //Bytes at epc. EPCs longer than RFID_MAX_EPC_BYTES are cut short.
+  uint8_t epc[RFID_MAX_EPC_BYTES];
+
+  void set(const RFID_TagRecord &record, uint8_t readerNumber = 0)
+  {
+    time = micros();
+    freq = record.freq;
+    rssi = record.rssi;
+    reader = readerNumber;
+    antenna = record.antenna;
+    epcLength = (record.epcLength > RFID_MAX_EPC_BYTES) ? RFID_MAX_EPC_BYTES : record.epcLength;
+    memcpy(epc, record.epc, epcLength);
+  }
+};
+
+#if defined(RFID_HAS_TAG_QUEUE)
+
+#include <atomic>
+
+template <uint16_t CAPACITY>
+class RFID_TagQueue
+{
+  static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "RFID_TagQueue size must be a power of two");
+
+public:
+  //Reader thread. Returns false, and counts an overflow, if the queue is full.
+  bool push(const RFID_TagRecord &record, uint8_t reader = 0)
+  {
+    RFID_TagEvent *slot = claim();
+    if (slot == NULL)
+      return (false);
+
+    slot->set(record, reader); //Straight into the queue, no copy
+    publish();
+    return (true);
+  }
+
+  bool push(const RFID_TagEvent &event)
+  {
+    RFID_TagEvent *slot = claim();
+    if (slot == NULL)
+      return (false);
+
+    *slot = event;
+    publish();
+    return (true);
+  }
+
+  //Consumer thread. Copies up to maxTags of the oldest tags into tags and returns how many.
+  uint16_t pop(RFID_TagEvent *tags, uint16_t maxTags)
+  {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    uint32_t count = _tail.load(std::memory_order_acquire) - head;
+    if (count > maxTags)
+      count = maxTags;
+
+    for (uint32_t x = 0; x < count; x++)
+      tags[x] = _events[(head + x) & (CAPACITY - 1)];
+
+    _head.store(head + count, std::memory_order_release);
+    return (count);
+  }
+
+  //Consumer thread. The oldest tag without taking it, or NULL if there isn't one.
+  const RFID_TagEvent *peek(void)
+  {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (_tail.load(std::memory_order_acquire) == head)
+      return (NULL);
+    return (&_events[head & (CAPACITY - 1)]);
+  }
+
+  //Consumer thread. Throws away the oldest tag.
+  void drop(void)
+  {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (_tail.load(std::memory_order_acquire) != head)
+      _head.store(head + 1, std::memory_order_release);
+  }
+
+  //Either thread. Only a guide while the other thread is busy with the queue.
+  uint16_t getCount(void) { return (_tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire)); }
+  uint16_t getCapacity(void) { return (CAPACITY); }
+  bool isEmpty(void) { return (getCount() == 0); }
+  uint32_t getOverflows(void) { return (_overflows.load(std::memory_order_relaxed)); }
+
+  //Only while neither thread is using the queue
+  void clear(void)
+  {
+    _head.store(0);
+    _tail.store(0);
+    _overflows.store(0);
+  }
+
+private:
+  //The slot the next push goes in, or NULL if the queue is full
+  RFID_TagEvent *claim(void)
+  {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _head.load(std::memory_order_acquire) == CAPACITY)
+    {
+      _overflows.fetch_add(1, std::memory_order_relaxed);
+      return (NULL);
+    }
+    return (&_events[tail & (CAPACITY - 1)]);
+  }
+
+  //Lets the consumer see the claimed slot
+  void publish(void) { _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  //Kept on separate cache lines so the two threads don't keep stealing each other's
+  alignas(64) std::atomic<uint32_t> _head{0};      //Next to pop. Only the consumer writes it.
+  alignas(64) std::atomic<uint32_t> _tail{0};      //Next to push. Only the reader thread writes it.
+  alignas(64) std::atomic<uint32_t> _overflows{0}; //Tags push() turned away
+  RFID_TagEvent _events[CAPACITY];
+};
+
+#endif //RFID_HAS_TAG_QUEUE
+
+#endif //SPARKFUN_UHF_RFID_TAG_QUEUE_H
@@ -0,0 +1,207 @@
+/*
+  Temperature-aware duty cycle scheduling for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  See SparkFun_UHF_RFID_Thermal.h for an overview.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#if (ARDUINO >= 100)
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "SparkFun_UHF_RFID_Thermal.h"
+
+void RFID_ThermalScheduler::begin(const RFID_ReadConfig &config, int16_t readPower)
+{
+  if (readPower > 2700)
+    readPower = 2700; //Limit to 27dBm
+
+  _config = config;
+  _minOffTime = config.offTime;
+  _maxPower = readPower;
+  _power = readPower;
+  _sampleCount = 0;
+  _throttles = 0;
+  _coolest = false;
+  _lastSample = millis();
+
+  _reader.setReadPower(_power);
+  _reader.startReading(_config);
+}
+
+void RFID_ThermalScheduler::end(void)
+{
+  _reader.stopReading();
+}
+
+void RFID_ThermalScheduler::feed(uint8_t responseType)
+{
+  if (responseType != RESPONSE_IS_TEMPTHROTTLE)
+    return;
+
+  //Too late to be gentle
+  _throttles++;
+  if (cool(F("throttled")) == true)
+    cool(F("throttled"));
+}
+
+void RFID_ThermalScheduler::update(void)
+{
+  if (millis() - _lastSample >= _sampleTime)
+    sample();
+}
+
+//Takes a reading, fits the trend and makes a step if one is called for
+void RFID_ThermalScheduler::sample(void)
+{
+  _lastSample = millis();
+
+  int8_t temperature;
+  if (_reader.getTemperature(temperature) != RESPONSE_SUCCESS)
+    return;
+  _temperature = temperature;
+
+  if (_sampleCount == RFID_THERMAL_SAMPLES)
+  {
+    memmove(&_sampleTimes[0], &_sampleTimes[1], sizeof(_sampleTimes[0]) * (RFID_THERMAL_SAMPLES - 1));
+    memmove(&_samples[0], &_samples[1], sizeof(_samples[0]) * (RFID_THERMAL_SAMPLES - 1));
+    _sampleCount--;
+  }
+  _sampleTimes[_sampleCount] = _lastSample;
+  _samples[_sampleCount] = temperature;
+  _sampleCount++;
+
+  if (_sampleCount < RFID_THERMAL_MIN_SAMPLES)
+    return;
+
+  //Least squares slope, in C per second
+  float meanTime = 0;
+  float meanTemperature = 0;
+  for (uint8_t x = 0; x < _sampleCount; x++)
+  {
+    meanTime += (_sampleTimes[x] - _sampleTimes[0]) / 1000.0;
+    meanTemperature += _samples[x];
+  }
+  meanTime /= _sampleCount;
+  meanTemperature /= _sampleCount;
+
+  float covariance = 0;
+  float variance = 0;
+  for (uint8_t x = 0; x < _sampleCount; x++)
+  {
+    float time = (_sampleTimes[x] - _sampleTimes[0]) / 1000.0 - meanTime;
+    covariance += time * (_samples[x] - meanTemperature);
+    variance += time * time;
+  }
+  float slope = (variance > 0) ? covariance / variance : 0;
+
+  _trend = slope * 60;
+  _projected = temperature + slope * RFID_THERMAL_HORIZON;
+
+  if (temperature >= _limit || _projected > _limit)
+    cool(F("heading over the limit"));
+  else if (temperature < _limit - RFID_THERMAL_HYSTERESIS && _projected < _limit - RFID_THERMAL_HYSTERESIS && _trend <= 0)
+    warm();
+}
+
+//One step cooler: less power while there's power to give, then more time with the RF off
+//Returns false if there's nothing left to give, or the module turned the step down
+bool RFID_ThermalScheduler::cool(const __FlashStringHelper *reason)
+{
+  if (_power - RFID_THERMAL_POWER_STEP >= _minPower)
+  {
+    if (_reader.setReadPower(_power - RFID_THERMAL_POWER_STEP) != RESPONSE_SUCCESS)
+    {
+      log(F("module turned down less power"));
+      return (false);
+    }
+    _power -= RFID_THERMAL_POWER_STEP;
+  }
+  else if (_config.offTime < _maxOffTime)
+  {
+    _config.offTime += RFID_THERMAL_OFF_STEP;
+    if (_config.offTime > _maxOffTime)
+      _config.offTime = _maxOffTime;
+    restartReading();
+  }
+  else
+  {
+    //Said once, not on every sample until it warms up again
+    if (_coolest == false)
+      log(F("already as cool as allowed"));
+    _coolest = true;
+    return (false);
+  }
+
+  log(reason);
+  _sampleCount = 0; //The old trend no longer applies
+  return (true);
+}
+
+//One step back up, undoing the last thing cool() did
+bool RFID_ThermalScheduler::warm(void)
+{
+  if (_config.offTime > _minOffTime)
+  {
+    _config.offTime -= (_config.offTime - _minOffTime > RFID_THERMAL_OFF_STEP) ? RFID_THERMAL_OFF_STEP : _config.offTime - _minOffTime;
+    restartReading();
+  }
+  else if (_power < _maxPower)
+  {
+    int16_t power = _power + RFID_THERMAL_POWER_STEP;
+    if (power > _maxPower)
+      power = _maxPower;
+    if (_reader.setReadPower(power) != RESPONSE_SUCCESS)
+    {
+      log(F("module turned down more power"));
+      return (false);
+    }
+    _power = power;
+  }
+  else
+    return (false);
+
+  _coolest = false;
+  log(F("room to spare"));
+  _sampleCount = 0;
+  return (true);
+}
+
+//The duty cycle is part of the continuous read command, so the read has to start over
+void RFID_ThermalScheduler::restartReading(void)
+{
+  _reader.stopReading();
+  _reader.startReading(_config);
+}
+
+//Thermal: 72C, +3.20C/min, 75.20C in 60s, heading over the limit -> 25.50dBm, 0ms off
+void RFID_ThermalScheduler::log(const __FlashStringHelper *action)
+{
+  if (_log == NULL)
+    return;
+
+  _log->print(F("Thermal: "));
+  _log->print(_temperature);
+  _log->print(F("C, "));
+  if (_trend >= 0)
+    _log->print(F("+"));
+  _log->print(_trend);
+  _log->print(F("C/min, "));
+  _log->print(_projected);
+  _log->print(F("C in "));
+  _log->print(RFID_THERMAL_HORIZON);
+  _log->print(F("s, "));
+  _log->print(action);
+  _log->print(F(" -> "));
+  _log->print(_power / 100.0);
+  _log->print(F("dBm, "));
+  _log->print(_config.offTime);
+  _log->println(F("ms off"));
+}
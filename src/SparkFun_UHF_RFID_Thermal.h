@@ -0,0 +1,110 @@
+/*
+  Temperature-aware duty cycle scheduling for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  At high read power the module heats up, and at about 85C it throttles: it stops
+  transmitting until it has cooled down, and the read rate falls off a cliff. This runs a
+  continuous read and backs off before that happens.
+
+  Every couple of seconds update() reads the module's temperature and fits a straight line
+  through the recent readings. If that line says the module will be over the limit within
+  a minute, it cools things down by one small step: read power goes down 0.5 dB at a time to
+  a floor, then the RF starts resting between cycles, 100ms more each step. Once the module is
+  comfortably below the limit and not warming, the steps are undone in reverse order. That
+  settles on the most RF the module can keep up.
+
+  If the module throttles anyway, feed() sees it and takes two steps at once.
+
+    RFID_ThermalScheduler scheduler(rfidModule);
+    scheduler.enableLogging(Serial);
+    scheduler.begin(RFID_ReadConfig(), 2700); //Starts the continuous read at up to 27.00 dBm
+    ...
+    if (rfidModule.check() == true)
+      scheduler.feed(rfidModule.parseResponse());
+    scheduler.update();
+
+  Temperature is read with the continuous read running. Tag records that arrive meanwhile
+  go to the tag callback (see RFID::setTagCallback()).
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#ifndef SPARKFUN_UHF_RFID_THERMAL_H
+#define SPARKFUN_UHF_RFID_THERMAL_H
+
+#include "SparkFun_UHF_RFID_Reader.h"
+
+#define RFID_THERMAL_LIMIT 75          //C to stay under. The module throttles at about 85C.
+#define RFID_THERMAL_HYSTERESIS 5      //C below the limit before steps are undone
+#define RFID_THERMAL_SAMPLE_TIME 2000  //ms between temperature readings
+#define RFID_THERMAL_SAMPLES 8         //Readings the trend is fitted to
+#define RFID_THERMAL_MIN_SAMPLES 6     //Readings needed after a change before the next one. Readings are whole degrees, so fewer make a jumpy trend.
+#define RFID_THERMAL_HORIZON 60        //Seconds ahead the trend is projected
+#define RFID_THERMAL_POWER_STEP 50     //Read power step, 0.50 dB
+#define RFID_THERMAL_MIN_POWER 1500    //Lowest read power before the duty cycle takes over, 15.00 dBm
+#define RFID_THERMAL_OFF_STEP 100      //ms of RF off time added per step
+#define RFID_THERMAL_MAX_OFF_TIME 2000 //Most off time per cycle
+
+class RFID_ThermalScheduler
+{
+public:
+  RFID_ThermalScheduler(RFID &reader) : _reader(reader) {}
+
+  //Sets the read power and starts the continuous read with config
+  //readPower is the most the scheduler will use, config's duty cycle the least off time
+  void begin(const RFID_ReadConfig &config, int16_t readPower);
+  void end(void); //Stops the continuous read
+
+  void feed(uint8_t responseType); //Pass every parseResponse() result
+  void update(void);               //Call every loop
+
+  void setLimit(int8_t limit) { _limit = limit; }
+  void setSampleTime(uint16_t sampleTime) { _sampleTime = sampleTime; }
+  void setMinPower(int16_t minPower) { _minPower = minPower; }
+  void setMaxOffTime(uint16_t maxOffTime) { _maxOffTime = maxOffTime; }
+
+  void enableLogging(Print &logPort = Serial) { _log = &logPort; }
+  void disableLogging(void) { _log = NULL; }
+
+  int8_t getTemperature(void) { return (_temperature); } //Last reading, C
+  float getTrend(void) { return (_trend); }              //C per minute
+  int16_t getReadPower(void) { return (_power); }
+  uint16_t getOffTime(void) { return (_config.offTime); }
+  uint16_t getThrottles(void) { return (_throttles); }   //Times the module throttled anyway
+
+private:
+  void sample(void);
+  bool cool(const __FlashStringHelper *reason);
+  bool warm(void);
+  void restartReading(void);
+  void log(const __FlashStringHelper *action);
+
+  RFID &_reader;
+  RFID_ReadConfig _config;
+  Print *_log = NULL;
+
+  int8_t _limit = RFID_THERMAL_LIMIT;
+  uint16_t _sampleTime = RFID_THERMAL_SAMPLE_TIME;
+  int16_t _maxPower = 0;
+  int16_t _minPower = RFID_THERMAL_MIN_POWER;
+  uint16_t _minOffTime = 0;
+  uint16_t _maxOffTime = RFID_THERMAL_MAX_OFF_TIME;
+  int16_t _power = 0;
+
+  //Recent readings, oldest first
+  uint32_t _sampleTimes[RFID_THERMAL_SAMPLES];
+  int8_t _samples[RFID_THERMAL_SAMPLES];
+  uint8_t _sampleCount = 0;
+  uint32_t _lastSample = 0;
+
+  int8_t _temperature = 0;
+  float _trend = 0;
+  float _projected = 0;
+  uint16_t _throttles = 0;
+  boolean _coolest = false; //cool() ran out of steps and has logged it
+};
+
+#endif //SPARKFUN_UHF_RFID_THERMAL_H
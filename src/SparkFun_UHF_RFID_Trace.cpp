@@ -0,0 +1,172 @@
+/*
+  Frame trace for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  See SparkFun_UHF_RFID_Trace.h for an overview.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#if (ARDUINO >= 100)
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "SparkFun_UHF_RFID_Trace.h"
+
+//Entries in the buffer: [type] [length] [time, 4 bytes LSB first] [length bytes], wrapping at the end
+
+void RFID_Trace::record(uint8_t type, const uint8_t *bytes, uint8_t length)
+{
+  start(type, length);
+  add(bytes, length);
+}
+
+void RFID_Trace::start(uint8_t type, uint8_t length)
+{
+  _recording = false;
+  if (_frozen == true || _buffer == NULL)
+    return;
+
+  uint16_t entrySize = RFID_TRACE_HEADER + length;
+  if (entrySize > _size)
+  {
+    _overwritten++;
+    return;
+  }
+
+  //Make room by letting go of the oldest entries
+  while (_size - _used < entrySize)
+  {
+    uint16_t oldestSize = RFID_TRACE_HEADER + _buffer[(_oldest + 1) % _size];
+    _oldest = (_oldest + oldestSize) % _size;
+    _used -= oldestSize;
+    _count--;
+    _overwritten++;
+  }
+
+  uint32_t time = micros();
+  uint8_t header[RFID_TRACE_HEADER] = {type, length, (uint8_t)time, (uint8_t)(time >> 8), (uint8_t)(time >> 16), (uint8_t)(time >> 24)};
+  _used += entrySize;
+  _count++;
+  _recording = true;
+  put(header, sizeof(header));
+}
+
+void RFID_Trace::add(const uint8_t *bytes, uint8_t length)
+{
+  if (_recording == true && length > 0)
+    put(bytes, length);
+}
+
+void RFID_Trace::clear(void)
+{
+  _oldest = 0;
+  _used = 0;
+  _write = 0;
+  _count = 0;
+  _overwritten = 0;
+  _recording = false;
+}
+
+bool RFID_Trace::getEntry(uint16_t index, RFID_TraceEntry &entry, uint8_t *bytes, uint8_t maxBytes)
+{
+  if (index >= _count)
+    return (false);
+
+  uint16_t spot = _oldest;
+  for (uint16_t x = 0; x < index; x++)
+    spot = (spot + RFID_TRACE_HEADER + _buffer[(spot + 1) % _size]) % _size;
+
+  uint8_t header[RFID_TRACE_HEADER];
+  copyOut(spot, header, sizeof(header));
+  entry.type = header[0];
+  entry.length = header[1];
+  entry.time = (uint32_t)header[2] | ((uint32_t)header[3] << 8) | ((uint32_t)header[4] << 16) | ((uint32_t)header[5] << 24);
+
+  if (bytes != NULL)
+    copyOut((spot + RFID_TRACE_HEADER) % _size, bytes, (entry.length < maxBytes) ? entry.length : maxBytes);
+  return (true);
+}
+
+void RFID_Trace::print(Stream &port)
+{
+  RFID_TraceEntry entry;
+  uint8_t bytes[MAX_MSG_SIZE];
+  for (uint16_t x = 0; getEntry(x, entry, bytes, sizeof(bytes)) == true; x++)
+  {
+    port.print(F("  "));
+    port.print(entry.time);
+    port.print(F("us "));
+
+    if (entry.type == RFID_TRACE_ERROR)
+    {
+      uint8_t error = bytes[0];
+      if (error == ERROR_COMMAND_RESPONSE_TIMEOUT && bytes[1] == 0)
+        port.println(F("Time out 1: No response from module"));
+      else if (error == ERROR_COMMAND_RESPONSE_TIMEOUT)
+        port.println(F("Time out 2: Incomplete response"));
+      else if (error == ERROR_CORRUPT_RESPONSE)
+        port.println(F("Corrupt response"));
+      else if (error == ERROR_WRONG_OPCODE_RESPONSE)
+        port.println(F("Wrong opcode response"));
+      else
+      {
+        port.print(F("Error "));
+        port.println(error);
+      }
+      continue;
+    }
+
+    if (entry.type == RFID_TRACE_TX)
+      port.print(F("TX"));
+    else if (entry.type == RFID_TRACE_RX)
+      port.print(F("RX"));
+    else
+      port.print(F("rejected"));
+
+    for (uint8_t y = 0; y < entry.length; y++)
+    {
+      port.print(F(" ["));
+      if (bytes[y] < 0x10)
+        port.print(F("0"));
+      port.print(bytes[y], HEX);
+      port.print(F("]"));
+    }
+    port.println();
+  }
+
+  if (_overwritten > 0)
+  {
+    port.print(F("  ("));
+    port.print(_overwritten);
+    port.println(F(" older entries overwritten)"));
+  }
+}
+
+//Copies bytes in at _write, wrapping around the end of the buffer
+void RFID_Trace::put(const uint8_t *bytes, uint16_t length)
+{
+  uint16_t first = _size - _write;
+  if (first > length)
+    first = length;
+
+  memcpy(&_buffer[_write], bytes, first);
+  memcpy(_buffer, &bytes[first], length - first);
+  _write = (_write + length) % _size;
+}
+
+//Copies bytes out from spot, wrapping around the end of the buffer
+void RFID_Trace::copyOut(uint16_t spot, uint8_t *bytes, uint16_t length)
+{
+  uint16_t first = _size - spot;
+  if (first > length)
+    first = length;
+
+  memcpy(bytes, &_buffer[spot], first);
+  memcpy(&bytes[first], _buffer, length - first);
+}
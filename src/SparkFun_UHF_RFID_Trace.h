@@ -0,0 +1,93 @@
+/*
+  Frame trace for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  enableDebugging() prints every frame byte by byte as it goes out and comes in, which
+  takes long enough on a UART that tags get missed. RFID_Trace keeps the raw frames instead,
+  each with its micros() time stamp, in a buffer you hand it. Recording a frame is a copy
+  into the buffer and nothing else, so tracing can stay on without changing the timing.
+  Once the buffer is full the oldest frames make way for new ones.
+
+  Look at the frames later, or when something goes wrong:
+
+    uint8_t traceBuffer[2048];
+    RFID_Trace trace(traceBuffer, sizeof(traceBuffer));
+    rfidModule.enableTracing(trace);
+    ...
+    if (rfidModule.getTemperature(temperature) != RESPONSE_SUCCESS)
+    {
+      trace.freeze(); //Keep the frames that led up to it
+      trace.print(Serial);
+    }
+
+  Frames the receiver throws away (bad CRC or length) and commands that fail (time outs,
+  corrupt or wrong answers) are kept too, where they happened.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#ifndef SPARKFUN_UHF_RFID_TRACE_H
+#define SPARKFUN_UHF_RFID_TRACE_H
+
+#include "SparkFun_UHF_RFID_Reader.h"
+
+//What an entry holds
+#define RFID_TRACE_TX 0       //Command frame sent to the module
+#define RFID_TRACE_RX 1       //Frame from the module that passed its CRC
+#define RFID_TRACE_REJECTED 2 //Bytes the receiver threw away: a frame with a bad CRC or length
+#define RFID_TRACE_ERROR 3    //A command failed: [error] [bytes of the answer that had arrived]
+
+#define RFID_TRACE_HEADER 6 //Bytes each entry takes on top of its frame: type, length, time
+
+struct RFID_TraceEntry
+{
+  uint32_t time;  //micros() when it was recorded
+  uint8_t type;   //RFID_TRACE_TX, _RX, _REJECTED or _ERROR
+  uint8_t length; //Bytes recorded
+};
+
+class RFID_Trace
+{
+public:
+  //buffer holds the entries. Each takes its frame's length plus RFID_TRACE_HEADER bytes.
+  RFID_Trace(uint8_t *buffer, uint16_t size) : _buffer(buffer), _size(size) {}
+
+  //Recording, for the library. An entry is start()ed with its length, then that many bytes are add()ed.
+  void record(uint8_t type, const uint8_t *bytes, uint8_t length);
+  void start(uint8_t type, uint8_t length);
+  void add(const uint8_t *bytes, uint8_t length);
+
+  void freeze(void) { _frozen = true; }  //Stop recording, so the entries that are there stay
+  void resume(void) { _frozen = false; }
+  boolean isFrozen(void) { return (_frozen); }
+  void clear(void);
+
+  uint16_t getCount(void) { return (_count); }         //Entries held
+  uint32_t getOverwritten(void) { return (_overwritten); } //Entries pushed out to make room, or too big to keep
+
+  //Entry index, 0 = oldest. Copies up to maxBytes of it to bytes. False if there's no such entry.
+  bool getEntry(uint16_t index, RFID_TraceEntry &entry, uint8_t *bytes = NULL, uint8_t maxBytes = 0);
+
+  //  1503220us TX [FF] [00] [72] [1D] [0D]
+  //  1503944us RX [FF] [02] [72] [00] [00] [1D] [1E] [7E] [43]
+  void print(Stream &port);
+
+private:
+  void put(const uint8_t *bytes, uint16_t length);
+  void copyOut(uint16_t spot, uint8_t *bytes, uint16_t length);
+
+  uint8_t *_buffer;
+  uint16_t _size;
+  uint16_t _oldest = 0; //Where the oldest entry starts
+  uint16_t _used = 0;
+  uint16_t _write = 0;  //Where the next byte goes
+  uint16_t _count = 0;
+  uint32_t _overwritten = 0;
+  boolean _frozen = false;
+  boolean _recording = false; //Bytes add()ed belong to an entry that fit
+};
+
+#endif //SPARKFUN_UHF_RFID_TRACE_H
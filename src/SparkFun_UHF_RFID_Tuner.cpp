@@ -0,0 +1,339 @@
+/*
+  Adaptive anti-collision tuning for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  See SparkFun_UHF_RFID_Tuner.h for an overview.
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#if (ARDUINO >= 100)
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "SparkFun_UHF_RFID_Tuner.h"
+
+void RFID_Tuner::begin(const RFID_ReadConfig &config)
+{
+  _config = config;
+
+  //Start from whatever the module is running
+  RFID_Gen2Parameters parameters;
+  if (_reader.getProtocolParameters(parameters) == RESPONSE_SUCCESS)
+    _parameters = parameters;
+
+  //Response: [5] option, [6, 7] power
+  _reader.getReadPower();
+  if (_reader.msg[0] == ALL_GOOD && _reader.msg[1] >= 3)
+    _power = (int16_t)(_reader.msg[6] << 8 | _reader.msg[7]);
+
+  _trial = CHANGE_NONE;
+  _heldBack = CHANGE_NONE;
+  _heldBackWindows = 0;
+  _windowsSinceProbe = 0;
+  _changes = 0;
+  _reverts = 0;
+
+  _reader.startReading(_config);
+  startWindow();
+}
+
+void RFID_Tuner::end(void)
+{
+  _reader.stopReading();
+}
+
+void RFID_Tuner::setPowerRange(int16_t minPower, int16_t maxPower)
+{
+  if (maxPower > 2700)
+    maxPower = 2700; //Limit to 27dBm
+  _minPower = minPower;
+  _maxPower = maxPower;
+}
+
+void RFID_Tuner::feed(uint8_t responseType)
+{
+  if (responseType == RESPONSE_IS_TAGFOUND)
+  {
+    const RFID_TagRecord &tag = _reader.getTagRecord();
+    _reads++;
+    if (track(tag.epc, tag.epcLength) == true)
+      _unique++;
+  }
+  else if (responseType == RESPONSE_IS_KEEPALIVE)
+    _keepAliveCount++; //The module went a search cycle without finding a tag
+}
+
+void RFID_Tuner::update(void)
+{
+  uint32_t elapsed = millis() - _windowStart;
+  if (elapsed >= _window)
+    endWindow(elapsed);
+}
+
+void RFID_Tuner::startWindow(void)
+{
+  memset(_tracked, 0, sizeof(_tracked));
+  _trackedCount = 0;
+  _reads = 0;
+  _unique = 0;
+  _keepAliveCount = 0;
+  _windowStart = millis();
+}
+
+//Tags are told apart by a 16 bit fingerprint of their EPC in an open-addressing table.
+//Two EPCs sharing a fingerprint count as one tag, which only nudges the count down a little.
+//The table is only filled 3/4 of the way so probes stay short; after that every read of a
+//tag that isn't in it counts as unique.
+bool RFID_Tuner::track(const uint8_t *epc, uint8_t epcLength)
+{
+  uint16_t fingerprint = RFID::calculateCRC(epc, epcLength);
+  if (fingerprint == 0)
+    fingerprint = 1; //0 marks an empty slot
+
+  uint16_t spot = fingerprint % RFID_TUNER_TRACKED_TAGS;
+  for (uint16_t x = 0; x < RFID_TUNER_TRACKED_TAGS; x++)
+  {
+    if (_tracked[spot] == fingerprint)
+      return (false);
+    if (_tracked[spot] == 0)
+      break;
+    if (++spot == RFID_TUNER_TRACKED_TAGS)
+      spot = 0;
+  }
+
+  if (_trackedCount < RFID_TUNER_TRACKED_TAGS * 3 / 4 && _tracked[spot] == 0)
+  {
+    _tracked[spot] = fingerprint;
+    _trackedCount++;
+  }
+  return (true);
+}
+
+void RFID_Tuner::endWindow(uint32_t elapsed)
+{
+  _uniqueRate = _unique * 1000.0 / elapsed;
+  _repeatPercent = _reads ? (_reads - _unique) * 100 / _reads : 0;
+  _keepAlives = _keepAliveCount;
+  logWindow(elapsed);
+
+  if (_heldBackWindows > 0 && --_heldBackWindows == 0)
+    _heldBack = CHANGE_NONE;
+
+  if (_trial != CHANGE_NONE)
+  {
+    //A power probe has to earn its keep. Anything else stays unless it made things worse.
+    float needed = _baseline * (100 - RFID_TUNER_REVERT_PERCENT) / 100;
+    if (_trial == CHANGE_POWER_PROBE)
+      needed = _baseline * (100 + RFID_TUNER_REVERT_PERCENT) / 100;
+
+    if (_uniqueRate < needed)
+    {
+      bool undone = apply(_previousParameters, _previousPower);
+      logChange(F("undo, unique tags/s fell"), undone);
+      if (undone == true)
+        _reverts++;
+      _heldBack = _trial;
+      _heldBackWindows = RFID_TUNER_HOLD_OFF;
+    }
+    else
+      logChange(F("keep"));
+
+    _trial = CHANGE_NONE;
+    startWindow();
+    return;
+  }
+
+  RFID_Gen2Parameters parameters = _parameters;
+  int16_t power = _power;
+  Change change = decide(parameters, power);
+  if (change != CHANGE_NONE)
+  {
+    const __FlashStringHelper *reason;
+    switch (change)
+    {
+    case CHANGE_Q:
+      reason = F("Q sized to the population");
+      break;
+    case CHANGE_SESSION:
+      reason = (parameters.session == ThingMagic_Gen2Session_S0) ? F("session for a few tags") : F("session for a dense population");
+      break;
+    case CHANGE_POWER_UP:
+      reason = F("more power, nothing answering");
+      break;
+    default:
+      reason = F("trying more power");
+      break;
+    }
+
+    RFID_Gen2Parameters previousParameters = _parameters;
+    int16_t previousPower = _power;
+    bool applied = apply(parameters, power);
+    logChange(reason, applied);
+    if (applied == true)
+    {
+      _previousParameters = previousParameters;
+      _previousPower = previousPower;
+      _baseline = _uniqueRate;
+      _trial = change;
+      _changes++;
+    }
+    else
+    {
+      //Nothing to judge next window. Give the module a rest from asking.
+      _heldBack = change;
+      _heldBackWindows = RFID_TUNER_HOLD_OFF;
+    }
+  }
+
+  startWindow();
+}
+
+//Picks at most one change from the last window's numbers
+RFID_Tuner::Change RFID_Tuner::decide(RFID_Gen2Parameters &parameters, int16_t &power)
+{
+  boolean powerAdjustable = (_maxPower > 0 && _power + RFID_TUNER_POWER_STEP <= _maxPower);
+
+  if (_reads == 0)
+  {
+    if (powerAdjustable == false)
+      return (CHANGE_NONE);
+    power = (_power < _minPower) ? _minPower : _power + RFID_TUNER_POWER_STEP;
+    return (CHANGE_POWER_UP);
+  }
+
+  if (_heldBack != CHANGE_SESSION)
+  {
+    if (_unique <= RFID_TUNER_FEW_TAGS && parameters.session != ThingMagic_Gen2Session_S0)
+    {
+      parameters.session = ThingMagic_Gen2Session_S0;
+      parameters.target = ThingMagic_Gen2Target_A;
+      return (CHANGE_SESSION);
+    }
+    if (_unique >= RFID_TUNER_MANY_TAGS && _repeatPercent >= RFID_TUNER_REPEAT_PERCENT && parameters.session == ThingMagic_Gen2Session_S0)
+    {
+      parameters.session = ThingMagic_Gen2Session_S2;
+      parameters.target = ThingMagic_Gen2Target_AB;
+      return (CHANGE_SESSION);
+    }
+  }
+
+  if (_heldBack != CHANGE_Q)
+  {
+    //Smallest Q with at least as many slots as tags
+    uint8_t q = 0;
+    while (q < RFID_GEN2_MAX_Q && (1U << q) < _unique)
+      q++;
+
+    //One step of slack going down, so a population on the edge doesn't flip back and forth
+    if (parameters.q == RFID_GEN2_DYNAMIC_Q || q > parameters.q || q + 1 < parameters.q)
+    {
+      parameters.q = q;
+      return (CHANGE_Q);
+    }
+  }
+
+  if (powerAdjustable == true && _heldBack != CHANGE_POWER_PROBE && ++_windowsSinceProbe >= RFID_TUNER_POWER_PROBE)
+  {
+    _windowsSinceProbe = 0;
+    power = _power + RFID_TUNER_POWER_STEP;
+    return (CHANGE_POWER_PROBE);
+  }
+
+  return (CHANGE_NONE);
+}
+
+//Stops the read, sends whatever differs from what the module is running, and starts it again
+//Each setting is recorded as the module takes it, so _parameters and _power stay what it runs
+//even when it turns down part of the change. Returns false if it turned any of it down.
+bool RFID_Tuner::apply(const RFID_Gen2Parameters &parameters, int16_t power)
+{
+  _reader.stopReading();
+
+  uint8_t status = RESPONSE_SUCCESS;
+  if (parameters.session != _parameters.session)
+  {
+    status = _reader.setGen2Session(parameters.session);
+    if (status == RESPONSE_SUCCESS)
+      _parameters.session = parameters.session;
+  }
+  if (status == RESPONSE_SUCCESS && parameters.target != _parameters.target)
+  {
+    status = _reader.setGen2Target(parameters.target);
+    if (status == RESPONSE_SUCCESS)
+      _parameters.target = parameters.target;
+  }
+  if (status == RESPONSE_SUCCESS && parameters.q != _parameters.q)
+  {
+    status = _reader.setGen2Q(parameters.q);
+    if (status == RESPONSE_SUCCESS)
+      _parameters.q = parameters.q;
+  }
+  if (status == RESPONSE_SUCCESS && power != _power)
+  {
+    status = _reader.setReadPower(power);
+    if (status == RESPONSE_SUCCESS)
+      _power = power;
+  }
+
+
+  _reader.startReading(_config);
+  return (status == RESPONSE_SUCCESS);
+}
+
+//Tuner: 2000ms, 812 reads, 48 unique (24.00/s), 94% repeats, 0 empty cycles
+void RFID_Tuner::logWindow(uint32_t elapsed)
+{
+  if (_log == NULL)
+    return;
+
+  _log->print(F("Tuner: "));
+  _log->print(elapsed);
+  _log->print(F("ms, "));
+  _log->print(_reads);
+  _log->print(F(" reads, "));
+  _log->print(_unique);
+  _log->print(F(" unique ("));
+  _log->print(_uniqueRate);
+  _log->print(F("/s), "));
+  _log->print(_repeatPercent);
+  _log->print(F("% repeats, "));
+  _log->print(_keepAlives);
+  _log->println(F(" empty cycles"));
+}
+
+//Tuner: session for a dense population -> S2 AB Q6 20.00dBm
+//Logged once the module has answered, with what it now runs. A change it turned down, all or part:
+//Tuner: turned down: trying more power -> S0 A Q3 15.00dBm
+void RFID_Tuner::logChange(const __FlashStringHelper *reason, bool applied)
+{
+  if (_log == NULL)
+    return;
+
+  static const char *const targets[] = {"A", "B", "AB", "BA"};
+  const RFID_Gen2Parameters &parameters = _parameters;
+
+  _log->print(F("Tuner: "));
+  if (applied == false)
+    _log->print(F("turned down: "));
+  _log->print(reason);
+  _log->print(F(" -> S"));
+  _log->print((uint8_t)parameters.session);
+  _log->print(F(" "));
+  _log->print(targets[parameters.target & 0x03]);
+  if (parameters.q == RFID_GEN2_DYNAMIC_Q)
+    _log->print(F(" dynamic Q"));
+  else
+  {
+    _log->print(F(" Q"));
+    _log->print(parameters.q);
+  }
+  _log->print(F(" "));
+  _log->print(_power / 100.0);
+  _log->println(F("dBm"));
+}
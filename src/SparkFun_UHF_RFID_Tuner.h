@@ -0,0 +1,141 @@
+/*
+  Adaptive anti-collision tuning for the SparkFun UHF RFID library
+  By: SparkFun Electronics
+
+  Sits on top of a continuous read and tunes the Gen2 Q, session/target and read power to
+  get the most unique tags per second out of whatever is in the field. Every parseResponse()
+  result goes to feed(). Over each window (2 seconds by default) the tuner counts reads,
+  unique tags and empty keep-alives, then makes at most one change:
+
+    Q - sized to the population: 2^Q slots for about as many tags as were seen
+    Session/target - S0 target A for a few tags, S2 target AB once there are many tags and
+        most reads are repeats, so tags that have been read step aside for the rest
+    Read power - stepped up while nothing is answering, and tried one step higher now and
+        then, kept only if it brings in more tags
+
+  A change is judged over the next window. If unique tags/s fell, it is undone.
+  Settings only change with the read stopped, so each change costs a stop and restart.
+
+    RFID_Tuner tuner(rfidModule);
+    tuner.enableLogging(Serial); //Every window and every decision is printed
+    tuner.setPowerRange(1000, 2700);
+    tuner.begin();               //Starts the continuous read
+    ...
+    if (rfidModule.check() == true)
+      tuner.feed(rfidModule.parseResponse());
+    tuner.update();
+
+  License: Open Source MIT License
+  If you use this code please consider buying an awesome board from SparkFun. It's a ton of
+  work (and a ton of fun!) to put these libraries together and we want to keep making neat stuff!
+  https://opensource.org/licenses/MIT
+*/
+
+#ifndef SPARKFUN_UHF_RFID_TUNER_H
+#define SPARKFUN_UHF_RFID_TUNER_H
+
+#include "SparkFun_UHF_RFID_Reader.h"
+
+//Unique tags a window can tell apart. Each costs 2 bytes. Beyond this every read of a
+//tag not already tracked counts as unique, so keep it above the largest expected population.
+#ifndef RFID_TUNER_TRACKED_TAGS
+#if defined(__AVR__)
+#define RFID_TUNER_TRACKED_TAGS 128
+#else
+#define RFID_TUNER_TRACKED_TAGS 1024
+#endif
+#endif
+
+#define RFID_TUNER_WINDOW 2000       //ms of reads each decision is based on
+#define RFID_TUNER_FEW_TAGS 8        //At or below this many tags, S0 target A
+#define RFID_TUNER_MANY_TAGS 32      //At or above this many tags, and mostly repeats, S2 target AB
+#define RFID_TUNER_REPEAT_PERCENT 75 //Share of reads that are repeats before S2 target AB is worth it
+#define RFID_TUNER_REVERT_PERCENT 10 //A change that costs more than this share of unique tags/s is undone
+#define RFID_TUNER_POWER_STEP 100    //Read power step, 1.00 dB
+#define RFID_TUNER_POWER_PROBE 5     //Windows between tries at one more power step
+#define RFID_TUNER_HOLD_OFF 5        //Windows a change that was undone sits out before it can be tried again
+
+class RFID_Tuner
+{
+public:
+  RFID_Tuner(RFID &reader) : _reader(reader) {}
+
+  //Picks up the module's Gen2 settings and read power, then starts the continuous read with config
+  //The read must be stopped when this is called
+  void begin(const RFID_ReadConfig &config = RFID_ReadConfig());
+  void end(void); //Stops the continuous read
+
+  void feed(uint8_t responseType); //Pass every parseResponse() result
+  void update(void);               //Call every loop. Decides at the end of each window.
+
+  void setWindow(uint16_t window) { _window = window; }
+  void setPowerRange(int16_t minPower, int16_t maxPower); //Read power limits in 0.01 dBm. Power isn't touched until this is called.
+
+  void enableLogging(Print &logPort = Serial) { _log = &logPort; }
+  void disableLogging(void) { _log = NULL; }
+
+  //The last complete window
+  float getUniqueRate(void) { return (_uniqueRate); } //Unique tags/s
+  uint8_t getRepeatPercent(void) { return (_repeatPercent); }
+  uint16_t getKeepAlives(void) { return (_keepAlives); } //Search cycles that found nothing
+
+  const RFID_Gen2Parameters &getParameters(void) { return (_parameters); }
+  int16_t getReadPower(void) { return (_power); }
+  uint16_t getChanges(void) { return (_changes); }
+  uint16_t getReverts(void) { return (_reverts); }
+
+private:
+  enum Change
+  {
+    CHANGE_NONE,
+    CHANGE_Q,
+    CHANGE_SESSION,
+    CHANGE_POWER_UP,
+    CHANGE_POWER_PROBE
+  };
+
+  void startWindow(void);
+  bool track(const uint8_t *epc, uint8_t epcLength); //True the first time a tag turns up in the window
+  void endWindow(uint32_t elapsed);
+  Change decide(RFID_Gen2Parameters &parameters, int16_t &power);
+  bool apply(const RFID_Gen2Parameters &parameters, int16_t power);
+  void logWindow(uint32_t elapsed);
+  void logChange(const __FlashStringHelper *reason, bool applied = true);
+
+  RFID &_reader;
+  RFID_ReadConfig _config;
+  Print *_log = NULL;
+  uint16_t _window = RFID_TUNER_WINDOW;
+
+  RFID_Gen2Parameters _parameters; //What the module is running
+  int16_t _power = 0;
+  int16_t _minPower = 0;
+  int16_t _maxPower = 0; //0 = leave power alone
+
+  //Current window
+  uint16_t _tracked[RFID_TUNER_TRACKED_TAGS]; //EPC fingerprints, 0 = empty
+  uint16_t _trackedCount = 0;
+  uint32_t _windowStart = 0;
+  uint32_t _reads = 0;
+  uint16_t _unique = 0;
+  uint16_t _keepAliveCount = 0;
+
+  //Last window
+  float _uniqueRate = 0;
+  uint8_t _repeatPercent = 0;
+  uint16_t _keepAlives = 0;
+
+  //A change on trial, and what to go back to
+  Change _trial = CHANGE_NONE;
+  float _baseline = 0;
+  RFID_Gen2Parameters _previousParameters;
+  int16_t _previousPower = 0;
+  Change _heldBack = CHANGE_NONE; //Kind of change that was just undone, or turned down
+  uint8_t _heldBackWindows = 0;
+  uint8_t _windowsSinceProbe = 0;
+
+  uint16_t _changes = 0;
+  uint16_t _reverts = 0;
+};
+
+#endif //SPARKFUN_UHF_RFID_TUNER_H